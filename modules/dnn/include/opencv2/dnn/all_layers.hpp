@@ -340,43 +340,57 @@ namespace dnn
 
     /* Activations */
 
-    class CV_EXPORTS ReLULayer : public Layer
+    class CV_EXPORTS ActivationLayer : public Layer
+    {
+    public:
+        /** @brief Applies the activation to the part of the blob.
+         *  @param src pointer to the first element of channel @p cn0 of the input blob.
+         *  @param dst pointer to the first element of channel @p cn0 of the output blob, can be equal to @p src.
+         *  @param len number of elements to process in each channel.
+         *  @param planeSize distance between the first elements of consecutive channels.
+         *  @param cn0 the first processed channel.
+         *  @param cn1 the channel after the last processed one.
+         */
+        virtual void forwardSlice(const float* src, float* dst, int len, size_t planeSize, int cn0, int cn1) const = 0;
+    };
+
+    class CV_EXPORTS ReLULayer : public ActivationLayer
     {
     public:
         static Ptr<ReLULayer> create(const LayerParams &params);
     };
 
-    class CV_EXPORTS ChannelsPReLULayer : public Layer
+    class CV_EXPORTS ChannelsPReLULayer : public ActivationLayer
     {
     public:
         static Ptr<ChannelsPReLULayer> create(const LayerParams& params);
     };
 
-    class CV_EXPORTS TanHLayer : public Layer
+    class CV_EXPORTS TanHLayer : public ActivationLayer
     {
     public:
         static Ptr<TanHLayer> create(const LayerParams &params);
     };
 
-    class CV_EXPORTS SigmoidLayer : public Layer
+    class CV_EXPORTS SigmoidLayer : public ActivationLayer
     {
     public:
         static Ptr<SigmoidLayer> create(const LayerParams &params);
     };
 
-    class CV_EXPORTS BNLLLayer : public Layer
+    class CV_EXPORTS BNLLLayer : public ActivationLayer
     {
     public:
         static Ptr<BNLLLayer> create(const LayerParams &params);
     };
 
-    class CV_EXPORTS AbsLayer : public Layer
+    class CV_EXPORTS AbsLayer : public ActivationLayer
     {
     public:
         static Ptr<AbsLayer> create(const LayerParams &params);
     };
 
-    class CV_EXPORTS PowerLayer : public Layer
+    class CV_EXPORTS PowerLayer : public ActivationLayer
     {
     public:
         static Ptr<PowerLayer> create(const LayerParams &params);
@@ -409,6 +423,9 @@ namespace dnn
     class CV_EXPORTS BatchNormLayer : public Layer
     {
     public:
+        /** @brief Returns per-channel coefficients of the equivalent transformation `output = scale * input + shift`. */
+        virtual void getScaleShift(Mat& scale, Mat& shift) const = 0;
+
         static Ptr<BatchNormLayer> create(const LayerParams &params);
     };
 
@@ -421,6 +438,9 @@ namespace dnn
     class CV_EXPORTS ScaleLayer : public Layer
     {
     public:
+        /** @brief Returns per-channel coefficients of the equivalent transformation `output = scale * input + shift`. */
+        virtual void getScaleShift(Mat& scale, Mat& shift) const = 0;
+
         static Ptr<ScaleLayer> create(const LayerParams& params);
     };
 
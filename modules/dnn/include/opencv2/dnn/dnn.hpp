@@ -60,6 +60,10 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
      */
     CV_EXPORTS_W void initModule();
 
+    class ActivationLayer;
+    class BatchNormLayer;
+    class ScaleLayer;
+
     /** @brief This class provides all data needed to initialize layer.
      *
      * It includes dictionary with scalar params (which can be readed by using Dict interface),
@@ -127,6 +131,70 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          */
         virtual int outputNameToIndex(String outputName);
 
+        /** @brief Returns true if the layer is able to compute its outputs in place of its inputs.
+         *
+         * If this method returns true, then the layer must produce the i-th output blob with the same shape and type as the i-th input blob,
+         * and the layer must not use the output blob, which was passed to allocate() already bound to the input memory, as a separate buffer.
+         * Net uses this information to overwrite the input blobs which aren't read by other layers (see Net::enableMemoryReuse()).
+         */
+        virtual bool supportInPlace() const;
+
+        /** @brief Tries to attach to the layer the subsequent activation layer, i.e. do the layer fusion in a partial case.
+         *  @param[in] layer The subsequent activation layer.
+         *
+         * Returns true if the activation layer has been attached successfully.
+         * In this case the layer applies the activation to its outputs itself and Net skips the activation layer.
+         */
+        virtual bool setActivation(const Ptr<ActivationLayer>& layer);
+
+        /** @brief Tries to attach to the layer the subsequent batch normalization layer, i.e. do the layer fusion in a partial case.
+         *  @param[in] layer The subsequent batch normalization layer.
+         *
+         * Returns true if the batch normalization layer has been attached successfully.
+         */
+        virtual bool setBatchNorm(const Ptr<BatchNormLayer>& layer);
+
+        /** @brief Tries to attach to the layer the subsequent scaling layer, i.e. do the layer fusion in a partial case.
+         *  @param[in] layer The subsequent scaling layer.
+         *
+         * Returns true if the scaling layer has been attached successfully.
+         */
+        virtual bool setScale(const Ptr<ScaleLayer>& layer);
+
+        /** @brief Estimates number of floating point operations which forward() makes for the specified blobs.
+         *  @param[in] inputs  allocated input blobs.
+         *  @param[in] outputs allocated output blobs.
+         *
+         * Returns 0 if the layer doesn't provide the estimation.
+         */
+        virtual int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &outputs) const;
+
+        /** @brief Tries to convert the learned weights of the layer to half precision floating point numbers.
+         *
+         * Returns true if the weights have been converted. In this case the layer keeps them in CV_16S blobs (see cv::convertFp16())
+         * and expands them to single precision only for the duration of forward().
+         */
+        virtual bool convertToFp16();
+
+        /** @brief Tries to switch the layer to computations with 8-bit integers.
+         *  @param[in] inputScale quantization step of the layer input, i.e. the input values are approximated
+         *  by integer multiples of @p inputScale from range [-127*inputScale, 127*inputScale].
+         *
+         * Returns true if the layer has quantized its weights. In this case the weights are kept in CV_8S blobs
+         * with a separate quantization step for each output channel, and the layer outputs are still single precision.
+         */
+        virtual bool quantizeToInt8(float inputScale);
+
+        /** @brief Creates a copy of the layer which shares the learned weights with this layer.
+         *
+         * The copy must compute the same outputs as this layer, but it must have its own intermediate buffers,
+         * so both layers can be allocated and forwarded concurrently.
+         * Returns empty pointer if the layer state is completely defined by its parameters and #blobs,
+         * in this case the copy is created by the layer factory.
+         * @see Net::createExecutionContext()
+         */
+        virtual Ptr<Layer> clone() const;
+
         CV_PROP String name; //!< Name of the layer instance, can be used for logging or other internal purposes.
         CV_PROP String type; //!< Type name which was used for creating layer by layer factory.
 
@@ -136,6 +204,20 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         virtual ~Layer();
     };
 
+    /** @brief Performance statistics of a single layer, which are collected by Net in the profiling mode.
+     *  @see Net::enableProfiling(), Net::getPerfProfile()
+     */
+    struct CV_EXPORTS LayerProfile
+    {
+        String name;    //!< Name of the layer instance.
+        String type;    //!< Type name of the layer.
+        std::vector<std::vector<int> > inputShapes;  //!< Shapes of the layer input blobs.
+        std::vector<std::vector<int> > outputShapes; //!< Shapes of the layer output blobs.
+        int64 ticks;    //!< Duration of the last layer forward() call in ticks (see cv::getTickFrequency()), 0 for fused layers.
+        int64 flops;    //!< Estimated number of floating point operations, 0 if it is unknown (see Layer::getFLOPS()).
+        int64 bytes;    //!< Total size of the layer input, output and learned blobs in bytes.
+    };
+
     /** @brief This class allows to create and manipulate comprehensive artificial neural networks.
      *
      * Neural network is presented as directed acyclic graph (DAG), where vertices are Layer instances,
@@ -222,6 +304,87 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         /** @brief Initializes and allocates all layers. */
         CV_WRAP void allocate();
 
+        /** @brief Enables or disables sharing of memory between intermediate blobs.
+         *
+         * If this mode is enabled, then output blobs of layers, whose lifetimes during the forward pass don't overlap, share the same memory,
+         * and layers which support in-place computations (see Layer::supportInPlace()) overwrite their inputs if no other layer reads them.
+         * It significantly reduces peak memory consumption of deep networks.
+         *
+         * @note In this mode only outputs of layers which have no consumers (see getUnconnectedOutLayers()) keep valid values after forward(),
+         * other blobs returned by getBlob() can be overwritten by subsequent layers.
+         * The net is reallocated on the next forward() call after changing of this mode.
+         */
+        CV_WRAP void enableMemoryReuse(bool enable = true);
+
+        /** @brief Enables or disables layers fusion in the network.
+         *
+         * If this mode is enabled, then batch normalization, scaling and activation layers which follow
+         * a layer supporting the fusion (see Layer::setBatchNorm(), Layer::setScale(), Layer::setActivation())
+         * are merged into it during the network allocation and skipped during the forward pass.
+         * Output blobs of the merged layers contain the same values as output blob of the last merged layer,
+         * so getBlob() doesn't return intermediate results of the merged layers.
+         * The mode is disabled by default.
+         *
+         * @note Learned weights of fused layers are modified, so the fusion can't be reverted after the first allocation of the net.
+         */
+        CV_WRAP void enableFusion(bool fusion = true);
+
+        /** @brief Converts the learned weights of the layers to half precision floating point numbers.
+         *
+         * It halves memory consumed by the weights of the layers which support it (see Layer::convertToFp16()).
+         * Computations are still made in single precision.
+         * @note The conversion can't be reverted.
+         */
+        CV_WRAP void convertWeightsToFp16();
+
+        /** @brief Quantizes the learned weights of the layers to 8-bit integers and switches them to integer computations.
+         *  @param calibrationData sample inputs of the net, which are used to estimate ranges of the layers inputs.
+         *  @param inputName descriptor of the net input blob to which the samples are passed, see setBlob().
+         *
+         * The net is run on each sample and the maximal absolute value of the inputs of each layer is collected.
+         * Then the layers which support it (see Layer::quantizeToInt8()) store the weights as 8-bit integers
+         * with a separate scale for each output channel, and quantize their inputs with the collected ranges.
+         * It quarters memory consumed by the weights, but introduces approximation error,
+         * so the calibration data should be representative.
+         * @note The quantization can't be reverted.
+         */
+        CV_WRAP void quantizeWeightsToInt8(const std::vector<Mat> &calibrationData, const String &inputName = String());
+
+        /** @brief Creates a network which shares the learned weights with this network, but has its own blobs.
+         *
+         * Returned network has the same layers and connections, and its layers reference the same weights
+         * (see Layer::clone()), but all intermediate and output blobs and workspaces of the layers are separate.
+         * So several execution contexts can run forward() concurrently in different threads,
+         * while the memory consumed by weights isn't multiplied by the number of threads.
+         *
+         * If the fusion is enabled (see enableFusion()), layers are fused before the copying. The memory reuse and profiling modes are inherited.
+         * Inputs of the network have to be set for each context by setBlob().
+         * @note Methods which change the weights (setParam(), convertWeightsToFp16(), quantizeWeightsToInt8())
+         * should be called before the contexts are created, and neither the network nor its contexts must be
+         * modified while the contexts are running.
+         */
+        CV_WRAP Net createExecutionContext();
+
+        /** @brief Enables or disables measuring of layers execution time during forward().
+         *  @see getPerfProfile()
+         */
+        CV_WRAP void enableProfiling(bool enable = true);
+
+        /** @brief Returns overall time of the last forward() call and timings of the layers.
+         *  @param[out] timings duration of forward() call of each layer in ticks, in the order of getLayerNames().
+         *  @returns overall time of the last forward() call in ticks.
+         *
+         * Timings are collected only in the profiling mode, see enableProfiling().
+         * Use cv::getTickFrequency() to convert ticks to seconds.
+         */
+        CV_WRAP int64 getPerfProfile(CV_OUT std::vector<double>& timings);
+
+        /** @brief Returns detailed performance statistics of the layers collected during the last forward() call.
+         *  @param[out] profile statistics of each layer, in the order of getLayerNames().
+         *  @returns overall time of the last forward() call in ticks.
+         */
+        int64 getPerfProfile(std::vector<LayerProfile>& profile);
+
         /** @brief Runs forward pass to compute output of layer @p toLayer.
           * @details By default runs forward pass for the whole network.
           */
@@ -244,8 +407,12 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          *  @param outputName descriptor of the updating layer output blob.
          *  @param blob new blob.
          *  @see connect(String, String) to know format of the descriptor.
-         *  @note If updating blob is not empty then @p blob must have the same shape,
-         *  because network reshaping is not implemented yet.
+         *  @note If @p blob has another shape than the previous one (e.g. another batch size
+         *  or spatial size of the net input) then the network is reshaped on the next forward pass.
+         *  Only layers which depend on the changed blob are reallocated and blobs keep their
+         *  memory when they shrink, so switching between shapes doesn't cause new allocations
+         *  once the largest shape has been seen. If memory reuse is enabled (see enableMemoryReuse()),
+         *  the shared memory keeps its capacity too, but layers allocate their outputs before they are bound to it.
          */
         CV_WRAP void setBlob(String outputName, const Mat &blob);
 
@@ -296,6 +463,10 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
      *  @param prototxt   path to the .prototxt file with text description of the network architecture.
      *  @param caffeModel path to the .caffemodel file with learned network.
      *  @returns Pointer to the created importer, NULL in failure cases.
+     *
+     *  @note The .caffemodel file is memory mapped if possible, and the weights are used directly from
+     *  the mapped pages (copy-on-write), so the processes which load the same model share them.
+     *  The file must not be modified while the networks loaded from it are alive.
      */
     CV_EXPORTS_W Ptr<Importer> createCaffeImporter(const String &prototxt, const String &caffeModel = String());
 
@@ -307,6 +478,8 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
     /** @brief Creates the importer of <a href="http://www.tensorflow.org">TensorFlow</a> framework network.
      *  @param model   path to the .pb file with binary protobuf description of the network architecture.
      *  @returns Pointer to the created importer, NULL in failure cases.
+     *
+     *  @note As for createCaffeImporter(), weights which don't need reordering are used from the mapped file.
      */
     CV_EXPORTS Ptr<Importer> createTensorflowImporter(const String &model);
 
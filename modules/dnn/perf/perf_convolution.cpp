@@ -89,4 +89,115 @@ PERF_TEST_P( ConvolutionPerfTest, perf, Combine(
     SANITY_CHECK_NOTHING();
 }
 
+//Convolution implementation is selected by kernel shape: direct GEMM for 1x1, Winograd for 3x3 and im2col for others
+enum {PATH_1x1 = 1, PATH_WINOGRAD_3x3 = 3, PATH_IM2COL_5x5 = 5};
+CV_ENUM(ConvPath, PATH_1x1, PATH_WINOGRAD_3x3, PATH_IM2COL_5x5);
+
+typedef tuple<ConvPath, InpShapeNumOut> ConvPathParam; //kernel_size, inp shape
+typedef TestBaseWithParam<ConvPathParam> ConvolutionPathPerfTest;
+
+PERF_TEST_P( ConvolutionPathPerfTest, perf, Combine(
+    ConvPath::all(),
+    Values(make_pair(blobShape(1,  64, 56, 56),  64),
+           make_pair(blobShape(1, 128, 28, 28), 128),
+           make_pair(blobShape(1, 256, 14, 14), 256)))
+)
+{
+    RNG rng(0);
+
+    int ksz = get<0>(GetParam());
+    std::vector<int> inpShape = get<1>(GetParam()).first;
+    int outCn = get<1>(GetParam()).second;
+    int inpCn = inpShape[1];
+
+    int wgtSize[] = { outCn, inpCn, ksz, ksz };
+    int biasSize[] = { outCn, 1, 1, 1 };
+    Mat wgtBlob(4, wgtSize, CV_32F), biasBlob(4, biasSize, CV_32F);
+    Mat inpBlob(4, &inpShape[0], CV_32F);
+    rng.fill(biasBlob, RNG::UNIFORM, -1, +1);
+    rng.fill(wgtBlob, RNG::UNIFORM, -1, +1);
+    rng.fill(inpBlob, RNG::UNIFORM, -1, +1);
+
+    LayerParams lp;
+    lp.set("num_output", outCn);
+    lp.set("kernel_size", ksz);
+    lp.set("pad", ksz / 2);
+    lp.blobs.push_back(wgtBlob);
+    lp.blobs.push_back(biasBlob);
+
+    std::vector<Mat*> inpBlobs(1, &inpBlob);
+    std::vector<Mat> outBlobs;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+
+    Ptr<Layer> layer = cv::dnn::LayerFactory::createLayerInstance("Convolution", lp);
+    layer->allocate(inpBlobs, outBlobs);
+
+    Mat inpBlob2D = inpBlob.reshape(1, inpCn);
+    Mat outBlob2D = outBlobs[0].reshape(1, outBlobs[0].size[0]);
+    declare.in(inpBlob2D, WARMUP_RNG).out(outBlob2D).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+//Depthwise convolutions of MobileNet, each group has a single input and a single output channel
+typedef tuple<InpShapeNumOut, StrideSize> DepthwiseConvParam; //inp shape, stride
+typedef TestBaseWithParam<DepthwiseConvParam> DepthwiseConvolutionPerfTest;
+
+PERF_TEST_P( DepthwiseConvolutionPerfTest, perf, Combine(
+    Values(make_pair(blobShape(1,  32, 112, 112),  32),
+           make_pair(blobShape(1, 128,  56,  56), 128),
+           make_pair(blobShape(1, 512,  14,  14), 512)),
+    StrideSize::all())
+)
+{
+    RNG rng(0);
+
+    std::vector<int> inpShape = get<0>(GetParam()).first;
+    int outCn = get<0>(GetParam()).second;
+    int stride = get<1>(GetParam());
+    int inpCn = inpShape[1];
+
+    int wgtSize[] = { outCn, 1, 3, 3 };
+    int biasSize[] = { outCn, 1, 1, 1 };
+    Mat wgtBlob(4, wgtSize, CV_32F), biasBlob(4, biasSize, CV_32F);
+    Mat inpBlob(4, &inpShape[0], CV_32F);
+    rng.fill(biasBlob, RNG::UNIFORM, -1, +1);
+    rng.fill(wgtBlob, RNG::UNIFORM, -1, +1);
+    rng.fill(inpBlob, RNG::UNIFORM, -1, +1);
+
+    LayerParams lp;
+    lp.set("num_output", outCn);
+    lp.set("group", inpCn);
+    lp.set("stride", stride);
+    lp.set("kernel_size", 3);
+    lp.set("pad", 1);
+    lp.blobs.push_back(wgtBlob);
+    lp.blobs.push_back(biasBlob);
+
+    std::vector<Mat*> inpBlobs(1, &inpBlob);
+    std::vector<Mat> outBlobs;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+
+    Ptr<Layer> layer = cv::dnn::LayerFactory::createLayerInstance("Convolution", lp);
+    layer->allocate(inpBlobs, outBlobs);
+
+    Mat inpBlob2D = inpBlob.reshape(1, inpCn);
+    Mat outBlob2D = outBlobs[0].reshape(1, outBlobs[0].size[0]);
+    declare.in(inpBlob2D, WARMUP_RNG).out(outBlob2D).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }
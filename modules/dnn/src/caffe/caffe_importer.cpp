@@ -77,6 +77,7 @@ class CaffeImporter : public Importer
 {
     caffe::NetParameter net;
     caffe::NetParameter netBinary;
+    Ptr<MappedFile> netBinaryFile;
 
 public:
 
@@ -85,7 +86,7 @@ public:
         ReadNetParamsFromTextFileOrDie(pototxt, &net);
 
         if (caffeModel && caffeModel[0])
-            ReadNetParamsFromBinaryFileOrDie(caffeModel, &netBinary);
+            ReadNetParamsFromBinaryFileOrDie(caffeModel, &netBinary, &netBinaryFile);
     }
 
     void addParam(const Message &msg, const FieldDescriptor *field, cv::dnn::LayerParams &params)
@@ -218,14 +219,18 @@ public:
         std::vector<int> shape;
         blobShapeFromProto(pbBlob, shape);
 
-        dstBlob.create((int)shape.size(), &shape[0], CV_32F);
-        CV_Assert(pbBlob.data_size() == (int)dstBlob.total());
+        size_t total = 1;
+        for (size_t i = 0; i < shape.size(); i++)
+            total *= shape[i];
+        CV_Assert(pbBlob.data_size() == (int)total);
 
         CV_DbgAssert(pbBlob.GetDescriptor()->FindFieldByLowercaseName("data")->cpp_type() == FieldDescriptor::CPPTYPE_FLOAT);
-        float *dstData = dstBlob.ptr<float>();
-
-        for (int i = 0; i < pbBlob.data_size(); i++)
-            dstData[i] = pbBlob.data(i);
+        //packed repeated field keeps the values contiguously, as they are stored in the file,
+        //so aligned data is used from the mapped file and only unaligned is copied
+        Mat src((int)shape.size(), &shape[0], CV_32F, (void*)pbBlob.data().data());
+        dstBlob = getMappedMat(netBinaryFile, src.data, shape, CV_32F);
+        if (dstBlob.empty())
+            src.copyTo(dstBlob);
     }
 
     void extractBinaryLayerParms(const caffe::LayerParameter& layer, LayerParams& layerParams)
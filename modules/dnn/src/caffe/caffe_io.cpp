@@ -91,14 +91,31 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <opencv2/core.hpp>
 
+#include <cstring>
 #include <map>
 #include <string>
 #include <fstream>
 #include <vector>
 
+#if defined _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "caffe.pb.h"
 #include "caffe_io.hpp"
 #include "glog_emulator.hpp"
@@ -1117,19 +1134,180 @@ bool ReadProtoFromTextFile(const char* filename, Message* proto) {
     return success;
 }
 
-bool ReadProtoFromBinaryFile(const char* filename, Message* proto) {
-    std::ifstream fs(filename, std::ifstream::in | std::ifstream::binary);
-    CHECK(fs.is_open()) << "Can't open \"" << filename << "\"";
-    ZeroCopyInputStream* raw_input = new IstreamInputStream(&fs);
-    CodedInputStream* coded_input = new CodedInputStream(raw_input);
-    coded_input->SetTotalBytesLimit(kProtoReadBytesLimit, 536870912);
+MappedFile::MappedFile() : data_(0), size_(0) {
+#if defined _WIN32
+  file_ = INVALID_HANDLE_VALUE;
+  mapping_ = NULL;
+#else
+  fd_ = -1;
+#endif
+}
 
-    bool success = proto->ParseFromCodedStream(coded_input);
+// The mapping is private and writable: pages stay shared with the file until they are written.
+Ptr<MappedFile> MappedFile::open(const char* filename) {
+  Ptr<MappedFile> file(new MappedFile());
+#if defined _WIN32
+  file->file_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER size;
+  if (file->file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file->file_, &size) || size.QuadPart == 0)
+    return Ptr<MappedFile>();
+  file->mapping_ = CreateFileMappingA(file->file_, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  if (!file->mapping_)
+    return Ptr<MappedFile>();
+  file->data_ = (char*)MapViewOfFile(file->mapping_, FILE_MAP_COPY, 0, 0, 0);
+  if (!file->data_)
+    return Ptr<MappedFile>();
+  file->size_ = (size_t)size.QuadPart;
+#else
+  file->fd_ = ::open(filename, O_RDONLY);
+  struct stat st;
+  if (file->fd_ < 0 || fstat(file->fd_, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    return Ptr<MappedFile>();
+  void* data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file->fd_, 0);
+  if (data == MAP_FAILED)
+    return Ptr<MappedFile>();
+  file->data_ = (char*)data;
+  file->size_ = (size_t)st.st_size;
+#endif
+  return file;
+}
 
-    delete coded_input;
-    delete raw_input;
-    fs.close();
-    return success;
+MappedFile::~MappedFile() {
+#if defined _WIN32
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+  if (data_) munmap(data_, size_);
+  if (fd_ >= 0) close(fd_);
+#endif
+}
+
+static bool IndexFields(CodedInputStream* input, const std::vector<int>& path, size_t depth,
+                        std::multimap<size_t, size_t>* payloads) {
+  using ::google::protobuf::internal::WireFormatLite;
+  for (;;) {
+    uint32 tag = input->ReadTag();
+    if (tag == 0)
+      return true;
+    if (WireFormatLite::GetTagFieldNumber(tag) != path[depth] ||
+        WireFormatLite::GetTagWireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!WireFormatLite::SkipField(input, tag))
+        return false;
+      continue;
+    }
+
+    uint32 length;
+    if (!input->ReadVarint32(&length) || length > (uint32)kProtoReadBytesLimit)
+      return false;
+    if (depth + 1 == path.size()) {
+      payloads->insert(std::make_pair((size_t)length, (size_t)input->CurrentPosition()));
+      if (!input->Skip((int)length))
+        return false;
+    } else {
+      CodedInputStream::Limit limit = input->PushLimit((int)length);
+      if (!IndexFields(input, path, depth + 1, payloads))
+        return false;
+      input->PopLimit(limit);
+    }
+  }
+}
+
+bool MappedFile::indexFields(const std::vector<int>& path) {
+  CV_Assert(!path.empty());
+  if (size_ > (size_t)kProtoReadBytesLimit)
+    return false;
+  CodedInputStream input((const uint8*)data_, (int)size_);
+  input.SetTotalBytesLimit(kProtoReadBytesLimit, kProtoReadBytesLimit);
+  return IndexFields(&input, path, 0, &payloads_);
+}
+
+ptrdiff_t MappedFile::findPayload(const void* bytes, size_t size) const {
+  // equal payloads are interchangeable, so the parsed messages don't need to be
+  // matched with the positions of their fields in the file
+  typedef std::multimap<size_t, size_t>::const_iterator Iter;
+  std::pair<Iter, Iter> range = payloads_.equal_range(size);
+  for (Iter it = range.first; it != range.second; ++it) {
+    if (memcmp(data_ + it->second, bytes, size) == 0)
+      return (ptrdiff_t)it->second;
+  }
+  return -1;
+}
+
+// Releases the reference to the mapping held by a Mat from getMappedMat().
+class MappedFileReleaser : public MatAllocator {
+ public:
+  UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                     int flags, UMatUsageFlags usageFlags) const {
+    return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+  }
+
+  bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const {
+    return Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+  }
+
+  void deallocate(UMatData* u) const {
+    if (!u)
+      return;
+
+    CV_Assert(u->urefcount == 0 && u->refcount == 0);
+    delete (Ptr<MappedFile>*)u->userdata;
+    delete u;
+  }
+};
+
+static MappedFileReleaser mappedFileReleaser;
+
+Mat getMappedMat(const Ptr<MappedFile>& file, const void* data, const std::vector<int>& shape, int type) {
+  if (!file || !data || shape.empty())
+    return Mat();
+
+  size_t total = CV_ELEM_SIZE(type);
+  for (size_t i = 0; i < shape.size(); i++)
+    total *= shape[i];
+
+  ptrdiff_t offset = file->findPayload(data, total);
+  if (offset < 0 || (size_t)(file->data() + offset) % CV_ELEM_SIZE1(type) != 0)
+    return Mat();
+
+  char* ptr = const_cast<char*>(file->data()) + offset;
+  UMatData* u = new UMatData(&mappedFileReleaser);
+  u->data = u->origdata = (uchar*)ptr;
+  u->size = total;
+  u->userdata = new Ptr<MappedFile>(file);
+  u->refcount = 1;
+
+  Mat m((int)shape.size(), &shape[0], type, ptr);
+  m.u = u;
+  return m;
+}
+
+static bool ReadProtoFromStream(ZeroCopyInputStream* raw_input, Message* proto) {
+    CodedInputStream coded_input(raw_input);
+    coded_input.SetTotalBytesLimit(kProtoReadBytesLimit, 536870912);
+    return proto->ParseFromCodedStream(&coded_input);
+}
+
+bool ReadProtoFromBinaryFile(const char* filename, Message* proto, Ptr<MappedFile>* mapped) {
+    // Parse the mapped file in place, it avoids copying of the file through
+    // the stream buffers. Fall back to the stream for files which can't be
+    // mapped (pipes, special files) or don't fit the protobuf size limit.
+    Ptr<MappedFile> file = MappedFile::open(filename);
+    if (file && file->size() > (size_t)kProtoReadBytesLimit)
+        file.release();
+    if (mapped)
+        *mapped = file;
+
+    if (file) {
+        ArrayInputStream raw_input(file->data(), (int)file->size());
+        return ReadProtoFromStream(&raw_input, proto);
+    }
+
+    std::ifstream fs(filename, std::ifstream::in | std::ifstream::binary);
+    CHECK(fs.is_open()) << "Can't open \"" << filename << "\"";
+    IstreamInputStream raw_input(&fs);
+    return ReadProtoFromStream(&raw_input, proto);
 }
 
 void ReadNetParamsFromTextFileOrDie(const char* param_file,
@@ -1140,10 +1318,23 @@ void ReadNetParamsFromTextFileOrDie(const char* param_file,
 }
 
 void ReadNetParamsFromBinaryFileOrDie(const char* param_file,
-                                      NetParameter* param) {
-  CHECK(ReadProtoFromBinaryFile(param_file, param))
+                                      NetParameter* param,
+                                      Ptr<MappedFile>* mapped) {
+  Ptr<MappedFile> file;
+  CHECK(ReadProtoFromBinaryFile(param_file, param, &file))
       << "Failed to parse NetParameter file: " << param_file;
   UpgradeNetAsNeeded(param_file, param);
+
+  if (mapped) {
+    // packed data of the blobs of the layers, of the V1 layers and of the V0 layers
+    static const int paths[][4] = {{100, 7, 5}, {2, 6, 5}, {2, 1, 50, 5}};
+    static const int depths[] = {3, 3, 4};
+    for (int i = 0; i < 3 && file; i++) {
+      if (!file->indexFields(std::vector<int>(paths[i], paths[i] + depths[i])))
+        file.release();
+    }
+    *mapped = file;
+  }
 }
 
 }
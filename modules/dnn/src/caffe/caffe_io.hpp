@@ -91,16 +91,70 @@
 #define __OPENCV_DNN_CAFFE_IO_HPP__
 #if HAVE_PROTOBUF
 
+#include <opencv2/core.hpp>
+#include <map>
+#include <vector>
+
 #include "caffe.pb.h"
 
 namespace cv {
 namespace dnn {
 
-// Read parameters from a file into a NetParameter proto message.
+// Copy-on-write memory mapping of a binary model file. Weights which are stored in the
+// file as they are laid out in memory are used directly from the mapped pages (see
+// getMappedMat()), so processes which load the same model share the pages until a
+// layer modifies its weights. The file must not be changed while such weights are alive.
+class MappedFile {
+ public:
+  // Returns an empty Ptr if the file can't be mapped (pipes, special files).
+  static Ptr<MappedFile> open(const char* filename);
+  ~MappedFile();
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Remembers payloads of the length-delimited fields, which are found from the top-level
+  // message by the path of field numbers, e.g. {100, 7, 5} for the packed data of the blobs
+  // of the layers of a NetParameter. Returns false if the file is malformed.
+  bool indexFields(const std::vector<int>& path);
+
+  // Returns offset of an indexed payload equal to the given bytes, or -1.
+  ptrdiff_t findPayload(const void* bytes, size_t size) const;
+
+ private:
+  MappedFile();
+
+  char* data_;
+  size_t size_;
+  std::multimap<size_t, size_t> payloads_;  // size -> offset
+#if defined _WIN32
+  void* file_;
+  void* mapping_;
+#else
+  int fd_;
+#endif
+
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+};
+
+// Returns a Mat of the given shape and type on the indexed payload of the file with the same
+// bytes as @p data, the Mat keeps the mapping alive. Returns an empty Mat if there's no such
+// payload or it isn't aligned for the type: the caller copies the data then.
+Mat getMappedMat(const Ptr<MappedFile>& file, const void* data, const std::vector<int>& shape, int type);
+
+// Read a proto message from a binary file. The file is memory mapped if possible,
+// @p mapped receives the mapping or an empty Ptr if the file was read as a stream.
+bool ReadProtoFromBinaryFile(const char* filename, ::google::protobuf::Message* proto,
+                             Ptr<MappedFile>* mapped = NULL);
+
+// Read parameters from a file into a NetParameter proto message. If @p mapped isn't NULL,
+// it receives the mapping of the file with the data of the blobs indexed, or an empty Ptr.
 void ReadNetParamsFromTextFileOrDie(const char* param_file,
                                     caffe::NetParameter* param);
 void ReadNetParamsFromBinaryFileOrDie(const char* param_file,
-                                      caffe::NetParameter* param);
+                                      caffe::NetParameter* param,
+                                      Ptr<MappedFile>* mapped = NULL);
 
 }
 }
@@ -143,13 +143,217 @@ struct LayerPin
     {
         return (lid == r.lid && oid == r.oid);
     }
+
+    bool operator<(const LayerPin &r) const
+    {
+        return lid < r.lid || (lid == r.lid && oid < r.oid);
+    }
+};
+
+//shares memory between output blobs which are not alive simultaneously during the forward pass
+struct BlobManager
+{
+    std::vector<Mat> memory;        //backing buffers, never released while the net is alive
+    std::vector<int> refs;          //number of readers of the buffer which weren't allocated yet
+    std::map<LayerPin, int> readers;
+    std::map<LayerPin, int> pinToSlot;
+
+    void reset()
+    {
+        refs.assign(memory.size(), 0);
+        readers.clear();
+        pinToSlot.clear();
+    }
+
+    int getSlot(const LayerPin &pin) const
+    {
+        std::map<LayerPin, int>::const_iterator it = pinToSlot.find(pin);
+        return (it != pinToSlot.end()) ? it->second : -1;
+    }
+
+    int getReaders(const LayerPin &pin) const
+    {
+        std::map<LayerPin, int>::const_iterator it = readers.find(pin);
+        return (it != readers.end()) ? it->second : 0;
+    }
+
+    //returns the smallest free buffer which is able to hold the blob, or -1
+    int findFreeSlot(size_t bytes) const
+    {
+        int best = -1;
+        for (size_t i = 0; i < memory.size(); i++)
+        {
+            size_t capacity = memory[i].total() * memory[i].elemSize();
+            if (refs[i] == 0 && capacity >= bytes &&
+                (best < 0 || capacity < memory[best].total() * memory[best].elemSize()))
+                best = (int)i;
+        }
+        return best;
+    }
+
+    //binds output blob to the shared memory, the blob must be already allocated by its layer
+    void bindOutput(const LayerPin &pin, Mat &blob, const std::vector<Mat*> &inputs, const std::vector<LayerPin> &inputPins)
+    {
+        int nreaders = getReaders(pin);
+
+        //output is a view of some input (in-place layers, reshapes), so it prolongs input's lifetime
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            const Mat &inp = *inputs[i];
+            if (blob.data && inp.datastart && blob.data >= inp.datastart && blob.data < inp.dataend)
+            {
+                int slot = getSlot(inputPins[i]);
+                pinToSlot[pin] = slot;
+                if (slot >= 0)
+                    refs[slot] += std::max(nreaders, 1); //unconnected outputs are kept forever
+                return;
+            }
+        }
+
+        //unconnected outputs and blobs which are referenced by the layer itself aren't shared
+        if (nreaders == 0 || !blob.u || blob.u->refcount != 1 || !blob.isContinuous())
+        {
+            pinToSlot[pin] = -1;
+            return;
+        }
+
+        size_t bytes = blob.total() * blob.elemSize();
+        int slot = findFreeSlot(bytes);
+        if (slot < 0)
+        {
+            //adopt memory allocated by the layer as a new buffer
+            slot = (int)memory.size();
+            memory.push_back(blob);
+            refs.push_back(0);
+        }
+        else
+        {
+            blob = Mat(blob.dims, blob.size.p, blob.type(), memory[slot].data);
+        }
+
+        refs[slot] = nreaders;
+        pinToSlot[pin] = slot;
+    }
+
+    void releaseInput(const LayerPin &pin)
+    {
+        int slot = getSlot(pin);
+        if (slot >= 0)
+        {
+            CV_Assert(refs[slot] > 0);
+            refs[slot]--;
+        }
+    }
+
+    //checks that @p pin is read by the layer only and can be overwritten in place
+    bool isReusable(const LayerPin &pin, const std::vector<LayerPin> &layerInputs) const
+    {
+        int slot = getSlot(pin);
+        if (slot < 0)
+            return false;
+
+        int uses = 0;
+        for (size_t i = 0; i < layerInputs.size(); i++)
+            uses += (getSlot(layerInputs[i]) == slot);
+        return refs[slot] == uses;
+    }
+};
+
+//shape, type and location of the blob which the layer was allocated for
+struct BlobSignature
+{
+    BlobSignature() : type(-1), data(0) {}
+    explicit BlobSignature(const Mat &m)
+        : shape(m.size.p, m.size.p + m.dims), type(m.type()), data(m.data) {}
+
+    bool operator==(const BlobSignature &r) const
+    {
+        return shape == r.shape && type == r.type && data == r.data;
+    }
+
+    std::vector<int> shape;
+    int type;
+    const uchar *data;
+};
+
+//releases memory of the blobs created by BlobStorage
+class BlobStorageReleaser : public MatAllocator
+{
+public:
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+
+    void deallocate(UMatData* u) const
+    {
+        if (!u)
+            return;
+
+        CV_Assert(u->urefcount == 0 && u->refcount == 0);
+        delete (Mat*)u->userdata;
+        delete u;
+    }
+};
+
+static BlobStorageReleaser blobStorageReleaser;
+
+//keeps the largest memory allocated for the blob, so the blob doesn't reallocate memory when it shrinks and grows back.
+//Layers create their outputs by this allocator (see Net::Impl::allocateLayer()), each created blob references the memory.
+class BlobStorage : public MatAllocator
+{
+public:
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, UMatUsageFlags usageFlags) const
+    {
+        if (data)
+            return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--)
+        {
+            if (step)
+                step[i] = total;
+            total *= sizes[i];
+        }
+
+        if (memory.total() < total)
+        {
+            //blobs which still use the previous memory keep it alive
+            memory.release();
+            memory.create(1, (int)total, CV_8U);
+        }
+
+        UMatData* u = new UMatData(&blobStorageReleaser);
+        u->data = u->origdata = memory.data;
+        u->size = total;
+        u->userdata = new Mat(memory);
+        return u;
+    }
+
+    bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+
+    void deallocate(UMatData* u) const
+    {
+        blobStorageReleaser.deallocate(u);
+    }
+
+private:
+    mutable Mat memory;
 };
 
 struct LayerData
 {
-    LayerData() {}
+    LayerData() : skip(false), ticks(0) {}
     LayerData(int _id, const String &_name, const String &_type, LayerParams &_params)
-        : id(_id), name(_name), type(_type), params(_params)
+        : id(_id), name(_name), type(_type), params(_params), skip(false), ticks(0)
     {
         //add logging info
         params.name = name;
@@ -168,8 +372,12 @@ struct LayerData
     Ptr<Layer> layerInstance;
     std::vector<Mat> outputBlobs;
     std::vector<Mat*> inputBlobs;
+    std::vector<BlobStorage> outputStorage;  //capacity of output blobs
+    std::vector<BlobSignature> inputSignature; //inputs which the layer was allocated for
 
     int flag;
+    bool skip; //layer was fused into its producer and passes the input through
+    int64 ticks; //duration of the last forward() call, measured in the profiling mode
 
     Ptr<Layer> getLayerInstance()
     {
@@ -222,6 +430,11 @@ struct Net::Impl
 
         lastLayerId = 1;
         netWasAllocated = false;
+        inputsReshaped = false;
+        memoryReuse = false;
+        fusion = false;
+        profiling = false;
+        forwardTicks = 0;
     }
 
     Ptr<DataLayer> netInputLayer;
@@ -234,16 +447,31 @@ struct Net::Impl
     int lastLayerId;
 
     bool netWasAllocated;
+    bool inputsReshaped;
+
+    bool memoryReuse;
+    BlobManager blobManager;
+
+    bool fusion;
+
+    bool profiling;
+    int64 forwardTicks;
 
     void setUpNet()
     {
         if (!netWasAllocated)
         {
+            fuseLayers();
             allocateLayers();
             computeNetOutputLayers();
 
             netWasAllocated = true;
         }
+        else if (inputsReshaped)
+        {
+            allocateLayers(true);
+        }
+        inputsReshaped = false;
     }
 
     int getLayerId(const String &layerName)
@@ -396,10 +624,63 @@ struct Net::Impl
         #endif
     }
 
+    void fuseLayers()
+    {
+        if (!fusion)
+            return;
+
+        std::map<LayerPin, int> readers, consumers;
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            std::vector<LayerPin> &inputs = it->second.inputBlobsId;
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                readers[inputs[i]]++;
+                consumers[inputs[i]] = it->first;
+            }
+        }
+
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            if (it->first == 0 || ld.skip)
+                continue;
+
+            Ptr<Layer> layer = ld.getLayerInstance();
+            LayerData *cur = &ld;
+            for (;;)
+            {
+                //the only output of the current layer must be read by the only layer with single input
+                LayerPin pin(cur->id, 0);
+                if (cur->requiredOutputs.size() != 1 || *cur->requiredOutputs.begin() != 0 || readers[pin] != 1)
+                    break;
+
+                LayerData &next = layers[consumers[pin]];
+                if (next.skip || next.inputBlobsId.size() != 1)
+                    break;
+
+                Ptr<Layer> nextLayer = next.getLayerInstance();
+                Ptr<BatchNormLayer> bn = nextLayer.dynamicCast<BatchNormLayer>();
+                Ptr<ScaleLayer> scale = nextLayer.dynamicCast<ScaleLayer>();
+                Ptr<ActivationLayer> activ = nextLayer.dynamicCast<ActivationLayer>();
+
+                bool fused = (bn && layer->setBatchNorm(bn)) ||
+                             (scale && layer->setScale(scale)) ||
+                             (activ && layer->setActivation(activ));
+                if (!fused)
+                    break;
+
+                next.skip = true;
+                cur = &next;
+            }
+        }
+    }
+
     #define CV_RETHROW_ERROR(err, newmsg)\
         cv::error(err.code, newmsg, err.func.c_str(), err.file.c_str(), err.line)
 
-    void allocateLayer(int lid)
+    void allocateLayer(int lid, bool reshape = false)
     {
         LayerData &ld = layers[lid];
 
@@ -432,7 +713,7 @@ struct Net::Impl
 
         //allocate parents
         for (set<int>::iterator i = ld.inputLayersId.begin(); i != ld.inputLayersId.end(); i++)
-            allocateLayer(*i);
+            allocateLayer(*i, reshape);
 
         //bind inputs
         ld.inputBlobs.resize(ninputs);
@@ -444,12 +725,57 @@ struct Net::Impl
             ld.inputBlobs[i] = &layers[from.lid].outputBlobs[from.oid];
         }
 
+        //after reshaping of the net inputs only layers with changed inputs are reallocated
+        std::vector<BlobSignature> signature(ninputs);
+        for (size_t i = 0; i < ninputs; i++)
+            signature[i] = BlobSignature(*ld.inputBlobs[i]);
+        if (reshape && signature == ld.inputSignature)
+        {
+            ld.flag = 1;
+            return;
+        }
+        ld.inputSignature = signature;
+
         //allocate layer
         ld.outputBlobs.resize(std::max((size_t)1, ld.requiredOutputs.size())); //layer produce at least one output blob
         //try
+        if (!ld.skip)
         {
             Ptr<Layer> layerPtr = ld.getLayerInstance();
+
+            //let the layer overwrite inputs which aren't needed by the rest of the net
+            if (memoryReuse && layerPtr->supportInPlace())
+            {
+                for (size_t i = 0; i < ninputs && i < ld.outputBlobs.size(); i++)
+                {
+                    if (blobManager.isReusable(ld.inputBlobsId[i], ld.inputBlobsId))
+                        ld.outputBlobs[i] = *ld.inputBlobs[i];
+                }
+            }
+
+            //copies made by Split are headers over its input unless some reader overwrites them in place
+            if (layerPtr.dynamicCast<SplitLayer>() && ninputs == 1)
+            {
+                for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+                {
+                    if (!hasInPlaceReader(LayerPin(lid, (int)i)))
+                        ld.outputBlobs[i] = *ld.inputBlobs[0];
+                }
+            }
+
+            //outputs are created in the memory which they had before, unless the memory is planned by blobManager
+            if (!memoryReuse && lid != 0)
+            {
+                ld.outputStorage.resize(ld.outputBlobs.size());
+                for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+                    ld.outputBlobs[i].allocator = &ld.outputStorage[i];
+            }
+
             layerPtr->allocate(ld.inputBlobs, ld.outputBlobs);
+
+            //blobs created later, e.g. by copies of the outputs, are allocated as usual
+            for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+                ld.outputBlobs[i].allocator = 0;
 #if 0
             std::cout << "\toutputs:";
             size_t noutputs = ld.outputBlobs.size();
@@ -465,19 +791,193 @@ struct Net::Impl
             CV_RETHROW_ERROR(err, format("The following error occured while making allocate() for layer \"%s\": %s", ld.name.c_str(), err.err.c_str()));
         }*/
 
+        //fused layer passes its input through
+        if (ld.skip)
+        {
+            CV_Assert(ninputs == 1);
+            ld.outputBlobs.assign(1, *ld.inputBlobs[0]);
+        }
+
+        if (memoryReuse && lid != 0)
+        {
+            //producers of the Concat inputs write to its output in advance (see allocateConcatViews()),
+            //so the output is alive since the first producer and can't share memory with other blobs
+            bool concatViews = !ld.skip && hasConcatViews(ld);
+            for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+            {
+                LayerPin pin(lid, (int)i);
+                if (concatViews)
+                    blobManager.pinToSlot[pin] = -1;
+                else
+                    blobManager.bindOutput(pin, ld.outputBlobs[i], ld.inputBlobs, ld.inputBlobsId);
+            }
+
+            for (size_t i = 0; i < ninputs; i++)
+                blobManager.releaseInput(ld.inputBlobsId[i]);
+        }
+
         ld.flag = 1;
     }
 
-    void allocateLayers()
+    //if @p reshape is true then only layers affected by changes of the net inputs are reallocated
+    void allocateLayers(bool reshape = false)
     {
         MapIdToLayerData::iterator it;
         for (it = layers.begin(); it != layers.end(); it++)
             it->second.flag = 0;
 
+        if (memoryReuse || !blobManager.memory.empty())
+        {
+            //outputs bound to the shared memory must be planned from scratch,
+            //previous buffers are kept by blobManager as capacity
+            reshape = false;
+            for (it = layers.begin(); it != layers.end(); it++)
+            {
+                if (it->first != 0)
+                {
+                    it->second.outputBlobs.clear();
+                    it->second.outputStorage.clear();
+                }
+            }
+        }
+        if (!memoryReuse)
+            blobManager.memory.clear();
+
+        blobManager.reset();
+        if (memoryReuse)
+        {
+            //layers are allocated in the same order as they are forwarded,
+            //so blob lifetime is determined by number of its readers
+            for (it = layers.begin(); it != layers.end(); it++)
+            {
+                std::vector<LayerPin> &inputs = it->second.inputBlobsId;
+                for (size_t i = 0; i < inputs.size(); i++)
+                    blobManager.readers[inputs[i]]++;
+            }
+        }
+
         for (it = layers.begin(); it != layers.end(); it++)
         {
             int lid = it->first;
-            allocateLayer(lid);
+            allocateLayer(lid, reshape);
+        }
+
+        allocateConcatViews();
+    }
+
+    //checks that the blob doesn't share memory with any of the inputs (in-place layers, reshapes, splits)
+    static bool isOwnOutput(const Mat &blob, const std::vector<Mat*> &inputs)
+    {
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            const Mat &inp = *inputs[i];
+            if (blob.data && inp.datastart && blob.data >= inp.datastart && blob.data < inp.dataend)
+                return false;
+        }
+        return true;
+    }
+
+    //checks whether some reader of the blob may overwrite it in place
+    bool hasInPlaceReader(const LayerPin &pin)
+    {
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            std::vector<LayerPin> &inputs = it->second.inputBlobsId;
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                if (inputs[i].equal(pin) && it->second.getLayerInstance()->supportInPlace())
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    //checks whether the blob is the input of its layer: the layer is skipped after a fusion
+    //or it works in place, like an unfused activation
+    bool passesThrough(const LayerPin &pin)
+    {
+        LayerData &ld = layers[pin.lid];
+        if (ld.skip)
+            return true;
+        if (ld.id == 0 || ld.inputBlobs.size() != 1)
+            return false;
+
+        const Mat &out = ld.outputBlobs[pin.oid];
+        const Mat &inp = *ld.inputBlobs[0];
+        return out.data && out.data == inp.data && out.total() == inp.total();
+    }
+
+    //checks that the layer is a Concat whose inputs can be produced directly in its output:
+    //slices are continuous only if there is a single slice along the leading axes
+    static bool hasConcatViews(LayerData &ld)
+    {
+        Ptr<ConcatLayer> concat = ld.layerInstance.dynamicCast<ConcatLayer>();
+        if (!concat || ld.outputBlobs.size() != 1)
+            return false;
+
+        const Mat &output = ld.outputBlobs[0];
+        int axis = concat->axis < 0 ? concat->axis + output.dims : concat->axis;
+        bool continuousSlices = output.isContinuous();
+        for (int i = 0; i < axis; i++)
+            continuousSlices &= output.size[i] == 1;
+        return continuousSlices;
+    }
+
+    //lets producers of Concat inputs write directly into slices of the concatenated blob,
+    //so Concat doesn't copy anything. Consumers are visited first, therefore nested
+    //Concats end up as slices of the outermost one.
+    void allocateConcatViews()
+    {
+        std::map<LayerPin, int> readers;
+        MapIdToLayerData::reverse_iterator it;
+        for (it = layers.rbegin(); it != layers.rend(); it++)
+        {
+            std::vector<LayerPin> &inputs = it->second.inputBlobsId;
+            for (size_t i = 0; i < inputs.size(); i++)
+                readers[inputs[i]]++;
+        }
+
+        for (it = layers.rbegin(); it != layers.rend(); it++)
+        {
+            LayerData &ld = it->second;
+            if (it->first == 0 || ld.skip || !hasConcatViews(ld))
+                continue;
+
+            //the output got dedicated memory during the allocation, so its readers are bound to it already
+            Ptr<ConcatLayer> concat = ld.layerInstance.dynamicCast<ConcatLayer>();
+            Mat &output = ld.outputBlobs[0];
+            int axis = concat->axis < 0 ? concat->axis + output.dims : concat->axis;
+            CV_Assert(!memoryReuse || blobManager.getSlot(LayerPin(ld.id, 0)) < 0);
+
+            std::vector<Range> ranges(output.dims, Range::all());
+            ranges[axis].start = 0;
+            for (size_t i = 0; i < ld.inputBlobsId.size(); i++)
+            {
+                const Mat &inp = *ld.inputBlobs[i];
+                ranges[axis].end = ranges[axis].start + inp.size[axis];
+                Mat slice = output(&ranges[0]);
+                ranges[axis].start = ranges[axis].end;
+
+                //fused layers and in-place layers pass the blob of their producer through
+                std::vector<LayerPin> chain(1, ld.inputBlobsId[i]);
+                while (passesThrough(chain.back()))
+                    chain.push_back(layers[chain.back().lid].inputBlobsId[0]);
+
+                //the blob must be read by the Concat only and be written by its producer
+                bool canWriteToSlice = true;
+                for (size_t j = 0; j < chain.size(); j++)
+                    canWriteToSlice &= readers[chain[j]] == 1;
+
+                LayerData &producer = layers[chain.back().lid];
+                canWriteToSlice &= producer.id != 0 && inp.isContinuous() &&
+                                   isOwnOutput(inp, producer.inputBlobs);
+                if (!canWriteToSlice)
+                    continue;
+
+                for (size_t j = 0; j < chain.size(); j++)
+                    layers[chain[j].lid].outputBlobs[chain[j].oid] = slice;
+            }
         }
     }
 
@@ -487,7 +987,10 @@ struct Net::Impl
         {
             MapIdToLayerData::iterator it;
             for (it = layers.begin(); it != layers.end(); it++)
+            {
                 it->second.flag = 0;
+                it->second.ticks = 0;
+            }
         }
 
         //already was forwarded
@@ -502,8 +1005,12 @@ struct Net::Impl
 
         //forward itself
         //try
+        if (!ld.skip)
         {
+            int64 t = profiling ? getTickCount() : 0;
             ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+            if (profiling)
+                ld.ticks = getTickCount() - t;
         }
         /*catch (const cv::Exception &err)
         {
@@ -513,11 +1020,37 @@ struct Net::Impl
         ld.flag = 1;
     }
 
+    //forwards the whole net and collects maximal absolute values of inputs of each layer
+    void forwardCalibration(std::map<int, float> &inputRanges)
+    {
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+            it->second.flag = 0;
+
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            for (set<int>::iterator i = ld.inputLayersId.begin(); i != ld.inputLayersId.end(); i++)
+                forwardLayer(layers[*i], false);
+
+            if (!ld.flag && !ld.skip)
+            {
+                float &range = inputRanges[ld.id];
+                for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+                    range = std::max(range, (float)norm(*ld.inputBlobs[i], NORM_INF));
+            }
+            forwardLayer(ld, false);
+        }
+    }
+
     void forwardAll()
     {
         MapIdToLayerData::iterator it;
         for (it = layers.begin(); it != layers.end(); it++)
+        {
             it->second.flag = 0;
+            it->second.ticks = 0;
+        }
 
         for (it = layers.begin(); it != layers.end(); it++)
             forwardLayer(it->second, false);
@@ -581,14 +1114,198 @@ void Net::allocate()
     impl->setUpNet();
 }
 
+void Net::enableFusion(bool fusion)
+{
+    if (impl->fusion != fusion)
+    {
+        impl->fusion = fusion;
+        impl->netWasAllocated = false;
+    }
+}
+
+void Net::enableMemoryReuse(bool enable)
+{
+    if (impl->memoryReuse != enable)
+    {
+        impl->memoryReuse = enable;
+        impl->netWasAllocated = false;
+    }
+}
+
 void Net::forward(LayerId toLayer)
 {
     impl->setUpNet();
 
+    int64 t = impl->profiling ? getTickCount() : 0;
+
     if (toLayer.isString() && toLayer.get<String>().empty())
         impl->forwardAll();
     else
         impl->forwardLayer(impl->getLayerData(toLayer));
+
+    impl->forwardTicks = impl->profiling ? getTickCount() - t : 0;
+}
+
+void Net::convertWeightsToFp16()
+{
+    //fused weights are converted, so allocate the net first
+    impl->setUpNet();
+
+    bool converted = false;
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (ld.id != 0 && !ld.skip)
+            converted |= ld.layerInstance->convertToFp16();
+    }
+
+    //layers might prepare their weights for the forward pass during the allocation
+    if (converted)
+        impl->allocateLayers();
+}
+
+void Net::quantizeWeightsToInt8(const std::vector<Mat> &calibrationData, const String &inputName)
+{
+    CV_Assert(!calibrationData.empty());
+
+    std::map<int, float> inputRanges;
+    for (size_t i = 0; i < calibrationData.size(); i++)
+    {
+        setBlob(inputName, calibrationData[i]);
+        impl->setUpNet();
+        impl->forwardCalibration(inputRanges);
+    }
+
+    bool quantized = false;
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        float range = inputRanges[ld.id];
+        if (ld.id != 0 && !ld.skip && range > 0)
+            quantized |= ld.layerInstance->quantizeToInt8(range / 127);
+    }
+
+    if (quantized)
+        impl->allocateLayers();
+}
+
+Net Net::createExecutionContext()
+{
+    //weights are fused once and shared by all contexts
+    impl->fuseLayers();
+
+    Net context;
+    Impl &dst = *context.impl;
+    *dst.netInputLayer = *impl->netInputLayer;
+    dst.layerNameToId = impl->layerNameToId;
+    dst.lastLayerId = impl->lastLayerId;
+    dst.memoryReuse = impl->memoryReuse;
+    dst.profiling = impl->profiling;
+    dst.fusion = false; //layers are already fused
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &src = it->second;
+        if (src.id == 0)
+        {
+            dst.layers[0].requiredOutputs = src.requiredOutputs;
+            continue;
+        }
+
+        LayerData ld(src.id, src.name, src.type, src.params);
+        ld.inputBlobsId = src.inputBlobsId;
+        ld.inputLayersId = src.inputLayersId;
+        ld.requiredOutputs = src.requiredOutputs;
+        ld.skip = src.skip;
+
+        if (src.layerInstance)
+        {
+            ld.layerInstance = src.layerInstance->clone();
+            if (!ld.layerInstance)
+            {
+                //layer is restored from its parameters and current weights
+                ld.params.blobs = src.layerInstance->blobs;
+                ld.getLayerInstance();
+            }
+        }
+        dst.layers.insert(std::make_pair(ld.id, ld));
+    }
+
+    return context;
+}
+
+void Net::enableProfiling(bool enable)
+{
+    impl->profiling = enable;
+}
+
+static std::vector<int> blobShape(const Mat &m)
+{
+    return std::vector<int>(m.size.p, m.size.p + m.dims);
+}
+
+static int64 blobBytes(const Mat &m)
+{
+    return (int64)(m.total() * m.elemSize());
+}
+
+int64 Net::getPerfProfile(std::vector<LayerProfile>& profile)
+{
+    profile.clear();
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (ld.id == 0) //skip Data layer
+            continue;
+
+        LayerProfile p;
+        p.name = ld.name;
+        p.type = ld.type;
+        p.ticks = ld.ticks;
+        p.flops = 0;
+        p.bytes = 0;
+
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+        {
+            p.inputShapes.push_back(blobShape(*ld.inputBlobs[i]));
+            p.bytes += blobBytes(*ld.inputBlobs[i]);
+        }
+        for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+        {
+            p.outputShapes.push_back(blobShape(ld.outputBlobs[i]));
+            p.bytes += blobBytes(ld.outputBlobs[i]);
+        }
+
+        if (ld.layerInstance && !ld.skip)
+        {
+            std::vector<Mat> &layerBlobs = ld.layerInstance->blobs;
+            for (size_t i = 0; i < layerBlobs.size(); i++)
+                p.bytes += blobBytes(layerBlobs[i]);
+
+            p.flops = ld.layerInstance->getFLOPS(ld.inputBlobs, ld.outputBlobs);
+        }
+
+        profile.push_back(p);
+    }
+
+    return impl->forwardTicks;
+}
+
+int64 Net::getPerfProfile(std::vector<double>& timings)
+{
+    std::vector<LayerProfile> profile;
+    int64 total = getPerfProfile(profile);
+
+    timings.resize(profile.size());
+    for (size_t i = 0; i < profile.size(); i++)
+        timings[i] = (double)profile[i].ticks;
+
+    return total;
 }
 
 void Net::setNetInputs(const std::vector<String> &inputBlobNames)
@@ -604,7 +1321,18 @@ void Net::setBlob(String outputName, const Mat &blob_)
 
     LayerData &ld = impl->layers[pin.lid];
     ld.outputBlobs.resize( std::max(pin.oid+1, (int)ld.requiredOutputs.size()) );
-    ld.outputBlobs[pin.oid] = blob_.clone();
+    ld.outputStorage.resize(ld.outputBlobs.size());
+
+    Mat &blob = ld.outputBlobs[pin.oid];
+    if (blob.size != blob_.size || blob.type() != blob_.type())
+    {
+        //the input keeps the largest memory it had
+        blob.allocator = &ld.outputStorage[pin.oid];
+        blob.create(blob_.dims, blob_.size.p, blob_.type());
+        blob.allocator = 0;
+        impl->inputsReshaped = true;
+    }
+    blob_.copyTo(blob);
 }
 
 Mat Net::getBlob(String outputName)
@@ -741,6 +1469,46 @@ int Layer::outputNameToIndex(String)
     return -1;
 }
 
+bool Layer::supportInPlace() const
+{
+    return false;
+}
+
+Ptr<Layer> Layer::clone() const
+{
+    return Ptr<Layer>();
+}
+
+bool Layer::convertToFp16()
+{
+    return false;
+}
+
+bool Layer::quantizeToInt8(float)
+{
+    return false;
+}
+
+int64 Layer::getFLOPS(const std::vector<Mat*>&, const std::vector<Mat>&) const
+{
+    return 0;
+}
+
+bool Layer::setActivation(const Ptr<ActivationLayer>&)
+{
+    return false;
+}
+
+bool Layer::setBatchNorm(const Ptr<BatchNormLayer>&)
+{
+    return false;
+}
+
+bool Layer::setScale(const Ptr<ScaleLayer>&)
+{
+    return false;
+}
+
 template <typename T>
 static void vecToPVec(const std::vector<T> &v, std::vector<T*> &pv)
 {
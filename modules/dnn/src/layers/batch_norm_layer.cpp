@@ -29,6 +29,40 @@ public:
         epsilon = params.get<float>("eps", 1E-5);
     }
 
+    bool supportInPlace() const
+    {
+        return true;
+    }
+
+    void getScaleShift(Mat& scale, Mat& shift) const
+    {
+        int weightsBlobIndex = 2;
+        int biasBlobIndex = weightsBlobIndex + hasWeights;
+
+        float varMeanScale = 1;
+        if (!hasWeights && !hasBias) {
+            varMeanScale = *blobs[2].ptr<float>();
+            if (varMeanScale != 0)
+                varMeanScale = 1/varMeanScale;
+        }
+
+        Mat invStdMat;
+        cv::pow(blobs[1]*varMeanScale + epsilon, -0.5, invStdMat);
+
+        int n = (int)blobs[0].total();
+        scale.create(1, n, CV_32F);
+        shift.create(1, n, CV_32F);
+        for (int i = 0; i < n; i++)
+        {
+            float mean = blobs[0].at<float>(i)*varMeanScale;
+            float w = hasWeights ? blobs[weightsBlobIndex].at<float>(i) : 1;
+            float b = hasBias ? blobs[biasBlobIndex].at<float>(i) : 0;
+            float s = w*invStdMat.at<float>(i);
+            scale.at<float>(i) = s;
+            shift.at<float>(i) = b - mean*s;
+        }
+    }
+
     void allocate(const std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         CV_Assert(blobs.size() >= 2);
@@ -43,6 +77,14 @@ public:
         }
     }
 
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+            flops += 2 * (int64)inputs[i]->total();
+        return flops;
+    }
+
     void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         CV_Assert(inputs.size() == 1);
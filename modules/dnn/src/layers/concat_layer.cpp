@@ -93,7 +93,10 @@ public:
         for (size_t i = 0; i < inputs.size(); i++)
         {
             ranges[axisIdx].end = ranges[axisIdx].start + inputs[i]->size[axisIdx];
-            inputs[i]->copyTo(outMat(&ranges[0]));
+            Mat outSlice = outMat(&ranges[0]);
+            //the producer may already write its output into the slice, see Net::Impl::allocateConcatViews()
+            if (inputs[i]->data != outSlice.data)
+                inputs[i]->copyTo(outSlice);
             ranges[axisIdx].start = ranges[axisIdx].end;
         }
     }
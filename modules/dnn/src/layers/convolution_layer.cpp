@@ -43,6 +43,9 @@
 #include "layers_common.hpp"
 #include "op_im2col.hpp"
 #include "op_blas.hpp"
+#include "op_winograd.hpp"
+#include "op_quantize.hpp"
+#include "op_grouped_conv.hpp"
 #include <opencv2/dnn/shape_utils.hpp>
 #include <iostream>
 
@@ -76,9 +79,37 @@ public:
 class ConvolutionLayerImpl : public BaseConvolutionLayerImpl
 {
 public:
+    ConvolutionLayerImpl() : useWinograd(false), useGrouped(false), inputScale(0) {}
+
     virtual void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs);
     virtual void computeInpOutShape(const Mat &inpBlob);
 
+    virtual bool setActivation(const Ptr<ActivationLayer>& layer);
+    virtual bool setBatchNorm(const Ptr<BatchNormLayer>& layer);
+    virtual bool setScale(const Ptr<ScaleLayer>& layer);
+    bool fuseWeights(const Mat &w, const Mat &b);
+
+    virtual bool convertToFp16();
+    virtual bool quantizeToInt8(float inputScale);
+
+    virtual int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &outputs) const;
+
+    virtual Ptr<Layer> clone() const;
+
+    Ptr<ActivationLayer> activ;
+
+    bool useWinograd;
+    std::vector<Mat> winogradWeights; //per group
+    Mat winogradSource; //weights which winogradWeights were computed from
+
+    bool useGrouped; //direct convolution for groups with few input channels, see groupedConvolution()
+    Mat winogradInpTiles, winogradOutTiles;
+
+    //int8 mode: blobs[0] keeps quantized weights, weightsScales[i] is the quantization step of i-th kernel
+    float inputScale;
+    std::vector<float> weightsScales;
+    Mat colInt8, accInt32;
+
     void im2col(const  Mat &srcImg,  Mat &dstCol);
     void im2row(const  Mat &srcImg,  Mat &dstRow);
 };
@@ -90,6 +121,8 @@ public:
 
     virtual void computeInpOutShape(const Mat &inpBlob);
     void col2im(const  Mat &colMat, Mat  &dstImg);
+
+    virtual int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &outputs) const;
 };
 
 
@@ -146,7 +179,7 @@ void BaseConvolutionLayerImpl::allocate(const std::vector<Mat*> &inputs, std::ve
         outputs[i].create(4, sz, input.type());
     }
 
-    if (!is1x1())
+    if (!is1x1() && !colRowBlobShape.empty())
     {
         colRowBlob.create((int)colRowBlobShape.size(), &colRowBlobShape[0], input.type());
         colRowBlob.setTo(0);
@@ -157,7 +190,8 @@ bool BaseConvolutionLayerImpl::is1x1() const
 {
     return (kernel.height == 1 && kernel.width == 1) &&
            (stride.height == 1 && stride.width == 1) &&
-           (dilation.height == 1 && dilation.width == 1);
+           (dilation.height == 1 && dilation.width == 1) &&
+           (pad.height == 0 && pad.width == 0);
 }
 
 void ConvolutionLayerImpl::computeInpOutShape(const Mat &input)
@@ -190,9 +224,39 @@ void ConvolutionLayerImpl::computeInpOutShape(const Mat &input)
     inpGroupCn = inpCn / group;
     ksize = inpGroupCn * kernel.height * kernel.width;
 
+    //Winograd transforms pay off only if there are enough channels to amortize them
+    useWinograd = kernel == Size(3, 3) && stride == Size(1, 1) && dilation == Size(1, 1) &&
+                  input.type() == CV_32F && blobs[0].type() == CV_32F &&
+                  inpGroupCn >= 16 && outGroupCn >= 16;
+
+    //many tiny GEMMs of depthwise and similar convolutions are replaced by direct computations
+    useGrouped = !useWinograd && group > 1 && inpGroupCn <= 8 &&
+                 input.type() == CV_32F && blobs[0].type() == CV_32F;
+
     colRowBlobShape.clear();
-    colRowBlobShape.push_back(outH*outW);
-    colRowBlobShape.push_back(ksize);
+    if (useWinograd)
+    {
+        //transformed weights are kept between allocations and shared by clones of the layer
+        if (winogradSource.data != blobs[0].data || winogradWeights.size() != (size_t)group)
+        {
+            Mat weightsMat = blobs[0].reshape(1, outCn);
+            winogradSource = blobs[0];
+            winogradWeights.assign(group, Mat());
+            for (int g = 0; g < group; g++)
+                winogradTransformWeights(weightsMat.rowRange(g * outGroupCn, (g + 1) * outGroupCn),
+                                         outGroupCn, inpGroupCn, winogradWeights[g]);
+        }
+    }
+    else
+    {
+        winogradWeights.clear();
+        winogradSource.release();
+        if (!useGrouped)
+        {
+            colRowBlobShape.push_back(outH*outW);
+            colRowBlobShape.push_back(ksize);
+        }
+    }
 }
 
 void ConvolutionLayerImpl::forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
@@ -202,10 +266,28 @@ void ConvolutionLayerImpl::forward(std::vector<Mat*> &inputs, std::vector<Mat> &
     Mat weightsMat = blobs[0].reshape(1, outCn);
     Mat biasesMat  = bias ? blobs[1].reshape(1, outCn) : Mat();
 
+    //half precision weights are expanded only for the duration of the call
+    if (weightsMat.type() == CV_16S)
+    {
+        Mat weights32f;
+        convertFp16(weightsMat, weights32f);
+        weightsMat = weights32f;
+    }
+    bool int8 = weightsMat.type() == CV_8S;
+    CV_Assert(!int8 || inputs[0]->type() == CV_32F);
+
     for (size_t ii = 0; ii < outputs.size(); ii++)
     {
         int numImg = inputs[ii]->size[0];
         Mat inpMat = *inputs[ii];
+
+        if (useGrouped)
+        {
+            groupedConvolution(inpMat, weightsMat, bias ? biasesMat.ptr<float>() : NULL, activ.get(),
+                               outputs[ii], group, kernel, stride, pad, dilation);
+            continue;
+        }
+
         Mat outMat = outputs[ii].reshape(1, numImg*group*outGroupCn);
 
         for (int n = 0; n < numImg; n++)
@@ -214,25 +296,162 @@ void ConvolutionLayerImpl::forward(std::vector<Mat*> &inputs, std::vector<Mat> &
             {
                 Mat colMat, curInp = slice(inpMat, n, _Range(g * inpGroupCn, inpGroupCn));
 
-                im2row(curInp, colMat);
-
                 _Range kerRange(g * outGroupCn, outGroupCn);
                 Mat kerMat = weightsMat.rowRange(kerRange);
 
                 _Range outRange((g + n * group) * outGroupCn, outGroupCn);
                 Mat dstMat = outMat.rowRange(outRange);
 
-                dnn::gemm(kerMat, colMat, 1, dstMat, 0, GEMM_2_T);
+                if (useWinograd)
+                {
+                    winogradConvolution(curInp.ptr<float>(), inpGroupCn, inpH, inpW, winogradWeights[g],
+                                        bias ? biasesMat.ptr<float>(kerRange.start) : NULL,
+                                        dstMat.ptr<float>(), outGroupCn, outH, outW,
+                                        pad.height, pad.width, winogradInpTiles, winogradOutTiles);
+                }
+                else if (int8)
+                {
+                    im2row(curInp, colMat);
+                    colMat.convertTo(colInt8, CV_8S, 1. / inputScale);
+                    gemmInt8(kerMat, colInt8, accInt32);
+
+                    for (int oc = 0; oc < outGroupCn; oc++)
+                    {
+                        float scale = inputScale * weightsScales[kerRange.start + oc];
+                        float b = bias ? biasesMat.at<float>(kerRange.start + oc) : 0.f;
+                        const int *acc = accInt32.ptr<int>(oc);
+                        float *dst = dstMat.ptr<float>(oc);
+                        for (int j = 0; j < accInt32.cols; j++)
+                            dst[j] = acc[j] * scale + b;
+                    }
+                }
+                else
+                {
+                    if (is1x1())
+                    {
+                        //input planes already form the matrix of columns, so multiply them directly
+                        dnn::gemm(kerMat, curInp.reshape(1, inpGroupCn), 1, dstMat, 0);
+                    }
+                    else
+                    {
+                        im2row(curInp, colMat);
+                        dnn::gemm(kerMat, colMat, 1, dstMat, 0, GEMM_2_T);
+                    }
+
+                    if (bias)
+                    {
+                        dnn::gemm(biasesMat.rowRange(kerRange), biasOnesBlob, 1, dstMat, 1);
+                    }
+                }
 
-                if (bias)
+                if (activ)
                 {
-                    dnn::gemm(biasesMat.rowRange(kerRange), biasOnesBlob, 1, dstMat, 1);
+                    CV_Assert(dstMat.type() == CV_32F && dstMat.isContinuous());
+                    int planeSize = outH * outW;
+                    activ->forwardSlice(dstMat.ptr<float>(), dstMat.ptr<float>(), planeSize, planeSize,
+                                        kerRange.start, kerRange.end);
                 }
             }
         }
     }
 }
 
+int64 ConvolutionLayerImpl::getFLOPS(const std::vector<Mat*> &, const std::vector<Mat> &outputs) const
+{
+    //each output element is a dot product of length ksize
+    int64 flops = 0;
+    for (size_t i = 0; i < outputs.size(); i++)
+        flops += (int64)outputs[i].total() * (2 * ksize + bias + !activ.empty());
+    return flops;
+}
+
+bool ConvolutionLayerImpl::setActivation(const Ptr<ActivationLayer>& layer)
+{
+    activ = layer;
+    return !activ.empty();
+}
+
+bool ConvolutionLayerImpl::setBatchNorm(const Ptr<BatchNormLayer>& layer)
+{
+    Mat w, b;
+    layer->getScaleShift(w, b);
+    return fuseWeights(w, b);
+}
+
+bool ConvolutionLayerImpl::setScale(const Ptr<ScaleLayer>& layer)
+{
+    Mat w, b;
+    layer->getScaleShift(w, b);
+    return fuseWeights(w, b);
+}
+
+//folds per-channel transformation y = w*x + b into the convolution weights and biases
+bool ConvolutionLayerImpl::fuseWeights(const Mat &w, const Mat &b)
+{
+    int n = blobs[0].size[0];
+    if (activ || blobs[0].type() != CV_32F || w.total() != (size_t)n || b.total() != (size_t)n)
+        return false;
+
+    //weights can be shared with LayerParams, so modify their copies
+    Mat weights = blobs[0].clone();
+    Mat weightsMat = weights.reshape(1, n);
+    Mat biases = (blobs.size() >= 2) ? blobs[1].reshape(1, n).clone() : Mat::zeros(n, 1, CV_32F);
+
+    const float *wdata = w.ptr<float>(), *bdata = b.ptr<float>();
+    for (int i = 0; i < n; i++)
+    {
+        float *wrow = weightsMat.ptr<float>(i);
+        for (int j = 0; j < weightsMat.cols; j++)
+            wrow[j] *= wdata[i];
+
+        float &bi = biases.at<float>(i);
+        bi = bi*wdata[i] + bdata[i];
+    }
+
+    blobs.resize(2);
+    blobs[0] = weights;
+    blobs[1] = biases;
+    bias = true;
+    return true;
+}
+
+Ptr<Layer> ConvolutionLayerImpl::clone() const
+{
+    //learned and transformed weights are shared, intermediate buffers are not
+    Ptr<ConvolutionLayerImpl> layer(new ConvolutionLayerImpl(*this));
+    layer->colRowBlob.release();
+    layer->biasOnesBlob.release();
+    layer->winogradInpTiles.release();
+    layer->winogradOutTiles.release();
+    layer->colInt8.release();
+    layer->accInt32.release();
+    return layer;
+}
+
+bool ConvolutionLayerImpl::convertToFp16()
+{
+    if (blobs[0].type() != CV_32F)
+        return false;
+
+    Mat weights;
+    convertFp16(blobs[0].reshape(1, blobs[0].size[0]), weights);
+    blobs[0] = weights.reshape(1, blobs[0].dims, blobs[0].size.p);
+    return true;
+}
+
+bool ConvolutionLayerImpl::quantizeToInt8(float scale)
+{
+    if (blobs[0].type() != CV_32F || scale <= 0)
+        return false;
+
+    int n = blobs[0].size[0];
+    Mat weights;
+    quantizeRows(blobs[0].reshape(1, n), weights, weightsScales);
+    blobs[0] = weights.reshape(1, blobs[0].dims, blobs[0].size.p);
+    inputScale = scale;
+    return true;
+}
+
 void ConvolutionLayerImpl::im2col(const Mat &srcImg, Mat &dstCol)
 {
     if (is1x1())
@@ -340,6 +559,15 @@ void DeConvolutionLayerImpl::forward(std::vector<Mat *> &inputs, std::vector<Mat
     }
 }
 
+int64 DeConvolutionLayerImpl::getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &outputs) const
+{
+    //each input element is scattered to ksize output elements
+    int64 flops = 0;
+    for (size_t i = 0; i < outputs.size(); i++)
+        flops += (int64)inputs[i]->total() * 2 * ksize + (int64)outputs[i].total() * bias;
+    return flops;
+}
+
 void DeConvolutionLayerImpl::col2im(const Mat &colMat, Mat &dstImg)
 {
     if (is1x1())
@@ -41,8 +41,10 @@
 
 #include "../precomp.hpp"
 #include "layers_common.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <float.h>
 #include <string>
+#include <algorithm>
 #include <caffe.pb.h>
 
 namespace cv
@@ -53,27 +55,33 @@ namespace dnn
 namespace util
 {
 
-template <typename T>
-std::string to_string(T value)
+// Orders candidates by descending score. Ties are broken by the index so the
+// order is the same as the one of a stable sort and doesn't depend on the
+// selection algorithm.
+struct ScoreIndexGreater
 {
-    std::ostringstream stream;
-    stream << value;
-    return stream.str();
-}
+    bool operator()(const std::pair<float, int>& a, const std::pair<float, int>& b) const
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+};
 
-template <typename T>
-void make_error(const std::string& message1, const T& message2)
+// The same for (score, (label, index)) candidates of a single image.
+struct ScoreLabelIndexGreater
 {
-    std::string error(message1);
-    error += std::string(util::to_string<int>(message2));
-    CV_Error(Error::StsBadArg, error.c_str());
-}
+    bool operator()(const std::pair<float, std::pair<int, int> >& a,
+                    const std::pair<float, std::pair<int, int> >& b) const
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+};
 
-template <typename T>
-bool SortScorePairDescend(const std::pair<float, T>& pair1,
-                          const std::pair<float, T>& pair2)
+// Returns the area of [xmin, ymin, xmax, ymax] box or 0 if the box is invalid.
+static inline float bboxArea(const float* bbox)
 {
-    return pair1.first > pair2.first;
+    if (bbox[2] < bbox[0] || bbox[3] < bbox[1])
+        return 0.f;
+    return (bbox[2] - bbox[0]) * (bbox[3] - bbox[1]);
 }
 
 }
@@ -103,7 +111,14 @@ public:
     enum { _numAxes = 4 };
     static const std::string _layerName;
 
-    typedef std::map<int, std::vector<caffe::NormalizedBBox> > LabelBBox;
+    // Decoded boxes: _num * _numLocClasses rows of _numPriors * 4 values.
+    Mat _decodedBBoxes;
+    // Areas of decoded boxes: _num * _numLocClasses rows of _numPriors values.
+    Mat _areas;
+    // Class-major confidences: _num * _numClasses rows of _numPriors values.
+    Mat _scores;
+    // Exponent arguments of CENTER_SIZE decoding: 2 rows of _numPriors values.
+    Mat _expBuf;
 
     bool getParameterDict(const LayerParams &params,
                           const std::string &parameterName,
@@ -195,6 +210,11 @@ public:
         CV_Assert((_numPriors * _numLocClasses * 4) == inputs[0]->size[1]);
         CV_Assert(int(_numPriors * _numClasses) == inputs[1]->size[1]);
 
+        _decodedBBoxes.create(_num * _numLocClasses, _numPriors * 4, CV_32F);
+        _areas.create(_num * _numLocClasses, _numPriors, CV_32F);
+        _scores.create(_num * _numClasses, _numPriors, CV_32F);
+        _expBuf.create(2, _numPriors, CV_32F);
+
         // num() and channels() are 1.
         // Since the number of bboxes to be kept is unknown before nms, we manually
         // set it to (fake) 1.
@@ -204,112 +224,117 @@ public:
         outputs[0].create(4, outputShape, CV_32F);
     }
 
+    // Runs NMS for every pair of image and class in parallel. Every pair writes
+    // only to its own indices vector so the result doesn't depend on scheduling.
+    class NMSInvoker : public ParallelLoopBody
+    {
+    public:
+        NMSInvoker(const DetectionOutputLayerImpl& _layer,
+                   std::vector<std::vector<int> >& _indices)
+            : layer(_layer), indices(_indices) {}
+
+        void operator()(const Range &r) const
+        {
+            std::vector<std::pair<float, int> > candidates;
+            for (int i = r.start; i < r.end; i++)
+            {
+                int numClasses = layer._numClasses;
+                int n = i / numClasses, c = i % numClasses;
+                indices[i].clear();
+                if (c == layer._backgroundLabelId)
+                    continue;
+                int locRow = n * layer._numLocClasses + (layer._shareLocation ? 0 : c);
+                layer.applyNMSFast(layer._decodedBBoxes.ptr<float>(locRow),
+                                   layer._areas.ptr<float>(locRow),
+                                   layer._scores.ptr<float>(i),
+                                   candidates, indices[i]);
+            }
+        }
+
+    private:
+        const DetectionOutputLayerImpl& layer;
+        std::vector<std::vector<int> >& indices;
+    };
+
     void forward(std::vector<Mat*> &inputs,
                                        std::vector<Mat> &outputs)
     {
         const float* locationData = inputs[0]->ptr<float>();
         const float* confidenceData = inputs[1]->ptr<float>();
         const float* priorData = inputs[2]->ptr<float>();
+        // Prior boxes are the same within a batch since we assume all images
+        // in a batch are of same dimension. Variances follow the boxes.
+        const float* priorVariances = priorData + _numPriors * 4;
 
-        // Retrieve all location predictions.
-        std::vector<LabelBBox> allLocationPredictions;
-        GetLocPredictions(locationData, _num, _numPriors, _numLocClasses,
-                          _shareLocation, &allLocationPredictions);
+        if (_codeType == caffe::PriorBoxParameter_CodeType_CENTER_SIZE)
+        {
+            for (int p = 0; p < _numPriors; ++p)
+            {
+                const float* prior = priorData + p * 4;
+                CV_Assert(prior[2] - prior[0] > 0 && prior[3] - prior[1] > 0);
+            }
+        }
 
-        // Retrieve all confidences.
-        std::vector<std::map<int, std::vector<float> > > allConfidenceScores;
-        GetConfidenceScores(confidenceData, _num, _numPriors, _numClasses,
-                            &allConfidenceScores);
+        // Decode all loc predictions to bboxes.
+        for (int i = 0; i < _num; ++i)
+        {
+            const float* imageLocData = locationData + i * _numPriors * _numLocClasses * 4;
+            for (int c = 0; c < _numLocClasses; ++c)
+            {
+                if (!_shareLocation && c == _backgroundLabelId)
+                    continue;
+                int row = i * _numLocClasses + c;
+                decodeBBoxes(imageLocData + c * 4, _numLocClasses * 4, priorData, priorVariances,
+                             _decodedBBoxes.ptr<float>(row), _areas.ptr<float>(row));
+            }
 
-        // Retrieve all prior bboxes. It is same within a batch since we assume all
-        // images in a batch are of same dimension.
-        std::vector<caffe::NormalizedBBox> priorBBoxes;
-        std::vector<std::vector<float> > priorVariances;
-        GetPriorBBoxes(priorData, _numPriors, &priorBBoxes, &priorVariances);
+            // Confidences are stored prior-major, make them class-major to
+            // let NMS read the scores of a single class contiguously.
+            Mat imageScores(_numPriors, _numClasses, CV_32F,
+                            (void*)(confidenceData + i * _numPriors * _numClasses));
+            Mat classScores = _scores.rowRange(i * _numClasses, (i + 1) * _numClasses);
+            transpose(imageScores, classScores);
+        }
 
-        // Decode all loc predictions to bboxes.
-        std::vector<LabelBBox> allDecodedBBoxes;
-        DecodeBBoxesAll(allLocationPredictions, priorBBoxes, priorVariances, _num,
-                        _shareLocation, _numLocClasses, _backgroundLabelId,
-                        _codeType, _varianceEncodedInTarget, &allDecodedBBoxes);
+        std::vector<std::vector<int> > allIndices(_num * _numClasses);
+        parallel_for_(Range(0, (int)allIndices.size()), NMSInvoker(*this, allIndices));
 
         int numKept = 0;
-        std::vector<std::map<int, std::vector<int> > > allIndices;
+        std::vector<std::pair<float, std::pair<int, int> > > scoreIndexPairs;
         for (int i = 0; i < _num; ++i)
         {
-            const LabelBBox& decodeBBoxes = allDecodedBBoxes[i];
-            const std::map<int, std::vector<float> >& confidenceScores =
-            allConfidenceScores[i];
-            std::map<int, std::vector<int> > indices;
+            std::vector<int>* indices = &allIndices[i * _numClasses];
             int numDetections = 0;
             for (int c = 0; c < (int)_numClasses; ++c)
-            {
-                if (c == _backgroundLabelId)
-                {
-                    // Ignore background class.
-                    continue;
-                }
-                if (confidenceScores.find(c) == confidenceScores.end())
-                {
-                    // Something bad happened if there are no predictions for current label.
-                    util::make_error<int>("Could not find confidence predictions for label ", c);
-                }
-
-                const std::vector<float>& scores = confidenceScores.find(c)->second;
-                int label = _shareLocation ? -1 : c;
-                if (decodeBBoxes.find(label) == decodeBBoxes.end())
-                {
-                    // Something bad happened if there are no predictions for current label.
-                    util::make_error<int>("Could not find location predictions for label ", label);
-                    continue;
-                }
-                const std::vector<caffe::NormalizedBBox>& bboxes =
-                decodeBBoxes.find(label)->second;
-                ApplyNMSFast(bboxes, scores, _confidenceThreshold, _nmsThreshold,
-                             _topK, &(indices[c]));
                 numDetections += indices[c].size();
-            }
+
             if (_keepTopK > -1 && numDetections > _keepTopK)
             {
-                std::vector<std::pair<float, std::pair<int, int> > > scoreIndexPairs;
-                for (std::map<int, std::vector<int> >::iterator it = indices.begin();
-                     it != indices.end(); ++it)
+                scoreIndexPairs.clear();
+                for (int c = 0; c < (int)_numClasses; ++c)
                 {
-                    int label = it->first;
-                    const std::vector<int>& labelIndices = it->second;
-                    if (confidenceScores.find(label) == confidenceScores.end())
-                    {
-                        // Something bad happened for current label.
-                        util::make_error<int>("Could not find location predictions for label ", label);
-                        continue;
-                    }
-                    const std::vector<float>& scores = confidenceScores.find(label)->second;
-                    for (size_t j = 0; j < labelIndices.size(); ++j)
+                    const float* scores = _scores.ptr<float>(i * _numClasses + c);
+                    for (size_t j = 0; j < indices[c].size(); ++j)
                     {
-                        size_t idx = labelIndices[j];
-                        CV_Assert(idx < scores.size());
-                        scoreIndexPairs.push_back(
-                                                  std::make_pair(scores[idx], std::make_pair(label, idx)));
+                        int idx = indices[c][j];
+                        scoreIndexPairs.push_back(std::make_pair(scores[idx], std::make_pair(c, idx)));
                     }
                 }
-                // Keep outputs k results per image.
-                std::sort(scoreIndexPairs.begin(), scoreIndexPairs.end(),
-                          util::SortScorePairDescend<std::pair<int, int> >);
-                scoreIndexPairs.resize(_keepTopK);
-                // Store the new indices.
-                std::map<int, std::vector<int> > newIndices;
-                for (size_t j = 0; j < scoreIndexPairs.size(); ++j)
+                // Keep outputs k results per image. Only the selected part is sorted.
+                std::partial_sort(scoreIndexPairs.begin(), scoreIndexPairs.begin() + _keepTopK,
+                                  scoreIndexPairs.end(), util::ScoreLabelIndexGreater());
+                for (int c = 0; c < (int)_numClasses; ++c)
+                    indices[c].clear();
+                for (int j = 0; j < _keepTopK; ++j)
                 {
                     int label = scoreIndexPairs[j].second.first;
                     int idx = scoreIndexPairs[j].second.second;
-                    newIndices[label].push_back(idx);
+                    indices[label].push_back(idx);
                 }
-                allIndices.push_back(newIndices);
                 numKept += _keepTopK;
             }
             else
             {
-                allIndices.push_back(indices);
                 numKept += numDetections;
             }
         }
@@ -326,483 +351,232 @@ public:
         int count = 0;
         for (int i = 0; i < _num; ++i)
         {
-            const std::map<int, std::vector<float> >& confidenceScores =
-            allConfidenceScores[i];
-            const LabelBBox& decodeBBoxes = allDecodedBBoxes[i];
-            for (std::map<int, std::vector<int> >::iterator it = allIndices[i].begin();
-                 it != allIndices[i].end(); ++it)
+            for (int label = 0; label < (int)_numClasses; ++label)
             {
-                int label = it->first;
-                if (confidenceScores.find(label) == confidenceScores.end())
-                {
-                    // Something bad happened if there are no predictions for current label.
-                    util::make_error<int>("Could not find confidence predictions for label ", label);
-                    continue;
-                }
-                const std::vector<float>& scores = confidenceScores.find(label)->second;
-                int locLabel = _shareLocation ? -1 : label;
-                if (decodeBBoxes.find(locLabel) == decodeBBoxes.end())
-                {
-                    // Something bad happened if there are no predictions for current label.
-                    util::make_error<int>("Could not find location predictions for label ", locLabel);
-                    continue;
-                }
-                const std::vector<caffe::NormalizedBBox>& bboxes =
-                decodeBBoxes.find(locLabel)->second;
-                std::vector<int>& indices = it->second;
-
+                const std::vector<int>& indices = allIndices[i * _numClasses + label];
+                const float* scores = _scores.ptr<float>(i * _numClasses + label);
+                const float* bboxes = _decodedBBoxes.ptr<float>(i * _numLocClasses +
+                                                                 (_shareLocation ? 0 : label));
                 for (size_t j = 0; j < indices.size(); ++j)
                 {
                     int idx = indices[j];
-                    outputsData[count * 7] = i;
-                    outputsData[count * 7 + 1] = label;
-                    outputsData[count * 7 + 2] = scores[idx];
-                    caffe::NormalizedBBox clipBBox;
-                    ClipBBox(bboxes[idx], &clipBBox);
-                    outputsData[count * 7 + 3] = clipBBox.xmin();
-                    outputsData[count * 7 + 4] = clipBBox.ymin();
-                    outputsData[count * 7 + 5] = clipBBox.xmax();
-                    outputsData[count * 7 + 6] = clipBBox.ymax();
-
+                    float* dst = outputsData + count * 7;
+                    dst[0] = i;
+                    dst[1] = label;
+                    dst[2] = scores[idx];
+                    // Clip the box such that the range for each corner is [0, 1].
+                    for (int k = 0; k < 4; ++k)
+                        dst[3 + k] = std::max(std::min(bboxes[idx * 4 + k], 1.f), 0.f);
                     ++count;
                 }
             }
         }
     }
 
-    // Compute bbox size.
-    float BBoxSize(const caffe::NormalizedBBox& bbox,
-                   const bool normalized=true)
+    // Decode a set of bboxes according to a set of prior bboxes.
+    //    loc: location predictions of the first prior, the next one is locStep floats further.
+    //    priors: [xmin, ymin, xmax, ymax] of every prior.
+    //    variances: 4 variances of every prior.
+    //    bboxes: decoded [xmin, ymin, xmax, ymax] boxes.
+    //    areas: areas of decoded boxes (0 for invalid boxes).
+    void decodeBBoxes(const float* loc, int locStep, const float* priors,
+                      const float* variances, float* bboxes, float* areas)
     {
-        if (bbox.xmax() < bbox.xmin() || bbox.ymax() < bbox.ymin())
-        {
-            // If bbox is invalid (e.g. xmax < xmin or ymax < ymin), return 0.
-            return 0;
-        }
-        else
+        const bool center = _codeType == caffe::PriorBoxParameter_CodeType_CENTER_SIZE;
+        if (!center && _codeType != caffe::PriorBoxParameter_CodeType_CORNER)
+            CV_Error(Error::StsBadArg, "Unknown LocLossType.");
+        // If variance is encoded in target, we simply need to add (or restore)
+        // the offset predictions. Otherwise scale the offsets accordingly.
+        const bool useVariance = !_varianceEncodedInTarget;
+        const int numPriors = _numPriors;
+        float* expArgW = _expBuf.ptr<float>(0);
+        float* expArgH = _expBuf.ptr<float>(1);
+
+        int p = 0;
+#if CV_SIMD128
+        v_float32x4 half = v_setall_f32(0.5f), zero = v_setzero_f32();
+        for (; p + 4 <= numPriors; p += 4)
         {
-            if (bbox.has_size())
+            v_float32x4 l0, l1, l2, l3, p0, p1, p2, p3;
+            v_float32x4 var0 = v_setall_f32(1.f), var1 = var0, var2 = var0, var3 = var0;
+            v_transpose4x4(v_load(loc + p * locStep), v_load(loc + (p + 1) * locStep),
+                           v_load(loc + (p + 2) * locStep), v_load(loc + (p + 3) * locStep),
+                           l0, l1, l2, l3);
+            v_transpose4x4(v_load(priors + p * 4), v_load(priors + p * 4 + 4),
+                           v_load(priors + p * 4 + 8), v_load(priors + p * 4 + 12),
+                           p0, p1, p2, p3);
+            if (useVariance)
             {
-                return bbox.size();
+                v_transpose4x4(v_load(variances + p * 4), v_load(variances + p * 4 + 4),
+                               v_load(variances + p * 4 + 8), v_load(variances + p * 4 + 12),
+                               var0, var1, var2, var3);
             }
-            else
-            {
-                float width = bbox.xmax() - bbox.xmin();
-                float height = bbox.ymax() - bbox.ymin();
-                if (normalized)
-                {
-                    return width * height;
-                }
-                else
-                {
-                    // If bbox is not within range [0, 1].
-                    return (width + 1) * (height + 1);
-                }
-            }
-        }
-    }
 
-    // Clip the caffe::NormalizedBBox such that the range for each corner is [0, 1].
-    void ClipBBox(const caffe::NormalizedBBox& bbox,
-                  caffe::NormalizedBBox* clipBBox)
-    {
-        clipBBox->set_xmin(std::max(std::min(bbox.xmin(), 1.f), 0.f));
-        clipBBox->set_ymin(std::max(std::min(bbox.ymin(), 1.f), 0.f));
-        clipBBox->set_xmax(std::max(std::min(bbox.xmax(), 1.f), 0.f));
-        clipBBox->set_ymax(std::max(std::min(bbox.ymax(), 1.f), 0.f));
-        clipBBox->clear_size();
-        clipBBox->set_size(BBoxSize(*clipBBox));
-        clipBBox->set_difficult(bbox.difficult());
-    }
-
-    // Decode a bbox according to a prior bbox.
-    void DecodeBBox(const caffe::NormalizedBBox& priorBBox, const std::vector<float>& priorVariance,
-                    const CodeType codeType, const bool varianceEncodedInTarget,
-                    const caffe::NormalizedBBox& bbox, caffe::NormalizedBBox* decodeBBox)
-    {
-        if (codeType == caffe::PriorBoxParameter_CodeType_CORNER)
-        {
-            if (varianceEncodedInTarget)
+            v_float32x4 b0, b1, b2, b3;
+            if (center)
             {
-                // variance is encoded in target, we simply need to add the offset
-                // predictions.
-                decodeBBox->set_xmin(priorBBox.xmin() + bbox.xmin());
-                decodeBBox->set_ymin(priorBBox.ymin() + bbox.ymin());
-                decodeBBox->set_xmax(priorBBox.xmax() + bbox.xmax());
-                decodeBBox->set_ymax(priorBBox.ymax() + bbox.ymax());
+                // Keep the center and prior size, exponents are computed at once below.
+                v_float32x4 pw = p2 - p0, ph = p3 - p1;
+                b0 = var0 * l0 * pw + (p0 + p2) * half;
+                b1 = var1 * l1 * ph + (p1 + p3) * half;
+                b2 = pw;
+                b3 = ph;
+                v_store(expArgW + p, var2 * l2);
+                v_store(expArgH + p, var3 * l3);
             }
             else
             {
-                // variance is encoded in bbox, we need to scale the offset accordingly.
-                decodeBBox->set_xmin(
-                                     priorBBox.xmin() + priorVariance[0] * bbox.xmin());
-                decodeBBox->set_ymin(
-                                     priorBBox.ymin() + priorVariance[1] * bbox.ymin());
-                decodeBBox->set_xmax(
-                                     priorBBox.xmax() + priorVariance[2] * bbox.xmax());
-                decodeBBox->set_ymax(
-                                     priorBBox.ymax() + priorVariance[3] * bbox.ymax());
+                b0 = p0 + var0 * l0;
+                b1 = p1 + var1 * l1;
+                b2 = p2 + var2 * l2;
+                b3 = p3 + var3 * l3;
+                v_float32x4 w = b2 - b0, h = b3 - b1;
+                v_store(areas + p, v_select((w >= zero) & (h >= zero), w * h, zero));
             }
+            v_transpose4x4(b0, b1, b2, b3, l0, l1, l2, l3);
+            v_store(bboxes + p * 4, l0);
+            v_store(bboxes + p * 4 + 4, l1);
+            v_store(bboxes + p * 4 + 8, l2);
+            v_store(bboxes + p * 4 + 12, l3);
         }
-        else if (codeType == caffe::PriorBoxParameter_CodeType_CENTER_SIZE)
+#endif
+        for (; p < numPriors; ++p)
         {
-            float priorWidth = priorBBox.xmax() - priorBBox.xmin();
-            CV_Assert(priorWidth > 0);
-
-            float priorHeight = priorBBox.ymax() - priorBBox.ymin();
-            CV_Assert(priorHeight > 0);
-
-            float priorCenterX = (priorBBox.xmin() + priorBBox.xmax()) / 2.;
-            float priorCenterY = (priorBBox.ymin() + priorBBox.ymax()) / 2.;
-
-            float decodeBBoxCenterX, decodeBBoxCenterY;
-            float decodeBBoxWidth, decodeBBoxHeight;
-            if (varianceEncodedInTarget)
+            const float* l = loc + p * locStep;
+            const float* prior = priors + p * 4;
+            float var[] = {1.f, 1.f, 1.f, 1.f};
+            if (useVariance)
+                std::copy(variances + p * 4, variances + p * 4 + 4, var);
+            float* bbox = bboxes + p * 4;
+            if (center)
             {
-                // variance is encoded in target, we simply need to retore the offset
-                // predictions.
-                decodeBBoxCenterX = bbox.xmin() * priorWidth + priorCenterX;
-                decodeBBoxCenterY = bbox.ymin() * priorHeight + priorCenterY;
-                decodeBBoxWidth = exp(bbox.xmax()) * priorWidth;
-                decodeBBoxHeight = exp(bbox.ymax()) * priorHeight;
+                float pw = prior[2] - prior[0], ph = prior[3] - prior[1];
+                bbox[0] = var[0] * l[0] * pw + (prior[0] + prior[2]) * 0.5f;
+                bbox[1] = var[1] * l[1] * ph + (prior[1] + prior[3]) * 0.5f;
+                bbox[2] = pw;
+                bbox[3] = ph;
+                expArgW[p] = var[2] * l[2];
+                expArgH[p] = var[3] * l[3];
             }
             else
             {
-                // variance is encoded in bbox, we need to scale the offset accordingly.
-                decodeBBoxCenterX =
-                priorVariance[0] * bbox.xmin() * priorWidth + priorCenterX;
-                decodeBBoxCenterY =
-                priorVariance[1] * bbox.ymin() * priorHeight + priorCenterY;
-                decodeBBoxWidth =
-                exp(priorVariance[2] * bbox.xmax()) * priorWidth;
-                decodeBBoxHeight =
-                exp(priorVariance[3] * bbox.ymax()) * priorHeight;
+                for (int k = 0; k < 4; ++k)
+                    bbox[k] = prior[k] + var[k] * l[k];
+                areas[p] = util::bboxArea(bbox);
             }
-
-            decodeBBox->set_xmin(decodeBBoxCenterX - decodeBBoxWidth / 2.);
-            decodeBBox->set_ymin(decodeBBoxCenterY - decodeBBoxHeight / 2.);
-            decodeBBox->set_xmax(decodeBBoxCenterX + decodeBBoxWidth / 2.);
-            decodeBBox->set_ymax(decodeBBoxCenterY + decodeBBoxHeight / 2.);
         }
-        else
-        {
-            CV_Error(Error::StsBadArg, "Unknown LocLossType.");
-        }
-        float bboxSize = BBoxSize(*decodeBBox);
-        decodeBBox->set_size(bboxSize);
-    }
 
-    // Decode a set of bboxes according to a set of prior bboxes.
-    void DecodeBBoxes(const std::vector<caffe::NormalizedBBox>& priorBBoxes,
-                      const std::vector<std::vector<float> >& priorVariances,
-                      const CodeType codeType, const bool varianceEncodedInTarget,
-                      const std::vector<caffe::NormalizedBBox>& bboxes,
-                      std::vector<caffe::NormalizedBBox>* decodeBBoxes)
-    {
-        CV_Assert(priorBBoxes.size() == priorVariances.size());
-        CV_Assert(priorBBoxes.size() == bboxes.size());
-        int numBBoxes = priorBBoxes.size();
-        if (numBBoxes >= 1)
-        {
-            CV_Assert(priorVariances[0].size() == 4);
-        }
-        decodeBBoxes->clear();
-        for (int i = 0; i < numBBoxes; ++i)
-        {
-            caffe::NormalizedBBox decodeBBox;
-            DecodeBBox(priorBBoxes[i], priorVariances[i], codeType,
-                       varianceEncodedInTarget, bboxes[i], &decodeBBox);
-            decodeBBoxes->push_back(decodeBBox);
-        }
-    }
-
-    // Decode all bboxes in a batch.
-    void DecodeBBoxesAll(const std::vector<LabelBBox>& allLocPreds,
-                         const std::vector<caffe::NormalizedBBox>& priorBBoxes,
-                         const std::vector<std::vector<float> >& priorVariances,
-                         const size_t num, const bool shareLocation,
-                         const int numLocClasses, const int backgroundLabelId,
-                         const CodeType codeType, const bool varianceEncodedInTarget,
-                         std::vector<LabelBBox>* allDecodeBBoxes)
-    {
-        CV_Assert(allLocPreds.size() == num);
-        allDecodeBBoxes->clear();
-        allDecodeBBoxes->resize(num);
-        for (size_t i = 0; i < num; ++i)
-        {
-            // Decode predictions into bboxes.
-            LabelBBox& decodeBBoxes = (*allDecodeBBoxes)[i];
-            for (int c = 0; c < numLocClasses; ++c)
-            {
-                int label = shareLocation ? -1 : c;
-                if (label == backgroundLabelId)
-                {
-                    // Ignore background class.
-                    continue;
-                }
-                if (allLocPreds[i].find(label) == allLocPreds[i].end())
-                {
-                    // Something bad happened if there are no predictions for current label.
-                    util::make_error<int>("Could not find location predictions for label ", label);
-                }
-                const std::vector<caffe::NormalizedBBox>& labelLocPreds =
-                allLocPreds[i].find(label)->second;
-                DecodeBBoxes(priorBBoxes, priorVariances,
-                             codeType, varianceEncodedInTarget,
-                             labelLocPreds, &(decodeBBoxes[label]));
-            }
-        }
-    }
-
-    // Get prior bounding boxes from prior_data.
-    //    prior_data: 1 x 2 x num_priors * 4 x 1 blob.
-    //    num_priors: number of priors.
-    //    prior_bboxes: stores all the prior bboxes in the format of caffe::NormalizedBBox.
-    //    prior_variances: stores all the variances needed by prior bboxes.
-    void GetPriorBBoxes(const float* priorData, const int& numPriors,
-                        std::vector<caffe::NormalizedBBox>* priorBBoxes,
-                        std::vector<std::vector<float> >* priorVariances)
-    {
-        priorBBoxes->clear();
-        priorVariances->clear();
-        for (int i = 0; i < numPriors; ++i)
-        {
-            int startIdx = i * 4;
-            caffe::NormalizedBBox bbox;
-            bbox.set_xmin(priorData[startIdx]);
-            bbox.set_ymin(priorData[startIdx + 1]);
-            bbox.set_xmax(priorData[startIdx + 2]);
-            bbox.set_ymax(priorData[startIdx + 3]);
-            float bboxSize = BBoxSize(bbox);
-            bbox.set_size(bboxSize);
-            priorBBoxes->push_back(bbox);
-        }
-
-        for (int i = 0; i < numPriors; ++i)
-        {
-            int startIdx = (numPriors + i) * 4;
-            std::vector<float> var;
-            for (int j = 0; j < 4; ++j)
-            {
-                var.push_back(priorData[startIdx + j]);
-            }
-            priorVariances->push_back(var);
-        }
-    }
-
-    // Scale the caffe::NormalizedBBox w.r.t. height and width.
-    void ScaleBBox(const caffe::NormalizedBBox& bbox,
-                   const int height, const int width,
-                   caffe::NormalizedBBox* scaleBBox)
-    {
-        scaleBBox->set_xmin(bbox.xmin() * width);
-        scaleBBox->set_ymin(bbox.ymin() * height);
-        scaleBBox->set_xmax(bbox.xmax() * width);
-        scaleBBox->set_ymax(bbox.ymax() * height);
-        scaleBBox->clear_size();
-        bool normalized = !(width > 1 || height > 1);
-        scaleBBox->set_size(BBoxSize(*scaleBBox, normalized));
-        scaleBBox->set_difficult(bbox.difficult());
-    }
+        if (!center)
+            return;
 
-    // Get location predictions from loc_data.
-    //    loc_data: num x num_preds_per_class * num_loc_classes * 4 blob.
-    //    num: the number of images.
-    //    num_preds_per_class: number of predictions per class.
-    //    num_loc_classes: number of location classes. It is 1 if share_location is
-    //      true; and is equal to number of classes needed to predict otherwise.
-    //    share_location: if true, all classes share the same location prediction.
-    //    loc_preds: stores the location prediction, where each item contains
-    //      location prediction for an image.
-    void GetLocPredictions(const float* locData, const int num,
-                           const int numPredsPerClass, const int numLocClasses,
-                           const bool shareLocation, std::vector<LabelBBox>* locPreds)
-    {
-        locPreds->clear();
-        if (shareLocation)
+        cv::exp(_expBuf, _expBuf);
+        p = 0;
+#if CV_SIMD128
+        for (; p + 4 <= numPriors; p += 4)
         {
-            CV_Assert(numLocClasses == 1);
+            v_float32x4 cx, cy, pw, ph;
+            v_transpose4x4(v_load(bboxes + p * 4), v_load(bboxes + p * 4 + 4),
+                           v_load(bboxes + p * 4 + 8), v_load(bboxes + p * 4 + 12),
+                           cx, cy, pw, ph);
+            v_float32x4 w = v_load(expArgW + p) * pw, h = v_load(expArgH + p) * ph;
+            v_float32x4 b0 = cx - w * half, b1 = cy - h * half;
+            v_float32x4 b2 = cx + w * half, b3 = cy + h * half;
+            w = b2 - b0;
+            h = b3 - b1;
+            v_store(areas + p, v_select((w >= zero) & (h >= zero), w * h, zero));
+            v_transpose4x4(b0, b1, b2, b3, cx, cy, pw, ph);
+            v_store(bboxes + p * 4, cx);
+            v_store(bboxes + p * 4 + 4, cy);
+            v_store(bboxes + p * 4 + 8, pw);
+            v_store(bboxes + p * 4 + 12, ph);
         }
-        locPreds->resize(num);
-        for (int i = 0; i < num; ++i)
+#endif
+        for (; p < numPriors; ++p)
         {
-            LabelBBox& labelBBox = (*locPreds)[i];
-            for (int p = 0; p < numPredsPerClass; ++p)
-            {
-                int startIdx = p * numLocClasses * 4;
-                for (int c = 0; c < numLocClasses; ++c)
-                {
-                    int label = shareLocation ? -1 : c;
-                    if (labelBBox.find(label) == labelBBox.end())
-                    {
-                        labelBBox[label].resize(numPredsPerClass);
-                    }
-                    labelBBox[label][p].set_xmin(locData[startIdx + c * 4]);
-                    labelBBox[label][p].set_ymin(locData[startIdx + c * 4 + 1]);
-                    labelBBox[label][p].set_xmax(locData[startIdx + c * 4 + 2]);
-                    labelBBox[label][p].set_ymax(locData[startIdx + c * 4 + 3]);
-                }
-            }
-            locData += numPredsPerClass * numLocClasses * 4;
-        }
-    }
-
-    // Get confidence predictions from conf_data.
-    //    conf_data: num x num_preds_per_class * num_classes blob.
-    //    num: the number of images.
-    //    num_preds_per_class: number of predictions per class.
-    //    num_classes: number of classes.
-    //    conf_preds: stores the confidence prediction, where each item contains
-    //      confidence prediction for an image.
-    void GetConfidenceScores(const float* confData, const int num,
-                             const int numPredsPerClass, const int numClasses,
-                             std::vector<std::map<int, std::vector<float> > >* confPreds)
-    {
-        confPreds->clear();
-        confPreds->resize(num);
-        for (int i = 0; i < num; ++i)
-        {
-            std::map<int, std::vector<float> >& labelScores = (*confPreds)[i];
-            for (int p = 0; p < numPredsPerClass; ++p)
-            {
-                int startIdx = p * numClasses;
-                for (int c = 0; c < numClasses; ++c)
-                {
-                    labelScores[c].push_back(confData[startIdx + c]);
-                }
-            }
-            confData += numPredsPerClass * numClasses;
+            float* bbox = bboxes + p * 4;
+            float w = expArgW[p] * bbox[2], h = expArgH[p] * bbox[3];
+            float cx = bbox[0], cy = bbox[1];
+            bbox[0] = cx - w * 0.5f;
+            bbox[1] = cy - h * 0.5f;
+            bbox[2] = cx + w * 0.5f;
+            bbox[3] = cy + h * 0.5f;
+            areas[p] = util::bboxArea(bbox);
         }
     }
 
     // Do non maximum suppression given bboxes and scores.
     // Inspired by Piotr Dollar's NMS implementation in EdgeBox.
     // https://goo.gl/jV3JYS
-    //    bboxes: a set of bounding boxes.
+    //    bboxes: decoded [xmin, ymin, xmax, ymax] boxes.
+    //    areas: areas of the boxes.
     //    scores: a set of corresponding confidences.
-    //    score_threshold: a threshold used to filter detection results.
-    //    nms_threshold: a threshold used in non maximum suppression.
-    //    top_k: if not -1, keep at most top_k picked indices.
+    //    candidates: a buffer for (score, index) pairs.
     //    indices: the kept indices of bboxes after nms.
-    void ApplyNMSFast(const std::vector<caffe::NormalizedBBox>& bboxes,
-                      const std::vector<float>& scores,
-                      const float score_threshold,
-                      const float nms_threshold, const int top_k,
-                      std::vector<int>* indices)
+    void applyNMSFast(const float* bboxes, const float* areas, const float* scores,
+                      std::vector<std::pair<float, int> >& candidates,
+                      std::vector<int>& indices) const
     {
-        // Sanity check.
-        CV_Assert(bboxes.size() == scores.size());
-
-        // Get top_k scores (with corresponding indices).
-        std::vector<std::pair<float, int> > score_index_vec;
-        GetMaxScoreIndex(scores, score_threshold, top_k, &score_index_vec);
+        getMaxScoreIndex(scores, candidates);
 
         // Do nms.
-        indices->clear();
-        while (score_index_vec.size() != 0)
+        for (size_t i = 0; i < candidates.size(); ++i)
         {
-            const int idx = score_index_vec.front().second;
+            const int idx = candidates[i].second;
+            const float* bbox = bboxes + idx * 4;
             bool keep = true;
-            for (size_t k = 0; k < indices->size(); ++k)
+            for (size_t k = 0; k < indices.size() && keep; ++k)
             {
-                if (keep)
-                {
-                    const int kept_idx = (*indices)[k];
-                    float overlap = JaccardOverlap(bboxes[idx], bboxes[kept_idx]);
-                    keep = overlap <= nms_threshold;
-                }
-                else
-                {
-                    break;
-                }
+                const int keptIdx = indices[k];
+                keep = jaccardOverlap(bbox, areas[idx], bboxes + keptIdx * 4,
+                                      areas[keptIdx]) <= _nmsThreshold;
             }
             if (keep)
-            {
-                indices->push_back(idx);
-            }
-            score_index_vec.erase(score_index_vec.begin());
+                indices.push_back(idx);
         }
     }
 
     // Get max scores with corresponding indices.
-    //    scores: a set of scores.
-    //    threshold: only consider scores higher than the threshold.
-    //    top_k: if -1, keep all; otherwise, keep at most top_k.
-    //    score_index_vec: store the sorted (score, index) pair.
-    void GetMaxScoreIndex(const std::vector<float>& scores, const float threshold,const int top_k,
-                          std::vector<std::pair<float, int> >* score_index_vec)
+    //    scores: a set of scores, only ones higher than the confidence threshold are considered.
+    //    scoreIndexVec: stores at most top_k (score, index) pairs sorted in descending order.
+    void getMaxScoreIndex(const float* scores, std::vector<std::pair<float, int> >& scoreIndexVec) const
     {
-        // Generate index score pairs.
-        for (size_t i = 0; i < scores.size(); ++i)
-        {
-            if (scores[i] > threshold)
-            {
-                score_index_vec->push_back(std::make_pair(scores[i], i));
-            }
-        }
-
-        // Sort the score pair according to the scores in descending order
-        std::stable_sort(score_index_vec->begin(), score_index_vec->end(),
-                         util::SortScorePairDescend<int>);
-
-        // Keep top_k scores if needed.
-        if (top_k > -1 && top_k < (int)score_index_vec->size())
+        scoreIndexVec.clear();
+        for (int i = 0; i < _numPriors; ++i)
         {
-            score_index_vec->resize(top_k);
+            if (scores[i] > _confidenceThreshold)
+                scoreIndexVec.push_back(std::make_pair(scores[i], i));
         }
-    }
 
-    // Compute the intersection between two bboxes.
-    void IntersectBBox(const caffe::NormalizedBBox& bbox1,
-                       const caffe::NormalizedBBox& bbox2,
-                       caffe::NormalizedBBox* intersect_bbox) {
-        if (bbox2.xmin() > bbox1.xmax() || bbox2.xmax() < bbox1.xmin() ||
-            bbox2.ymin() > bbox1.ymax() || bbox2.ymax() < bbox1.ymin())
+        // Only the top_k candidates are needed, so there is no point to sort all of them.
+        if (_topK > -1 && _topK < (int)scoreIndexVec.size())
         {
-            // Return [0, 0, 0, 0] if there is no intersection.
-            intersect_bbox->set_xmin(0);
-            intersect_bbox->set_ymin(0);
-            intersect_bbox->set_xmax(0);
-            intersect_bbox->set_ymax(0);
+            std::partial_sort(scoreIndexVec.begin(), scoreIndexVec.begin() + _topK,
+                              scoreIndexVec.end(), util::ScoreIndexGreater());
+            scoreIndexVec.resize(_topK);
         }
         else
         {
-            intersect_bbox->set_xmin(std::max(bbox1.xmin(), bbox2.xmin()));
-            intersect_bbox->set_ymin(std::max(bbox1.ymin(), bbox2.ymin()));
-            intersect_bbox->set_xmax(std::min(bbox1.xmax(), bbox2.xmax()));
-            intersect_bbox->set_ymax(std::min(bbox1.ymax(), bbox2.ymax()));
+            std::sort(scoreIndexVec.begin(), scoreIndexVec.end(), util::ScoreIndexGreater());
         }
     }
 
     // Compute the jaccard (intersection over union IoU) overlap between two bboxes.
-    float JaccardOverlap(const caffe::NormalizedBBox& bbox1,
-                         const caffe::NormalizedBBox& bbox2,
-                         const bool normalized=true)
+    static inline float jaccardOverlap(const float* bbox1, float area1,
+                                       const float* bbox2, float area2)
     {
-        caffe::NormalizedBBox intersect_bbox;
-        IntersectBBox(bbox1, bbox2, &intersect_bbox);
-        float intersect_width, intersect_height;
-        if (normalized)
+        if (bbox2[0] > bbox1[2] || bbox2[2] < bbox1[0] ||
+            bbox2[1] > bbox1[3] || bbox2[3] < bbox1[1])
         {
-            intersect_width = intersect_bbox.xmax() - intersect_bbox.xmin();
-            intersect_height = intersect_bbox.ymax() - intersect_bbox.ymin();
+            return 0.f;
         }
-        else
-        {
-            intersect_width = intersect_bbox.xmax() - intersect_bbox.xmin() + 1;
-            intersect_height = intersect_bbox.ymax() - intersect_bbox.ymin() + 1;
-        }
-        if (intersect_width > 0 && intersect_height > 0)
-        {
-            float intersect_size = intersect_width * intersect_height;
-            float bbox1_size = BBoxSize(bbox1);
-            float bbox2_size = BBoxSize(bbox2);
-            return intersect_size / (bbox1_size + bbox2_size - intersect_size);
-        }
-        else
+        float intersectWidth = std::min(bbox1[2], bbox2[2]) - std::max(bbox1[0], bbox2[0]);
+        float intersectHeight = std::min(bbox1[3], bbox2[3]) - std::max(bbox1[1], bbox2[1]);
+        if (intersectWidth > 0 && intersectHeight > 0)
         {
-            return 0.;
+            float intersectSize = intersectWidth * intersectHeight;
+            return intersectSize / (area1 + area2 - intersectSize);
         }
+        return 0.f;
     }
 };
 
@@ -39,6 +39,28 @@ public:
 
     ElementWiseLayer(const Func &f=Func()) : func(f) {}
 
+    bool supportInPlace() const
+    {
+        return true;
+    }
+
+    void forwardSlice(const float* src, float* dst, int len, size_t planeSize, int cn0, int cn1) const
+    {
+        for (int cn = cn0; cn < cn1; cn++, src += planeSize, dst += planeSize)
+        {
+            for (int i = 0; i < len; i++)
+                dst[i] = func(src[i]);
+        }
+    }
+
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+            flops += (int64)inputs[i]->total();
+        return flops;
+    }
+
     void allocate(const std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         outputs.resize(inputs.size());
@@ -151,6 +173,16 @@ public:
 
     ////////////////////////////////////////////////////////////////////////////
 
+    void forwardSlice(const float* src, float* dst, int len, size_t planeSize, int cn0, int cn1) const
+    {
+        for (int cn = cn0; cn < cn1; cn++, src += planeSize, dst += planeSize)
+        {
+            float slope = blobs[0].at<float>(cn);
+            for (int i = 0; i < len; i++)
+                dst[i] = src[i] >= 0.f ? src[i] : slope*src[i];
+        }
+    }
+
     void allocate(const std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         CV_Assert(blobs.size() == 1);
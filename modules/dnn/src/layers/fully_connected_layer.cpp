@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "op_blas.hpp"
+#include "op_quantize.hpp"
 #include <opencv2/dnn/shape_utils.hpp>
 
 namespace cv
@@ -52,7 +53,7 @@ namespace dnn
 class FullyConnectedLayerImpl : public InnerProductLayer
 {
 public:
-    FullyConnectedLayerImpl(const LayerParams& params)
+    FullyConnectedLayerImpl(const LayerParams& params) : inputScale(0)
     {
         setParamsFrom(params);
         CV_Assert(1 <= blobs.size() && blobs.size() <= 2);
@@ -102,7 +103,7 @@ public:
 
     void forward(std::vector<Mat*> &input, std::vector<Mat> &output)
     {
-        const Mat &weight = blobs[0];
+        Mat weight = blobs[0];
         const Mat *biasMat = NULL, *biasOnesMat = NULL;
         if (bias)
         {
@@ -110,6 +111,19 @@ public:
             biasMat = &blobs[1];
         }
 
+        //half precision weights are expanded only for the duration of the call
+        if (weight.type() == CV_16S)
+        {
+            Mat weight32f;
+            convertFp16(weight, weight32f);
+            weight = weight32f;
+        }
+        else if (weight.type() == CV_8S)
+        {
+            forwardInt8(input, output);
+            return;
+        }
+
         for (size_t i = 0; i < input.size(); i++)
         {
             Mat srcMat = input[i]->reshape(1, outerSize);
@@ -121,10 +135,75 @@ public:
         }
     }
 
+    void forwardInt8(std::vector<Mat*> &input, std::vector<Mat> &output)
+    {
+        CV_Assert(dtype == CV_32F);
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            Mat srcMat = input[i]->reshape(1, outerSize);
+            Mat dstMat = output[i].reshape(1, outerSize);
+
+            srcMat.convertTo(srcInt8, CV_8S, 1. / inputScale);
+            gemmInt8(srcInt8, blobs[0], accInt32);
+
+            const float *biasData = bias ? blobs[1].ptr<float>() : NULL;
+            for (int m = 0; m < outerSize; m++)
+            {
+                const int *acc = accInt32.ptr<int>(m);
+                float *dst = dstMat.ptr<float>(m);
+                for (int n = 0; n < numOutput; n++)
+                    dst[n] = acc[n] * inputScale * weightsScales[n] + (biasData ? biasData[n] : 0.f);
+            }
+        }
+    }
+
+    Ptr<Layer> clone() const
+    {
+        //weights are shared, intermediate buffers are not
+        Ptr<FullyConnectedLayerImpl> layer(new FullyConnectedLayerImpl(*this));
+        layer->biasOnesBlob.release();
+        layer->srcInt8.release();
+        layer->accInt32.release();
+        return layer;
+    }
+
+    bool convertToFp16()
+    {
+        if (blobs[0].type() != CV_32F)
+            return false;
+
+        Mat weight;
+        convertFp16(blobs[0], weight);
+        blobs[0] = weight;
+        return true;
+    }
+
+    bool quantizeToInt8(float scale)
+    {
+        if (blobs[0].type() != CV_32F || scale <= 0)
+            return false;
+
+        Mat weight;
+        quantizeRows(blobs[0], weight, weightsScales);
+        blobs[0] = weight;
+        inputScale = scale;
+        return true;
+    }
+
+    int64 getFLOPS(const std::vector<Mat*> &input, const std::vector<Mat> &) const
+    {
+        return (int64)input.size() * outerSize * numOutput * (2 * innerSize + bias);
+    }
+
     int axisCan, dtype;
     int numOutput, innerSize, outerSize;
     bool bias;
     Mat biasOnesBlob;
+
+    //int8 mode: blobs[0] keeps quantized weights, weightsScales[i] is the quantization step of i-th row
+    float inputScale;
+    std::vector<float> weightsScales;
+    Mat srcInt8, accInt32;
 };
 
 Ptr<InnerProductLayer> InnerProductLayer::create(const LayerParams& params)
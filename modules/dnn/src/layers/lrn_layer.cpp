@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <opencv2/dnn/shape_utils.hpp>
 #include <algorithm>
 
@@ -89,6 +90,13 @@ public:
         outputs[0].create(inp0.dims, inp0.size.p, inp0.type());
     }
 
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
+    {
+        //sum of squares over the local region, scaling and power per element
+        int regionSize = (type == CHANNEL_NRM) ? size : size * size;
+        return (int64)inputs[0]->total() * (2 * regionSize + 3);
+    }
+
     void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         Mat &src = *inputs[0];
@@ -108,76 +116,138 @@ public:
         }
     }
 
-    void channelNormalization(Mat &srcBlob, Mat &dstBlob)
+    class ChannelLRNInvoker : public ParallelLoopBody
     {
-        int num = srcBlob.size[0];
-        int channels = srcBlob.size[1];
-        int ksize = (size - 1) / 2;
-        int sizeNormFactor = normBySize ? size : 1;
+    public:
+        enum { BLOCK_SIZE = 1024 };
 
-        Mat srcMat = srcBlob.clone();
-        Mat dstMat = dstBlob;
+        ChannelLRNInvoker(const LRNLayerImpl &_layer, const Mat &_src, Mat &_dst)
+            : layer(_layer), src(_src), dst(_dst)
+        {
+            planeSize = (int)src.total(2);
+            blocks = (planeSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        }
 
-        for (int n = 0; n < num; n++)
+        //each stripe slides the window along channels for a block of pixels of a single image
+        void operator()(const Range &r) const
         {
-            Mat accum = getPlane(dstMat, n, channels-1); //trick for memory saving
-            accum.setTo(0);
+            int channels = src.size[1];
+            int ksize = (layer.size - 1) / 2;
+            float scale = (float)(layer.alpha / (layer.normBySize ? layer.size : 1));
+            float bias = (float)layer.bias;
 
-            for (int cn = 0; cn < std::min(ksize, channels); cn++)
-                cv::accumulateSquare(getPlane(srcMat, n, cn), accum);
+            AutoBuffer<float> accumBuf(BLOCK_SIZE);
+            float *accum = accumBuf;
 
-            for (int cn = 0; cn < channels; cn++)
+            for (int stripe = r.start; stripe < r.end; stripe++)
             {
-                if (cn + ksize < channels)
-                {
-                    cv::accumulateSquare(getPlane(srcMat, n, cn + ksize), accum);
-                }
+                int n = stripe / blocks;
+                int i0 = (stripe % blocks) * BLOCK_SIZE, len = std::min((int)BLOCK_SIZE, planeSize - i0);
+                const float *srcImg = src.ptr<float>(n) + i0;
+                float *dstImg = dst.ptr<float>(n) + i0;
 
-                if (cn - ksize - 1 >= 0)
+                memset(accum, 0, len * sizeof(float));
+                for (int cn = 0; cn < std::min(ksize, channels); cn++)
+                    addSquares(srcImg + (size_t)cn * planeSize, accum, len, 1.f);
+
+                for (int cn = 0; cn < channels; cn++)
                 {
-                    //subtractSquare
-                    Mat left = getPlane(srcMat, n, cn - ksize - 1);
-                    cv::pow(left, 2, left);
-                    cv::subtract(accum, left, accum);
+                    if (cn + ksize < channels)
+                        addSquares(srcImg + (size_t)(cn + ksize) * planeSize, accum, len, 1.f);
+
+                    if (cn - ksize - 1 >= 0)
+                        addSquares(srcImg + (size_t)(cn - ksize - 1) * planeSize, accum, len, -1.f);
+
+                    //dst = src * (bias + scale * accum)^(-beta)
+                    const float *srcRow = srcImg + (size_t)cn * planeSize;
+                    float *dstRow = dstImg + (size_t)cn * planeSize;
+                    int i = 0;
+#if CV_SIMD128
+                    v_float32x4 vscale = v_setall_f32(scale), vbias = v_setall_f32(bias);
+                    for (; i <= len - 4; i += 4)
+                        v_store(dstRow + i, v_load(accum + i) * vscale + vbias);
+#endif
+                    for (; i < len; i++)
+                        dstRow[i] = accum[i] * scale + bias;
+
+                    Mat dstMat(1, len, CV_32F, dstRow);
+                    cv::pow(dstMat, -layer.beta, dstMat);
+                    cv::multiply(dstMat, Mat(1, len, CV_32F, (void*)srcRow), dstMat);
                 }
+            }
+        }
 
-                Mat dst = getPlane(dstMat, n, cn);
-                accum.convertTo(dst, dst.type(), alpha/sizeNormFactor, bias);
-                cv::pow(dst, beta, dst);
-                cv::divide(getPlane(srcMat, n, cn), dst, dst);
+        static void addSquares(const float *src, float *accum, int len, float sign)
+        {
+            int i = 0;
+#if CV_SIMD128
+            v_float32x4 vsign = v_setall_f32(sign);
+            for (; i <= len - 4; i += 4)
+            {
+                v_float32x4 v = v_load(src + i);
+                v_store(accum + i, v_load(accum + i) + v * v * vsign);
             }
+#endif
+            for (; i < len; i++)
+                accum[i] += src[i] * src[i] * sign;
         }
+
+        int planeSize, blocks;
+
+    private:
+        const LRNLayerImpl &layer;
+        const Mat &src;
+        Mat &dst;
+    };
+
+    void channelNormalization(Mat &srcBlob, Mat &dstBlob)
+    {
+        CV_Assert(srcBlob.type() == CV_32F && srcBlob.isContinuous() && dstBlob.isContinuous());
+
+        ChannelLRNInvoker invoker(*this, srcBlob, dstBlob);
+        parallel_for_(Range(0, srcBlob.size[0] * invoker.blocks), invoker);
     }
 
-    void sqrBoxFilter_(const Mat &src, Mat &dst)
+    void sqrBoxFilter_(const Mat &src, Mat &dst) const
     {
         Mat srcRawWrapper(src.rows, src.cols, src.type(), src.data, src.step[0]);
         cv::sqrBoxFilter(srcRawWrapper, dst, dst.depth(), Size(size, size), Point(-1, -1), false, BORDER_CONSTANT);
     }
 
-    void spatialNormalization(Mat &srcBlob, Mat &dstBlob)
+    class SpatialLRNInvoker : public ParallelLoopBody
     {
-        int num = srcBlob.size[0];
-        int channels = srcBlob.size[1];
-        int sizeNormFactor = normBySize ? size*size : 1;
-
-        Mat srcMat = srcBlob;
-        Mat dstMat = dstBlob;
+    public:
+        SpatialLRNInvoker(const LRNLayerImpl &_layer, const Mat &_src, Mat &_dst)
+            : layer(_layer), src(_src), dst(_dst) {}
 
-        for (int n = 0; n < num; n++)
+        void operator()(const Range &r) const
         {
-            for (int cn = 0; cn < channels; cn++)
+            int channels = src.size[1];
+            int sizeNormFactor = layer.normBySize ? layer.size * layer.size : 1;
+
+            for (int i = r.start; i < r.end; i++)
             {
-                Mat src = getPlane(srcMat, n, cn);
-                Mat dst = getPlane(dstMat, n, cn);
+                int n = i / channels, cn = i % channels;
+                Mat srcPlane = getPlane(src, n, cn);
+                Mat dstPlane = getPlane(dst, n, cn);
 
-                sqrBoxFilter_(src, dst);
+                layer.sqrBoxFilter_(srcPlane, dstPlane);
 
-                dst.convertTo(dst, dst.type(), alpha/sizeNormFactor, bias);
-                cv::pow(dst, beta, dst);
-                cv::divide(src, dst, dst);
+                dstPlane.convertTo(dstPlane, dstPlane.type(), layer.alpha/sizeNormFactor, layer.bias);
+                cv::pow(dstPlane, layer.beta, dstPlane);
+                cv::divide(srcPlane, dstPlane, dstPlane);
             }
         }
+
+    private:
+        const LRNLayerImpl &layer;
+        const Mat &src;
+        Mat &dst;
+    };
+
+    void spatialNormalization(Mat &srcBlob, Mat &dstBlob)
+    {
+        parallel_for_(Range(0, srcBlob.size[0] * srcBlob.size[1]), SpatialLRNInvoker(*this, srcBlob, dstBlob));
     }
 
     Mat buf;
@@ -4,6 +4,7 @@
 #include "opencv_lapack.h"
 #endif
 
+#include <opencv2/core/hal/intrin.hpp>
 #include <iostream>
 
 namespace cv
@@ -29,73 +30,198 @@ inline void SwapRowCols(const Mat &A, int &rows, int &cols, bool isTrans)
 }
 
 
-class GEMMInvoker : public ParallelLoopBody
+#ifndef HAVE_LAPACK
+enum { GEMM_MR = 4, GEMM_NR = 8, GEMM_MC = 64, GEMM_NC = 128, GEMM_KC = 256 };
+
+//packs rows [m0, m0 + mc) and columns [k0, k0 + kc) of op(A) into GEMM_MR-row panels: pa[k*GEMM_MR + i]
+static void packA(const float* a, size_t lda, bool transA, int m0, int mc, int k0, int kc, float* pa)
+{
+    for (int i = 0; i < mc; i += GEMM_MR)
+    {
+        int mr = std::min((int)GEMM_MR, mc - i);
+        for (int k = 0; k < kc; k++, pa += GEMM_MR)
+        {
+            int ii = 0;
+            if (transA)
+            {
+                const float* aptr = a + (size_t)(k0 + k)*lda + m0 + i;
+                for (; ii < mr; ii++)
+                    pa[ii] = aptr[ii];
+            }
+            else
+            {
+                const float* aptr = a + (size_t)(m0 + i)*lda + k0 + k;
+                for (; ii < mr; ii++)
+                    pa[ii] = aptr[ii*lda];
+            }
+            for (; ii < GEMM_MR; ii++)
+                pa[ii] = 0.f;
+        }
+    }
+}
+
+//packs rows [k0, k0 + kc) and columns [n0, n0 + nc) of op(B) into GEMM_NR-column panels: pb[k*GEMM_NR + j]
+static void packB(const float* b, size_t ldb, bool transB, int k0, int kc, int n0, int nc, float* pb)
+{
+    for (int j = 0; j < nc; j += GEMM_NR)
+    {
+        int nr = std::min((int)GEMM_NR, nc - j);
+        for (int k = 0; k < kc; k++, pb += GEMM_NR)
+        {
+            int jj = 0;
+            if (transB)
+            {
+                const float* bptr = b + (size_t)(n0 + j)*ldb + k0 + k;
+                for (; jj < nr; jj++)
+                    pb[jj] = bptr[jj*ldb];
+            }
+            else
+            {
+                const float* bptr = b + (size_t)(k0 + k)*ldb + n0 + j;
+                for (; jj < nr; jj++)
+                    pb[jj] = bptr[jj];
+            }
+            for (; jj < GEMM_NR; jj++)
+                pb[jj] = 0.f;
+        }
+    }
+}
+
+//c[mr x nr] += alpha * pa[GEMM_MR x kc] * pb[kc x GEMM_NR]
+static void gemmMicroKernel(int kc, const float* pa, const float* pb, float alpha,
+                            float* c, size_t ldc, int mr, int nr)
+{
+    float CV_DECL_ALIGNED(16) acc[GEMM_MR*GEMM_NR];
+
+#if CV_SIMD128
+    v_float32x4 c00 = v_setzero_f32(), c01 = v_setzero_f32();
+    v_float32x4 c10 = v_setzero_f32(), c11 = v_setzero_f32();
+    v_float32x4 c20 = v_setzero_f32(), c21 = v_setzero_f32();
+    v_float32x4 c30 = v_setzero_f32(), c31 = v_setzero_f32();
+
+    for (int k = 0; k < kc; k++, pa += GEMM_MR, pb += GEMM_NR)
+    {
+        v_float32x4 b0 = v_load(pb), b1 = v_load(pb + 4);
+        v_float32x4 a0 = v_setall_f32(pa[0]), a1 = v_setall_f32(pa[1]);
+        c00 += a0*b0; c01 += a0*b1;
+        c10 += a1*b0; c11 += a1*b1;
+        a0 = v_setall_f32(pa[2]); a1 = v_setall_f32(pa[3]);
+        c20 += a0*b0; c21 += a0*b1;
+        c30 += a1*b0; c31 += a1*b1;
+    }
+
+    v_float32x4 valpha = v_setall_f32(alpha);
+    if (mr == GEMM_MR && nr == GEMM_NR)
+    {
+        v_store(c, v_load(c) + c00*valpha); v_store(c + 4, v_load(c + 4) + c01*valpha); c += ldc;
+        v_store(c, v_load(c) + c10*valpha); v_store(c + 4, v_load(c + 4) + c11*valpha); c += ldc;
+        v_store(c, v_load(c) + c20*valpha); v_store(c + 4, v_load(c + 4) + c21*valpha); c += ldc;
+        v_store(c, v_load(c) + c30*valpha); v_store(c + 4, v_load(c + 4) + c31*valpha);
+        return;
+    }
+
+    v_store_aligned(acc, c00*valpha); v_store_aligned(acc + 4, c01*valpha);
+    v_store_aligned(acc + 8, c10*valpha); v_store_aligned(acc + 12, c11*valpha);
+    v_store_aligned(acc + 16, c20*valpha); v_store_aligned(acc + 20, c21*valpha);
+    v_store_aligned(acc + 24, c30*valpha); v_store_aligned(acc + 28, c31*valpha);
+#else
+    for (int i = 0; i < GEMM_MR*GEMM_NR; i++)
+        acc[i] = 0.f;
+
+    for (int k = 0; k < kc; k++, pa += GEMM_MR, pb += GEMM_NR)
+    {
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            float ai = pa[i];
+            for (int j = 0; j < GEMM_NR; j++)
+                acc[i*GEMM_NR + j] += ai*pb[j];
+        }
+    }
+
+    for (int i = 0; i < GEMM_MR*GEMM_NR; i++)
+        acc[i] *= alpha;
+#endif
+
+    for (int i = 0; i < mr; i++, c += ldc)
+    {
+        for (int j = 0; j < nr; j++)
+            c[j] += acc[i*GEMM_NR + j];
+    }
+}
+
+//computes C = alpha*op(A)*op(B) + beta*C for single precision matrices,
+//each task processes GEMM_MC x GEMM_NC tile of C using own packed panels of A and B
+class SGEMMInvoker : public ParallelLoopBody
 {
 public:
-    GEMMInvoker(const Mat* _a, const Mat* _b, double _alpha, Mat* _c, double _beta)
+    SGEMMInvoker(const Mat &_a, const Mat &_b, float _alpha, Mat &_c, float _beta, bool _transA, bool _transB)
+        : a(_a), b(_b), c(_c), alpha(_alpha), beta(_beta), transA(_transA), transB(_transB)
+    {
+        M = c.rows;
+        N = c.cols;
+        K = transA ? a.rows : a.cols;
+        tilesN = (N + GEMM_NC - 1) / GEMM_NC;
+    }
+
+    int getNumTiles() const
     {
-        a = _a;
-        b = _b;
-        c = _c;
-        alpha = _alpha;
-        beta = _beta;
+        return ((M + GEMM_MC - 1) / GEMM_MC) * tilesN;
     }
 
     void operator()(const Range& range) const
     {
-        int mmax = a->rows;
-        int nmax = range.end - range.start;
-        int kmax = a->cols;
-        int m, n, k;
-        AutoBuffer<float> buf(nmax);
-        float* ptr = buf;
-        if( mmax %2 != 0 )
-            memset(ptr, 0, nmax*sizeof(ptr[0]));
-
-        for( m = 0; m < mmax; m += 2 )
+        const float* aptr = a.ptr<float>();
+        const float* bptr = b.ptr<float>();
+        size_t lda = a.step1(), ldb = b.step1(), ldc = c.step1();
+        int kcmax = std::min(K, (int)GEMM_KC);
+
+        AutoBuffer<float> buf(GEMM_MC*kcmax + GEMM_NC*kcmax + GEMM_NR);
+        float* pa = buf;
+        float* pb = pa + GEMM_MC*kcmax;
+
+        for (int tile = range.start; tile < range.end; tile++)
         {
-            float* dst0 = c->ptr<float>(m) + range.start;
-            float* dst1 = m+1 < mmax ? c->ptr<float>(m+1) + range.start : ptr;
-            const float* aptr0 = a->ptr<float>(m);
-            const float* aptr1 = m+1 < mmax ? a->ptr<float>(m+1) : aptr0;
+            int m0 = (tile / tilesN) * GEMM_MC, n0 = (tile % tilesN) * GEMM_NC;
+            int mc = std::min((int)GEMM_MC, M - m0), nc = std::min((int)GEMM_NC, N - n0);
 
-            if( beta != 1 )
+            for (int i = 0; i < mc; i++)
             {
-                if( beta == 0 )
-                    for( n = 0; n < nmax; n++ )
-                    {
-                        dst0[n] = 0.f;
-                        dst1[n] = 0.f;
-                    }
-                else
-                    for( n = 0; n < nmax; n++ )
-                    {
-                        dst0[n] *= (float)beta;
-                        dst1[n] *= (float)beta;
-                    }
+                float* cptr = c.ptr<float>(m0 + i) + n0;
+                if (beta == 0.f)
+                    memset(cptr, 0, nc*sizeof(cptr[0]));
+                else if (beta != 1.f)
+                {
+                    for (int j = 0; j < nc; j++)
+                        cptr[j] *= beta;
+                }
             }
 
-            for( k = 0; k < kmax; k++ )
+            for (int k0 = 0; k0 < K; k0 += GEMM_KC)
             {
-                float alpha0 = (float)(alpha*aptr0[k]);
-                float alpha1 = (float)(alpha*aptr1[k]);
-                const float* bptr = b->ptr<float>(k) + range.start;
+                int kc = std::min((int)GEMM_KC, K - k0);
+                packA(aptr, lda, transA, m0, mc, k0, kc, pa);
+                packB(bptr, ldb, transB, k0, kc, n0, nc, pb);
 
-                for( n = 0; n < nmax; n++ )
+                for (int j = 0; j < nc; j += GEMM_NR)
                 {
-                    float d0 = dst0[n] + alpha0*bptr[n];
-                    float d1 = dst1[n] + alpha1*bptr[n];
-                    dst0[n] = d0;
-                    dst1[n] = d1;
+                    for (int i = 0; i < mc; i += GEMM_MR)
+                    {
+                        gemmMicroKernel(kc, pa + i*kc, pb + j*kc, alpha,
+                                        c.ptr<float>(m0 + i) + n0 + j, ldc,
+                                        std::min((int)GEMM_MR, mc - i), std::min((int)GEMM_NR, nc - j));
+                    }
                 }
             }
         }
     }
 
-    const Mat *a, *b;
-    Mat* c;
-    double alpha, beta;
+    const Mat &a, &b;
+    Mat &c;
+    float alpha, beta;
+    bool transA, transB;
+    int M, N, K, tilesN;
 };
+#endif
 
 void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags /*= 0*/)
 {
@@ -137,11 +263,19 @@ void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int
         CV_Error(Error::BadDepth, "Only floating point types are supported");
     }
     #else
-    if( C.type() == CV_32F && flags == 0 )
+    bool transA = static_cast<bool>(flags & GEMM_1_T);
+    bool transB = static_cast<bool>(flags & GEMM_2_T);
+
+    if (C.type() == CV_32F && A.type() == CV_32F && B.type() == CV_32F && !(flags & GEMM_3_T) &&
+        A.data != C.data && B.data != C.data)
     {
-        GEMMInvoker invoker(&A, &B, alpha, &C, beta);
-        double granularity = 10000000./((double)A.rows*A.cols);
-        parallel_for_(Range(0, B.cols), invoker, granularity);
+        int Arows, Acols, Brows, Bcols;
+        SwapRowCols(A, Arows, Acols, transA);
+        SwapRowCols(B, Brows, Bcols, transB);
+        CV_Assert(Acols == Brows && Arows == C.rows && Bcols == C.cols);
+
+        SGEMMInvoker invoker(A, B, (float)alpha, C, (float)beta, transA, transB);
+        parallel_for_(Range(0, invoker.getNumTiles()), invoker);
     }
     else
         cv::gemm(A, B, alpha, C, beta, C, flags);
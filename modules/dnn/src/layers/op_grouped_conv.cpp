@@ -0,0 +1,111 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "op_grouped_conv.hpp"
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace cv
+{
+namespace dnn
+{
+
+class GroupedConvolutionInvoker : public ParallelLoopBody
+{
+public:
+    GroupedConvolutionInvoker(const Mat &_inp, const Mat &_weights, const float *_bias, const ActivationLayer *_activ,
+                              Mat &_out, int _group, Size _kernel, Size _stride, Size _pad, Size _dilation)
+        : inp(_inp), weights(_weights), bias(_bias), activ(_activ), out(_out), group(_group),
+          kernel(_kernel), stride(_stride), pad(_pad), dilation(_dilation) {}
+
+    //dstRow[x] += w * srcRow[x*stride + offset] for all x for which the source element lies inside the row
+    static void accumulateRow(const float *srcRow, int inpW, int offset, int sw, float w, float *dstRow, int outW)
+    {
+        int x0 = offset >= 0 ? 0 : (-offset + sw - 1) / sw;
+        int x1 = inpW - 1 - offset < 0 ? 0 : std::min((inpW - 1 - offset) / sw + 1, outW);
+        int x = x0;
+        const float *src = srcRow + offset;
+#if CV_SIMD128
+        v_float32x4 vw = v_setall_f32(w);
+        if (sw == 1)
+        {
+            for (; x <= x1 - 4; x += 4)
+                v_store(dstRow + x, v_load(dstRow + x) + v_load(src + x) * vw);
+        }
+        else if (sw == 2)
+        {
+            for (; x <= x1 - 4; x += 4)
+            {
+                const float *p = src + 2*x;
+                v_store(dstRow + x, v_load(dstRow + x) + v_float32x4(p[0], p[2], p[4], p[6]) * vw);
+            }
+        }
+#endif
+        for (; x < x1; x++)
+            dstRow[x] += w * src[x*sw];
+    }
+
+    void operator()(const Range &r) const
+    {
+        int inpCn = inp.size[1], inpH = inp.size[2], inpW = inp.size[3];
+        int outCn = out.size[1], outH = out.size[2], outW = out.size[3];
+        int inpGroupCn = inpCn / group, outGroupCn = outCn / group;
+        int kernelArea = kernel.area(), planeSize = outH * outW;
+
+        for (int plane = r.start; plane < r.end; plane++)
+        {
+            int n = plane / outCn, oc = plane % outCn;
+            int ic0 = (oc / outGroupCn) * inpGroupCn;
+            float *dst = out.ptr<float>(n, oc);
+            const float *w = weights.ptr<float>(oc);
+
+            float b = bias ? bias[oc] : 0.f;
+            for (int i = 0; i < planeSize; i++)
+                dst[i] = b;
+
+            for (int ic = 0; ic < inpGroupCn; ic++, w += kernelArea)
+            {
+                const float *src = inp.ptr<float>(n, ic0 + ic);
+                for (int y = 0; y < outH; y++)
+                {
+                    float *dstRow = dst + y * outW;
+                    for (int ky = 0; ky < kernel.height; ky++)
+                    {
+                        int iy = y * stride.height - pad.height + ky * dilation.height;
+                        if (iy < 0 || iy >= inpH)
+                            continue;
+
+                        for (int kx = 0; kx < kernel.width; kx++)
+                            accumulateRow(src + iy * inpW, inpW, kx * dilation.width - pad.width, stride.width,
+                                          w[ky * kernel.width + kx], dstRow, outW);
+                    }
+                }
+            }
+
+            if (activ)
+                activ->forwardSlice(dst, dst, planeSize, planeSize, oc, oc + 1);
+        }
+    }
+
+private:
+    const Mat &inp, &weights;
+    const float *bias;
+    const ActivationLayer *activ;
+    Mat &out;
+    int group;
+    Size kernel, stride, pad, dilation;
+};
+
+void groupedConvolution(const Mat &inp, const Mat &weights, const float *bias, const ActivationLayer *activ,
+                        Mat &out, int group, Size kernel, Size stride, Size pad, Size dilation)
+{
+    CV_Assert(inp.type() == CV_32F && weights.type() == CV_32F && out.type() == CV_32F);
+    CV_Assert(inp.dims == 4 && out.dims == 4 && inp.size[0] == out.size[0]);
+    CV_Assert(weights.rows == out.size[1] && weights.cols == inp.size[1] / group * kernel.area());
+
+    parallel_for_(Range(0, out.size[0] * out.size[1]),
+                  GroupedConvolutionInvoker(inp, weights, bias, activ, out, group, kernel, stride, pad, dilation));
+}
+
+}
+}
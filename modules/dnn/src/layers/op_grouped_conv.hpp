@@ -0,0 +1,27 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef __OPENCV_DNN_LAYERS_OP_GROUPED_CONV_HPP__
+#define __OPENCV_DNN_LAYERS_OP_GROUPED_CONV_HPP__
+#include "../precomp.hpp"
+#include <opencv2/dnn/all_layers.hpp>
+
+namespace cv
+{
+namespace dnn
+{
+    /** @brief Computes convolution with few input channels per group (e.g. depthwise one) directly, without im2col and GEMM.
+     *  @param inp      CV_32F input blob, N x inpCn x inpH x inpW.
+     *  @param weights  CV_32F matrix with outCn rows, each row contains (inpCn / @p group) kernels.
+     *  @param bias     pointer to outCn biases or NULL.
+     *  @param activ    activation which is applied to the output or NULL.
+     *  @param out      allocated CV_32F output blob, N x outCn x outH x outW.
+     *
+     * Output planes are computed in parallel, each output row is accumulated with vector instructions.
+     */
+    void groupedConvolution(const Mat &inp, const Mat &weights, const float *bias, const ActivationLayer *activ,
+                            Mat &out, int group, Size kernel, Size stride, Size pad, Size dilation);
+}
+}
+#endif
@@ -0,0 +1,109 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "op_quantize.hpp"
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace cv
+{
+namespace dnn
+{
+
+void quantizeRows(const Mat &src, Mat &dst, std::vector<float> &scales)
+{
+    CV_Assert(src.type() == CV_32F && src.dims == 2);
+
+    dst.create(src.rows, src.cols, CV_8S);
+    scales.resize(src.rows);
+    for (int i = 0; i < src.rows; i++)
+    {
+        double maxVal = norm(src.row(i), NORM_INF);
+        scales[i] = maxVal > 0 ? (float)(maxVal / 127) : 1.f;
+        src.row(i).convertTo(dst.row(i), CV_8S, 1. / scales[i]);
+    }
+}
+
+//dot products of the row of A with four rows of B
+static inline void dotInt8x4(const schar *a, const schar *b0, const schar *b1, const schar *b2, const schar *b3,
+                             int K, int *c)
+{
+    int k = 0;
+    int s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+#if CV_SIMD128
+    v_int32x4 vs0 = v_setzero_s32(), vs1 = v_setzero_s32(), vs2 = v_setzero_s32(), vs3 = v_setzero_s32();
+    for (; k <= K - 8; k += 8)
+    {
+        v_int16x8 va = v_load_expand(a + k);
+        vs0 += v_dotprod(va, v_load_expand(b0 + k));
+        vs1 += v_dotprod(va, v_load_expand(b1 + k));
+        vs2 += v_dotprod(va, v_load_expand(b2 + k));
+        vs3 += v_dotprod(va, v_load_expand(b3 + k));
+    }
+    s0 = v_reduce_sum(vs0);
+    s1 = v_reduce_sum(vs1);
+    s2 = v_reduce_sum(vs2);
+    s3 = v_reduce_sum(vs3);
+#endif
+    for (; k < K; k++)
+    {
+        int ak = a[k];
+        s0 += ak * b0[k];
+        s1 += ak * b1[k];
+        s2 += ak * b2[k];
+        s3 += ak * b3[k];
+    }
+    c[0] = s0; c[1] = s1; c[2] = s2; c[3] = s3;
+}
+
+class GemmInt8Invoker : public ParallelLoopBody
+{
+public:
+    enum { BLOCK_N = 64 };
+
+    GemmInt8Invoker(const Mat &_A, const Mat &_B, Mat &_C) : A(_A), B(_B), C(_C)
+    {
+        nblocks = (B.rows + BLOCK_N - 1) / BLOCK_N;
+    }
+
+    //each stripe is a block of columns of C for one row of A
+    void operator()(const Range &r) const
+    {
+        int K = A.cols, N = B.rows;
+        for (int s = r.start; s < r.end; s++)
+        {
+            int i = s / nblocks, j0 = (s % nblocks) * BLOCK_N, j1 = std::min(j0 + BLOCK_N, N);
+            const schar *a = A.ptr<schar>(i);
+            int *c = C.ptr<int>(i);
+
+            int j = j0;
+            for (; j <= j1 - 4; j += 4)
+                dotInt8x4(a, B.ptr<schar>(j), B.ptr<schar>(j + 1), B.ptr<schar>(j + 2), B.ptr<schar>(j + 3), K, c + j);
+            for (; j < j1; j++)
+            {
+                int tmp[4];
+                const schar *b = B.ptr<schar>(j);
+                dotInt8x4(a, b, b, b, b, K, tmp);
+                c[j] = tmp[0];
+            }
+        }
+    }
+
+private:
+    const Mat &A, &B;
+    Mat &C;
+    int nblocks;
+};
+
+void gemmInt8(const Mat &A, const Mat &B, Mat &C)
+{
+    CV_Assert(A.type() == CV_8S && B.type() == CV_8S && A.dims == 2 && B.dims == 2 && A.cols == B.cols);
+
+    C.create(A.rows, B.rows, CV_32S);
+
+    int nblocks = (B.rows + GemmInt8Invoker::BLOCK_N - 1) / GemmInt8Invoker::BLOCK_N;
+    parallel_for_(Range(0, A.rows * nblocks), GemmInt8Invoker(A, B, C));
+}
+
+}
+}
@@ -0,0 +1,28 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef __OPENCV_DNN_LAYERS_OP_QUANTIZE_HPP__
+#define __OPENCV_DNN_LAYERS_OP_QUANTIZE_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+    /** @brief Symmetrically quantizes each row of the matrix to 8-bit integers.
+     *  @param src    CV_32F matrix.
+     *  @param dst    output CV_8S matrix of the same size, src(i, j) ~ dst(i, j) * scales[i].
+     *  @param scales output quantization steps of the rows.
+     */
+    void quantizeRows(const Mat &src, Mat &dst, std::vector<float> &scales);
+
+    /** @brief Computes C = A * B^T for 8-bit integer matrices with 32-bit accumulation.
+     *  @param A CV_8S matrix of size M x K.
+     *  @param B CV_8S matrix of size N x K.
+     *  @param C output CV_32S matrix of size M x N.
+     */
+    void gemmInt8(const Mat &A, const Mat &B, Mat &C);
+}
+}
+#endif
@@ -0,0 +1,203 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+/*
+Implementation of Winograd F(2x2, 3x3) convolution:
+    Y = A^T [ (G g G^T) .* (B^T d B) ] A
+where g is 3x3 kernel, d is 4x4 input tile and Y is 2x2 output tile.
+Elementwise products are accumulated over input channels by 16 independent GEMMs.
+*/
+
+#include "op_winograd.hpp"
+#include "op_blas.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+void winogradTransformWeights(const Mat &kernels, int outCn, int inpCn, Mat &transformed)
+{
+    CV_Assert(kernels.type() == CV_32F && kernels.rows == outCn && kernels.total() == (size_t)outCn*inpCn*9);
+    transformed.create(16*outCn, inpCn, CV_32F);
+
+    for (int oc = 0; oc < outCn; oc++)
+    {
+        const float *g = kernels.ptr<float>(oc);
+        for (int ic = 0; ic < inpCn; ic++, g += 9)
+        {
+            //tmp = G g
+            float tmp[4][3];
+            for (int j = 0; j < 3; j++)
+            {
+                tmp[0][j] = g[j];
+                tmp[1][j] = 0.5f*(g[j] + g[3 + j] + g[6 + j]);
+                tmp[2][j] = 0.5f*(g[j] - g[3 + j] + g[6 + j]);
+                tmp[3][j] = g[6 + j];
+            }
+
+            //U = tmp G^T
+            for (int i = 0; i < 4; i++)
+            {
+                float u[4];
+                u[0] = tmp[i][0];
+                u[1] = 0.5f*(tmp[i][0] + tmp[i][1] + tmp[i][2]);
+                u[2] = 0.5f*(tmp[i][0] - tmp[i][1] + tmp[i][2]);
+                u[3] = tmp[i][2];
+
+                for (int j = 0; j < 4; j++)
+                    transformed.at<float>((i*4 + j)*outCn + oc, ic) = u[j];
+            }
+        }
+    }
+}
+
+class WinogradInputTransform : public ParallelLoopBody
+{
+public:
+    WinogradInputTransform(const float *_inp, int _inpCn, int _inpH, int _inpW,
+                           int _tilesH, int _tilesW, int _padH, int _padW, Mat &_tiles)
+        : inp(_inp), inpCn(_inpCn), inpH(_inpH), inpW(_inpW),
+          tilesH(_tilesH), tilesW(_tilesW), padH(_padH), padW(_padW), tiles(_tiles) {}
+
+    void operator()(const Range &r) const
+    {
+        int ntiles = tilesH*tilesW;
+        size_t tilesStep = tiles.step1()*inpCn;
+
+        for (int ic = r.start; ic < r.end; ic++)
+        {
+            const float *plane = inp + (size_t)ic*inpH*inpW;
+            float *dst = tiles.ptr<float>(ic);
+
+            for (int t = 0; t < ntiles; t++)
+            {
+                int y0 = (t / tilesW)*2 - padH, x0 = (t % tilesW)*2 - padW;
+
+                float d[4][4];
+                for (int i = 0; i < 4; i++)
+                {
+                    int y = y0 + i;
+                    for (int j = 0; j < 4; j++)
+                    {
+                        int x = x0 + j;
+                        d[i][j] = (0 <= y && y < inpH && 0 <= x && x < inpW) ? plane[y*inpW + x] : 0.f;
+                    }
+                }
+
+                //tmp = B^T d
+                float tmp[4][4];
+                for (int j = 0; j < 4; j++)
+                {
+                    tmp[0][j] = d[0][j] - d[2][j];
+                    tmp[1][j] = d[1][j] + d[2][j];
+                    tmp[2][j] = d[2][j] - d[1][j];
+                    tmp[3][j] = d[1][j] - d[3][j];
+                }
+
+                //V = tmp B
+                for (int i = 0; i < 4; i++)
+                {
+                    float *v = dst + i*4*tilesStep + t;
+                    v[0]          = tmp[i][0] - tmp[i][2];
+                    v[tilesStep]   = tmp[i][1] + tmp[i][2];
+                    v[2*tilesStep] = tmp[i][2] - tmp[i][1];
+                    v[3*tilesStep] = tmp[i][1] - tmp[i][3];
+                }
+            }
+        }
+    }
+
+    const float *inp;
+    int inpCn, inpH, inpW, tilesH, tilesW, padH, padW;
+    Mat &tiles;
+};
+
+class WinogradOutputTransform : public ParallelLoopBody
+{
+public:
+    WinogradOutputTransform(const Mat &_tiles, const float *_bias, float *_out, int _outCn,
+                            int _outH, int _outW, int _tilesH, int _tilesW)
+        : tiles(_tiles), bias(_bias), out(_out), outCn(_outCn),
+          outH(_outH), outW(_outW), tilesH(_tilesH), tilesW(_tilesW) {}
+
+    void operator()(const Range &r) const
+    {
+        int ntiles = tilesH*tilesW;
+        size_t tilesStep = tiles.step1()*outCn;
+
+        for (int oc = r.start; oc < r.end; oc++)
+        {
+            const float *src = tiles.ptr<float>(oc);
+            float *plane = out + (size_t)oc*outH*outW;
+            float b = bias ? bias[oc] : 0.f;
+
+            for (int t = 0; t < ntiles; t++)
+            {
+                float m[4][4];
+                for (int i = 0; i < 16; i++)
+                    m[i / 4][i % 4] = src[i*tilesStep + t];
+
+                //tmp = A^T m
+                float tmp[2][4];
+                for (int j = 0; j < 4; j++)
+                {
+                    tmp[0][j] = m[0][j] + m[1][j] + m[2][j];
+                    tmp[1][j] = m[1][j] - m[2][j] - m[3][j];
+                }
+
+                int y0 = (t / tilesW)*2, x0 = (t % tilesW)*2;
+                for (int i = 0; i < 2 && y0 + i < outH; i++)
+                {
+                    //Y = tmp A
+                    float *dst = plane + (y0 + i)*outW + x0;
+                    dst[0] = tmp[i][0] + tmp[i][1] + tmp[i][2] + b;
+                    if (x0 + 1 < outW)
+                        dst[1] = tmp[i][1] - tmp[i][2] - tmp[i][3] + b;
+                }
+            }
+        }
+    }
+
+    const Mat &tiles;
+    const float *bias;
+    float *out;
+    int outCn, outH, outW, tilesH, tilesW;
+};
+
+//returns rows x cols matrix, which reuses the buffer memory if it is large enough
+static Mat getBuffer(Mat &buf, int rows, int cols)
+{
+    size_t total = (size_t)rows*cols;
+    if (buf.total() < total || buf.type() != CV_32F)
+        buf.create(1, (int)total, CV_32F);
+    return Mat(rows, cols, CV_32F, buf.ptr<float>());
+}
+
+void winogradConvolution(const float *inp, int inpCn, int inpH, int inpW,
+                         const Mat &transformed, const float *bias,
+                         float *out, int outCn, int outH, int outW,
+                         int padH, int padW, Mat &inpTiles, Mat &outTiles)
+{
+    CV_Assert(transformed.type() == CV_32F && transformed.rows == 16*outCn && transformed.cols == inpCn);
+
+    int tilesH = (outH + 1) / 2, tilesW = (outW + 1) / 2;
+    int ntiles = tilesH*tilesW;
+
+    Mat V = getBuffer(inpTiles, 16*inpCn, ntiles);
+    Mat M = getBuffer(outTiles, 16*outCn, ntiles);
+
+    parallel_for_(Range(0, inpCn), WinogradInputTransform(inp, inpCn, inpH, inpW, tilesH, tilesW, padH, padW, V));
+
+    for (int i = 0; i < 16; i++)
+    {
+        Mat Mi = M.rowRange(i*outCn, (i + 1)*outCn);
+        dnn::gemm(transformed.rowRange(i*outCn, (i + 1)*outCn), V.rowRange(i*inpCn, (i + 1)*inpCn), 1, Mi, 0);
+    }
+
+    parallel_for_(Range(0, outCn), WinogradOutputTransform(M, bias, out, outCn, outH, outW, tilesH, tilesW));
+}
+
+}
+}
@@ -0,0 +1,33 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#define __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+    /** @brief Transforms 3x3 kernels to the domain of Winograd F(2x2, 3x3) algorithm.
+     *  @param kernels   CV_32F matrix with @p outCn rows, each row contains @p inpCn 3x3 kernels.
+     *  @param transformed output CV_32F matrix of size (16*outCn) x inpCn,
+     *                   which consists of 16 stacked outCn x inpCn matrices for each element of transformed 4x4 tile.
+     */
+    void winogradTransformWeights(const Mat &kernels, int outCn, int inpCn, Mat &transformed);
+
+    /** @brief Computes 3x3 convolution with unit stride and dilation using Winograd F(2x2, 3x3) algorithm.
+     *  @param inp      input planes, @p inpCn x @p inpH x @p inpW.
+     *  @param transformed weights produced by winogradTransformWeights().
+     *  @param bias     pointer to @p outCn biases or NULL.
+     *  @param out      output planes, @p outCn x @p outH x @p outW.
+     *  @param inpTiles, outTiles workspace buffers, they are reallocated only if their size is insufficient.
+     */
+    void winogradConvolution(const float *inp, int inpCn, int inpH, int inpW,
+                             const Mat &transformed, const float *bias,
+                             float *out, int outCn, int outH, int outW,
+                             int padH, int padW, Mat &inpTiles, Mat &outTiles);
+}
+}
+#endif
@@ -41,6 +41,7 @@
 
 #include "../precomp.hpp"
 #include "layers_common.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <float.h>
 #include <algorithm>
 using std::max;
@@ -128,83 +129,199 @@ public:
         }
     }
 
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            const Mat &inp_i = *inputs[i];
+            flops += (int64)inp_i.size[0] * inp_i.size[1] * out.area() * kernel.area();
+        }
+        return flops;
+    }
+
+    class PoolingInvoker : public ParallelLoopBody
+    {
+    public:
+        PoolingInvoker(const PoolingLayerImpl &_layer, const Mat &_src, Mat &_dst, Mat *_mask)
+            : layer(_layer), src(_src), dst(_dst), mask(_mask) {}
+
+        void operator()(const Range &r) const
+        {
+            int channels = src.size[1];
+            for (int i = r.start; i < r.end; i++)
+            {
+                int n = i / channels, c = i % channels;
+                if (mask)
+                    layer.maxPoolingPlane(src.ptr<float>(n, c), dst.ptr<float>(n, c), mask->ptr<float>(n, c));
+                else
+                    layer.avePoolingPlane(src.ptr<float>(n, c), dst.ptr<float>(n, c));
+            }
+        }
+
+    private:
+        const PoolingLayerImpl &layer;
+        const Mat &src;
+        Mat &dst;
+        Mat *mask;
+    };
+
     void maxPooling(Mat &src, Mat &dst, Mat &mask)
     {
         CV_DbgAssert(dst.size[2] == out.height && dst.size[3] == out.width);
+        parallel_for_(Range(0, src.size[0] * src.size[1]), PoolingInvoker(*this, src, dst, &mask));
+    }
 
-        for (int n = 0; n < src.size[0]; ++n)
+    void avePooling(Mat &src, Mat &dst)
+    {
+        parallel_for_(Range(0, src.size[0] * src.size[1]), PoolingInvoker(*this, src, dst, NULL));
+    }
+
+    //range of output columns whose windows lie inside the input horizontally
+    void getInnerColumns(int &pw0, int &pw1) const
+    {
+        pw0 = min((pad.width + stride.width - 1) / stride.width, out.width);
+        pw1 = pw0;
+        if (inp.width + pad.width >= kernel.width)
+            pw1 = max(min((inp.width + pad.width - kernel.width) / stride.width + 1, out.width), pw0);
+    }
+
+    //computes max and its index over the window for four consecutive output columns,
+    //KW and SW are compile time kernel width and stride for the frequent cases or 0
+    template<int KW, int SW>
+    void maxPoolingRow(const float *srcData, int hstart, int hend, int pw0, int pw1, int ph,
+                       float *dstData, float *dstMaskData, int &pw) const
+    {
+#if CV_SIMD128
+        const int kw = KW > 0 ? KW : kernel.width, sw = SW > 0 ? SW : stride.width;
+        const v_float32x4 laneOffsets((float)0, (float)sw, (float)(2*sw), (float)(3*sw));
+        for (pw = pw0; pw <= pw1 - 4; pw += 4)
         {
-            for (int c = 0; c < src.size[1]; ++c)
+            v_float32x4 maxVal = v_setall_f32(-FLT_MAX), maxIdx = v_setall_f32(-1.f);
+            for (int h = hstart; h < hend; ++h)
             {
-                const float *srcData = src.ptr<float>(n, c);
-                float *dstData = dst.ptr<float>(n, c);
-                float *dstMaskData = mask.ptr<float>(n, c);
-
-                for (int ph = 0; ph < out.height; ++ph)
+                int index = h * inp.width + pw * sw - pad.width;
+                for (int w = 0; w < kw; ++w, ++index)
                 {
-                    for (int pw = 0; pw < out.width; ++pw)
-                    {
-                        int hstart = ph * stride.height - pad.height;
-                        int wstart = pw * stride.width - pad.width;
-                        int hend = min(hstart + kernel.height, inp.height);
-                        int wend = min(wstart + kernel.width, inp.width);
-                        hstart = max(hstart, 0);
-                        wstart = max(wstart, 0);
-                        const int poolIndex = ph * out.width + pw;
-                        float max_val = -FLT_MAX;
-                        int max_index = -1;
-
-                        for (int h = hstart; h < hend; ++h)
-                            for (int w = wstart; w < wend; ++w)
-                            {
-                                const int index = h * inp.width + w;
-                                if (srcData[index] > max_val)
-                                {
-                                    max_val = srcData[index];
-                                    max_index = index;
-                                }
-                            }
-
-                        dstData[poolIndex] = max_val;
-                        dstMaskData[poolIndex] = max_index;
-                    }
+                    const float *p = srcData + index;
+                    v_float32x4 v(p[0], p[sw], p[2*sw], p[3*sw]);
+                    v_float32x4 idx = v_setall_f32((float)index) + laneOffsets;
+                    v_float32x4 greater = v > maxVal;
+                    maxVal = v_select(greater, v, maxVal);
+                    maxIdx = v_select(greater, idx, maxIdx);
                 }
             }
+            v_store(dstData + ph * out.width + pw, maxVal);
+            v_store(dstMaskData + ph * out.width + pw, maxIdx);
         }
+#else
+        (void)srcData; (void)hstart; (void)hend; (void)pw1; (void)ph; (void)dstData; (void)dstMaskData;
+        pw = pw0;
+#endif
     }
 
-    void avePooling(Mat &src, Mat &dst)
+    void maxPoolingPlane(const float *srcData, float *dstData, float *dstMaskData) const
     {
-        for (int n = 0; n < src.size[0]; ++n)
+        int pw0, pw1;
+        getInnerColumns(pw0, pw1);
+
+        for (int ph = 0; ph < out.height; ++ph)
         {
-            for (int c = 0; c < src.size[1]; ++c)
+            int hstart = max(ph * stride.height - pad.height, 0);
+            int hend = min(ph * stride.height - pad.height + kernel.height, inp.height);
+
+            //vectorized part, 2x2 and 3x3 windows with stride 2 have dedicated instantiations
+            int pwVec = pw0;
+            if (stride.width == 2 && kernel.width == 2)
+                maxPoolingRow<2, 2>(srcData, hstart, hend, pw0, pw1, ph, dstData, dstMaskData, pwVec);
+            else if (stride.width == 2 && kernel.width == 3)
+                maxPoolingRow<3, 2>(srcData, hstart, hend, pw0, pw1, ph, dstData, dstMaskData, pwVec);
+            else
+                maxPoolingRow<0, 0>(srcData, hstart, hend, pw0, pw1, ph, dstData, dstMaskData, pwVec);
+
+            for (int pw = 0; pw < out.width; ++pw)
             {
-                const float *srcData = src.ptr<float>(n, c);
-                float *dstData = dst.ptr<float>(n, c);
+                if (pw == pw0)
+                    pw = pwVec;
+                if (pw >= out.width)
+                    break;
 
-                for (int ph = 0; ph < out.height; ++ph)
-                {
-                    for (int pw = 0; pw < out.width; ++pw)
+                int wstart = max(pw * stride.width - pad.width, 0);
+                int wend = min(pw * stride.width - pad.width + kernel.width, inp.width);
+                const int poolIndex = ph * out.width + pw;
+                float max_val = -FLT_MAX;
+                int max_index = -1;
+
+                for (int h = hstart; h < hend; ++h)
+                    for (int w = wstart; w < wend; ++w)
                     {
-                        int hstart = ph * stride.height - pad.height;
-                        int wstart = pw * stride.width - pad.width;
-                        int hend = min(hstart + kernel.height, inp.height + pad.height);
-                        int wend = min(wstart + kernel.width, inp.width + pad.width);
-                        int poolSize = (hend - hstart) * (wend - wstart);
-                        hstart = max(hstart, 0);
-                        wstart = max(wstart, 0);
-                        hend = min(hend, inp.height);
-                        wend = min(wend, inp.width);
-
-                        dstData[ph * out.width + pw] = 0.f;
-
-                        for (int h = hstart; h < hend; ++h)
-                            for (int w = wstart; w < wend; ++w)
-                                dstData[ph * out.width + pw] += srcData[h * inp.width + w];
-
-                        dstData[ph * out.width + pw] /= poolSize;
+                        const int index = h * inp.width + w;
+                        if (srcData[index] > max_val)
+                        {
+                            max_val = srcData[index];
+                            max_index = index;
+                        }
                     }
+
+                dstData[poolIndex] = max_val;
+                dstMaskData[poolIndex] = max_index;
+            }
+        }
+    }
+
+    void avePoolingPlane(const float *srcData, float *dstData) const
+    {
+        int pw0, pw1;
+        getInnerColumns(pw0, pw1);
+
+        for (int ph = 0; ph < out.height; ++ph)
+        {
+            int hstart = ph * stride.height - pad.height;
+            int hend = min(hstart + kernel.height, inp.height + pad.height);
+            int poolHeight = hend - hstart;
+            hstart = max(hstart, 0);
+            hend = min(hend, inp.height);
+
+            int pw = 0;
+#if CV_SIMD128
+            //windows of the inner columns aren't clipped horizontally, so the pool size is the same for them
+            v_float32x4 scale = v_setall_f32(1.f / (poolHeight * kernel.width));
+            for (pw = pw0; pw <= pw1 - 4; pw += 4)
+            {
+                v_float32x4 sum = v_setzero_f32();
+                const int sw = stride.width;
+                for (int h = hstart; h < hend; ++h)
+                {
+                    const float *p = srcData + h * inp.width + pw * sw - pad.width;
+                    for (int w = 0; w < kernel.width; ++w, ++p)
+                        sum += v_float32x4(p[0], p[sw], p[2*sw], p[3*sw]);
                 }
+                v_store(dstData + ph * out.width + pw, sum * scale);
+            }
+            int pwVec = pw;
+#else
+            int pwVec = pw0;
+#endif
+
+            for (pw = 0; pw < out.width; ++pw)
+            {
+                if (pw == pw0)
+                    pw = pwVec;
+                if (pw >= out.width)
+                    break;
+
+                int wstart = pw * stride.width - pad.width;
+                int wend = min(wstart + kernel.width, inp.width + pad.width);
+                int poolSize = poolHeight * (wend - wstart);
+                wstart = max(wstart, 0);
+                wend = min(wend, inp.width);
+
+                float sum = 0.f;
+                for (int h = hstart; h < hend; ++h)
+                    for (int w = wstart; w < wend; ++w)
+                        sum += srcData[h * inp.width + w];
+
+                dstData[ph * out.width + pw] = sum / poolSize;
             }
         }
     }
@@ -41,6 +41,7 @@
 
 #include "../precomp.hpp"
 #include "op_blas.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <iostream>
 #include <iterator>
 #include <cmath>
@@ -51,40 +52,76 @@ namespace cv
 namespace dnn
 {
 
-template<typename Dtype>
-static void tanh(const Mat &src, Mat &dst)
+//computes tanh(x + bias) in place using tanh(y) = 2 / (1 + exp(-2y)) - 1, so the exponent is evaluated by a single vectorized call
+static void tanhRow(float *data, const float *bias, int len)
 {
-    MatConstIterator_<Dtype> itSrc = src.begin<Dtype>();
-    MatIterator_<Dtype> itDst = dst.begin<Dtype>();
-
-    for (; itSrc != src.end<Dtype>(); itSrc++, itDst++)
-        *itDst = std::tanh(*itSrc);
+    int i = 0;
+#if CV_SIMD128
+    v_float32x4 vm2 = v_setall_f32(-2.f);
+    for (; i <= len - 4; i += 4)
+    {
+        v_float32x4 x = v_load(data + i);
+        if (bias)
+            x += v_load(bias + i);
+        v_store(data + i, x * vm2);
+    }
+#endif
+    for (; i < len; i++)
+        data[i] = -2.f * (data[i] + (bias ? bias[i] : 0.f));
+
+    Mat row(1, len, CV_32F, data);
+    cv::exp(row, row);
+
+    i = 0;
+#if CV_SIMD128
+    v_float32x4 v1 = v_setall_f32(1.f), v2 = v_setall_f32(2.f);
+    for (; i <= len - 4; i += 4)
+        v_store(data + i, v2 / (v1 + v_load(data + i)) - v1);
+#endif
+    for (; i < len; i++)
+        data[i] = 2.f / (1.f + data[i]) - 1.f;
 }
 
-//TODO: make utils method
-static void tanh(const Mat &src, Mat &dst)
+//applies tanh(x + bias) to blocks of rows of the matrix in parallel
+class TanhInvoker : public ParallelLoopBody
 {
-    dst.create(src.dims, (const int*)src.size, src.type());
-
-    if (src.type() == CV_32F)
-        tanh<float>(src, dst);
-    else if (src.type() == CV_64F)
-        tanh<double>(src, dst);
-    else
-        CV_Error(Error::StsUnsupportedFormat, "Function supports only floating point types");
-}
+public:
+    enum { BLOCK_SIZE = 256 };
 
-static void sigmoid(const Mat &src, Mat &dst)
-{
-    cv::exp(-src, dst);
-    cv::pow(1 + dst, -1, dst);
-}
+    TanhInvoker(Mat &_data, const Mat &_bias) : data(_data), bias(_bias)
+    {
+        blocks = (data.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    void operator()(const Range &r) const
+    {
+        for (int stripe = r.start; stripe < r.end; stripe++)
+        {
+            int row = stripe / blocks, j0 = (stripe % blocks) * BLOCK_SIZE;
+            tanhRow(data.ptr<float>(row) + j0, bias.empty() ? NULL : bias.ptr<float>() + j0,
+                    std::min((int)BLOCK_SIZE, data.cols - j0));
+        }
+    }
+
+    static void run(Mat &data, const Mat &bias = Mat())
+    {
+        CV_Assert(data.type() == CV_32F && (bias.empty() || (bias.isContinuous() && (int)bias.total() == data.cols)));
+        TanhInvoker invoker(data, bias);
+        parallel_for_(Range(0, data.rows * invoker.blocks), invoker);
+    }
+
+    int blocks;
+
+private:
+    Mat &data;
+    const Mat &bias;
+};
 
 class LSTMLayerImpl : public LSTMLayer
 {
     int numOut, numTimeStamps, numSamples, numInp;
     Mat hInternal, cInternal;
-    Mat gates, dummyOnes;
+    Mat gates; //input projections and gates of all timestamps
     bool allocated;
 
     std::vector<int> outTailShape;                 //shape of single output sample
@@ -248,14 +285,96 @@ public:
             cInternal = cInternal.reshape(1, outTsMatShape);
         }
 
-        gates.create(numSamples, 4*numOut, dtype);
-
-        dummyOnes.create(numSamples, 1, dtype);
-        dummyOnes.setTo(1.);
+        gates.create(numTimeStamps*numSamples, 4*numOut, dtype);
 
         allocated = true;
     }
 
+    //computes c_t and h_t from the gates of a single timestamp for blocks of hidden units of each sample
+    class GatesInvoker : public ParallelLoopBody
+    {
+    public:
+        enum { BLOCK_SIZE = 256 };
+
+        GatesInvoker(const Mat &_gates, const Mat &_bias, Mat &_c, Mat &_h, Mat &_hOut, Mat &_cOut)
+            : gates(_gates), bias(_bias), c(_c), h(_h), hOut(_hOut), cOut(_cOut)
+        {
+            numOut = c.cols;
+            blocks = (numOut + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        }
+
+        void operator()(const Range &r) const
+        {
+            AutoBuffer<float> buf(4 * BLOCK_SIZE);
+            for (int stripe = r.start; stripe < r.end; stripe++)
+            {
+                int sample = stripe / blocks, j0 = (stripe % blocks) * BLOCK_SIZE;
+                int len = std::min((int)BLOCK_SIZE, numOut - j0);
+
+                //sigmoid(x) = 1 / (1 + exp(-x)) for i, f, o gates and tanh(x) = 2 / (1 + exp(-2x)) - 1 for g gate,
+                //all exponents are evaluated by a single call
+                float *t = buf;
+                const float *g = gates.ptr<float>(sample), *b = bias.ptr<float>();
+                for (int k = 0; k < 4; k++)
+                {
+                    float alpha = k < 3 ? -1.f : -2.f;
+                    const float *gk = g + k*numOut + j0, *bk = b + k*numOut + j0;
+                    float *tk = t + k*len;
+                    for (int j = 0; j < len; j++)
+                        tk[j] = alpha * (gk[j] + bk[j]);
+                }
+                Mat tMat(1, 4*len, CV_32F, t);
+                cv::exp(tMat, tMat);
+
+                float *ti = t, *tf = t + len, *to = t + 2*len, *tg = t + 3*len;
+                float *cRow = c.ptr<float>(sample) + j0;
+                int j = 0;
+#if CV_SIMD128
+                v_float32x4 v1 = v_setall_f32(1.f), v2 = v_setall_f32(2.f), vm2 = v_setall_f32(-2.f);
+                for (; j <= len - 4; j += 4)
+                {
+                    v_float32x4 gi = v1 / (v1 + v_load(ti + j));
+                    v_float32x4 gf = v1 / (v1 + v_load(tf + j));
+                    v_float32x4 gg = v2 / (v1 + v_load(tg + j)) - v1;
+                    v_float32x4 ct = gf * v_load(cRow + j) + gi * gg;  // c_t = f_t (*) c_{t-1} + i_t (*) g_t
+                    v_store(cRow + j, ct);
+                    v_store(to + j, v1 / (v1 + v_load(to + j)));
+                    v_store(tg + j, ct * vm2);
+                }
+#endif
+                for (; j < len; j++)
+                {
+                    float gi = 1.f / (1.f + ti[j]), gf = 1.f / (1.f + tf[j]), gg = 2.f / (1.f + tg[j]) - 1.f;
+                    float ct = gf * cRow[j] + gi * gg;
+                    cRow[j] = ct;
+                    to[j] = 1.f / (1.f + to[j]);
+                    tg[j] = -2.f * ct;
+                }
+
+                //h_t = o_t (*) tanh(c_t)
+                Mat ctMat(1, len, CV_32F, tg);
+                cv::exp(ctMat, ctMat);
+
+                float *hRow = h.ptr<float>(sample) + j0, *hOutRow = hOut.ptr<float>(sample) + j0;
+                for (j = 0; j < len; j++)
+                {
+                    float ht = to[j] * (2.f / (1.f + tg[j]) - 1.f);
+                    hRow[j] = ht;
+                    hOutRow[j] = ht;
+                }
+                if (!cOut.empty())
+                    memcpy(cOut.ptr<float>(sample) + j0, cRow, len * sizeof(float));
+            }
+        }
+
+        int blocks;
+
+    private:
+        const Mat &gates, &bias;
+        Mat &c, &h, &hOut, &cOut;
+        int numOut;
+    };
+
     void forward(std::vector<Mat*> &input, std::vector<Mat> &output)
     {
         const Mat &Wh = blobs[0];
@@ -268,37 +387,20 @@ public:
         Mat hOutTs = output[0].reshape(1, numSamplesTotal);
         Mat cOutTs = produceCellOutput ? output[1].reshape(1, numSamplesTotal) : Mat();
 
+        //input projections of all timestamps don't depend on the hidden state, so compute them at once
+        dnn::gemm(xTs, Wx, 1, gates, 0, GEMM_2_T);      // Wx * x_t
+
+        Mat biasRow = bias.reshape(1, 1);
         for (int ts = 0; ts < numTimeStamps; ts++)
         {
             Range curRowRange(ts*numSamples, (ts + 1)*numSamples);
-            Mat xCurr = xTs.rowRange(curRowRange);
-
-            dnn::gemm(xCurr, Wx, 1, gates, 0, GEMM_2_T);      // Wx * x_t
-            dnn::gemm(hInternal, Wh, 1, gates, 1, GEMM_2_T);  //+Wh * h_{t-1}
-            dnn::gemm(dummyOnes, bias, 1, gates, 1);          //+b
-
-            Mat getesIFO = gates.colRange(0, 3*numOut);
-            Mat gateI = gates.colRange(0*numOut, 1*numOut);
-            Mat gateF = gates.colRange(1*numOut, 2*numOut);
-            Mat gateO = gates.colRange(2*numOut, 3*numOut);
-            Mat gateG = gates.colRange(3*numOut, 4*numOut);
-
-            sigmoid(getesIFO, getesIFO);
-            tanh(gateG, gateG);
-
-            //compute c_t
-            multiply(gateF, cInternal, gateF);  // f_t (*) c_{t-1}
-            multiply(gateI, gateG, gateI);      // i_t (*) g_t
-            add(gateF, gateI, cInternal);       // c_t = f_t (*) c_{t-1} + i_t (*) g_t
-
-            //compute h_t
-            tanh(cInternal, hInternal);
-            multiply(gateO, hInternal, hInternal);
-
-            //save results in output blobs
-            hInternal.copyTo(hOutTs.rowRange(curRowRange));
-            if (produceCellOutput)
-                cInternal.copyTo(cOutTs.rowRange(curRowRange));
+            Mat gatesCurr = gates.rowRange(curRowRange);
+            dnn::gemm(hInternal, Wh, 1, gatesCurr, 1, GEMM_2_T);  //+Wh * h_{t-1}, bias is added with activations
+
+            Mat hOutCurr = hOutTs.rowRange(curRowRange);
+            Mat cOutCurr = produceCellOutput ? cOutTs.rowRange(curRowRange) : Mat();
+            GatesInvoker invoker(gatesCurr, biasRow, cInternal, hInternal, hOutCurr, cOutCurr);
+            parallel_for_(Range(0, numSamples * invoker.blocks), invoker);
         }
     }
 };
@@ -332,7 +434,7 @@ class RNNLayerImpl : public RNNLayer
     int dtype;
     Mat Whh, Wxh, bh;
     Mat Who, bo;
-    Mat hCurr, hPrev, dummyBiasOnes;
+    Mat hPrev, hBuf; //hBuf keeps hidden states of all timestamps if they aren't produced as output
     bool produceH;
 
 public:
@@ -388,12 +490,14 @@ public:
         numSamples = inp0.size[1];
         numSamplesTotal = numTimestamps * numSamples;
 
-        hCurr.create(numSamples, numH, dtype);
         hPrev.create(numSamples, numH, dtype);
         hPrev.setTo(0.);
 
-        dummyBiasOnes.create(numSamples, 1, dtype);
-        dummyBiasOnes.setTo(1.);
+        if (!produceH)
+            hBuf.create(numSamplesTotal, numH, dtype);
+        else
+            hBuf.release();
+
         bh = bh.reshape(1, 1); //is 1 x numH Mat
         bo = bo.reshape(1, 1); //is 1 x numO Mat
 
@@ -416,26 +520,24 @@ public:
     {
         Mat xTs = input[0]->reshape(1, numSamplesTotal);
         Mat oTs = output[0].reshape(1, numSamplesTotal);
-        Mat hTs = produceH ? output[1].reshape(1, numSamplesTotal) : Mat();
+        Mat hTs = produceH ? output[1].reshape(1, numSamplesTotal) : hBuf;
+
+        //input projections of all timestamps don't depend on the hidden state, so compute them at once
+        dnn::gemm(xTs, Wxh, 1, hTs, 0, GEMM_2_T);         // W_{xh} * x_{curr}
 
         for (int ts = 0; ts < numTimestamps; ts++)
         {
             Range curRowRange = Range(ts * numSamples, (ts + 1) * numSamples);
-            Mat xCurr = xTs.rowRange(curRowRange);
-
-            dnn::gemm(hPrev, Whh, 1, hCurr, 0, GEMM_2_T); // W_{hh} * h_{prev}
-            dnn::gemm(xCurr, Wxh, 1, hCurr, 1, GEMM_2_T); //+W_{xh} * x_{curr}
-            dnn::gemm(dummyBiasOnes, bh, 1, hCurr, 1);    //+bh
-            tanh(hCurr, hPrev);
+            Mat hCurr = hTs.rowRange(curRowRange);
 
-            Mat oCurr = oTs.rowRange(curRowRange);
-            dnn::gemm(hPrev, Who, 1, oCurr, 0, GEMM_2_T); // W_{ho} * h_{prev}
-            dnn::gemm(dummyBiasOnes, bo, 1, oCurr, 1);    //+b_o
-            tanh(oCurr, oCurr);
-
-            if (produceH)
-                hPrev.copyTo(hTs.rowRange(curRowRange));
+            dnn::gemm(hPrev, Whh, 1, hCurr, 1, GEMM_2_T); //+W_{hh} * h_{prev}
+            TanhInvoker::run(hCurr, bh);                  //tanh(... + bh)
+            hCurr.copyTo(hPrev);
         }
+
+        //outputs of all timestamps are computed at once too
+        dnn::gemm(hTs, Who, 1, oTs, 0, GEMM_2_T);         // W_{ho} * h
+        TanhInvoker::run(oTs, bo);                        //tanh(... + b_o)
     }
 };
 
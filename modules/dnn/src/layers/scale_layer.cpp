@@ -27,6 +27,17 @@ public:
         hasBias = params.get<bool>("bias_term", false);
     }
 
+    bool supportInPlace() const
+    {
+        return true;
+    }
+
+    void getScaleShift(Mat& scale, Mat& shift) const
+    {
+        scale = blobs[0].reshape(1, 1);
+        shift = hasBias ? blobs[1].reshape(1, 1) : Mat::zeros(1, (int)blobs[0].total(), CV_32F);
+    }
+
     void allocate(const std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         CV_Assert(blobs.size() == 1 + hasBias);
@@ -39,6 +50,14 @@ public:
         }
     }
 
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+            flops += (1 + hasBias) * (int64)inputs[i]->total();
+        return flops;
+    }
+
     void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         for (size_t ii = 0; ii < outputs.size(); ii++)
@@ -35,6 +35,11 @@ public:
 #endif
     }
 
+    virtual bool supportInPlace() const
+    {
+        return true;
+    }
+
     virtual void allocate(const std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
     {
         CV_Assert(inputs.size() > 0);
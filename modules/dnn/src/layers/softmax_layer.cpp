@@ -41,6 +41,7 @@
 
 #include "../precomp.hpp"
 #include "layers_common.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <algorithm>
 #include <stdlib.h>
 using std::max;
@@ -79,73 +80,127 @@ public:
         outputs[0].create(inp0.dims, inp0.size.p, inp0.type());
     }
 
-    void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
+    int64 getFLOPS(const std::vector<Mat*> &inputs, const std::vector<Mat> &) const
     {
-        const Mat &src = *inputs[0];
-        Mat &dst = outputs[0];
-
-        CV_Assert(src.type() == CV_32F);
-        CV_Assert(src.isContinuous() && dst.isContinuous());
-
-        const float *srcPtr = src.ptr<float>();
-        float *dstPtr = dst.ptr<float>();
-        float *bufPtr = buf.ptr<float>();
+        //max, subtraction, exponent, sum and division per element
+        return 5 * (int64)inputs[0]->total();
+    }
 
-        size_t outerStep = src.total(axis);
-        size_t cnStep = src.total(axis + 1);
+    class SoftmaxInvoker : public ParallelLoopBody
+    {
+    public:
+        enum { BLOCK_SIZE = 1024 };
 
-        //compute max along axis
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+        SoftmaxInvoker(const float *_src, float *_dst, float *_buf, size_t _channels, size_t _innerSize)
+            : src(_src), dst(_dst), buf(_buf), channels(_channels), innerSize(_innerSize)
         {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
-
-            memcpy(bufPtr + bufOffset, srcPtr + srcOffset, innerSize * sizeof(float));
-
-            for (size_t cnDim = 1; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    bufPtr[bufOffset + i] = std::max(bufPtr[bufOffset + i], srcPtr[srcOffset + cnDim * cnStep + i]);
-            }
+            innerBlocks = (innerSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
         }
 
-        //subtract max
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+        //each stripe processes all the channels of a block of inner elements of a single outer slice
+        void operator()(const Range &r) const
         {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
-
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
+            for (int stripe = r.start; stripe < r.end; stripe++)
             {
-                for (size_t i = 0; i < innerSize; i++)
-                    dstPtr[srcOffset + cnDim * cnStep + i] = srcPtr[srcOffset + cnDim * cnStep + i] - bufPtr[bufOffset + i];
+                size_t outerDim = stripe / innerBlocks;
+                size_t i0 = (stripe % innerBlocks) * BLOCK_SIZE, len = std::min((size_t)BLOCK_SIZE, innerSize - i0);
+                const float *srcPtr = src + outerDim * channels * innerSize + i0;
+                float *dstPtr = dst + outerDim * channels * innerSize + i0;
+                float *bufPtr = buf + outerDim * innerSize + i0;
+
+                //compute max along axis
+                memcpy(bufPtr, srcPtr, len * sizeof(float));
+                for (size_t cnDim = 1; cnDim < channels; cnDim++)
+                {
+                    const float *srcRow = srcPtr + cnDim * innerSize;
+                    size_t i = 0;
+#if CV_SIMD128
+                    for (; i + 4 <= len; i += 4)
+                        v_store(bufPtr + i, v_max(v_load(bufPtr + i), v_load(srcRow + i)));
+#endif
+                    for (; i < len; i++)
+                        bufPtr[i] = std::max(bufPtr[i], srcRow[i]);
+                }
+
+                //subtract max
+                for (size_t cnDim = 0; cnDim < channels; cnDim++)
+                {
+                    const float *srcRow = srcPtr + cnDim * innerSize;
+                    float *dstRow = dstPtr + cnDim * innerSize;
+                    size_t i = 0;
+#if CV_SIMD128
+                    for (; i + 4 <= len; i += 4)
+                        v_store(dstRow + i, v_load(srcRow + i) - v_load(bufPtr + i));
+#endif
+                    for (; i < len; i++)
+                        dstRow[i] = srcRow[i] - bufPtr[i];
+                }
+
+                if (len == innerSize)
+                {
+                    //the whole slice is contiguous
+                    Mat slice(1, (int)(channels * innerSize), CV_32F, dstPtr);
+                    cv::exp(slice, slice);
+                }
+                else
+                {
+                    for (size_t cnDim = 0; cnDim < channels; cnDim++)
+                    {
+                        Mat row(1, (int)len, CV_32F, dstPtr + cnDim * innerSize);
+                        cv::exp(row, row);
+                    }
+                }
+
+                //sum exp along axis
+                memset(bufPtr, 0, len * sizeof(float));
+                for (size_t cnDim = 0; cnDim < channels; cnDim++)
+                {
+                    const float *dstRow = dstPtr + cnDim * innerSize;
+                    size_t i = 0;
+#if CV_SIMD128
+                    for (; i + 4 <= len; i += 4)
+                        v_store(bufPtr + i, v_load(bufPtr + i) + v_load(dstRow + i));
+#endif
+                    for (; i < len; i++)
+                        bufPtr[i] += dstRow[i];
+                }
+
+                //divide by computed sum
+                for (size_t i = 0; i < len; i++)
+                    bufPtr[i] = 1.f / bufPtr[i];
+
+                for (size_t cnDim = 0; cnDim < channels; cnDim++)
+                {
+                    float *dstRow = dstPtr + cnDim * innerSize;
+                    size_t i = 0;
+#if CV_SIMD128
+                    for (; i + 4 <= len; i += 4)
+                        v_store(dstRow + i, v_load(dstRow + i) * v_load(bufPtr + i));
+#endif
+                    for (; i < len; i++)
+                        dstRow[i] *= bufPtr[i];
+                }
             }
         }
 
-        cv::exp(dst, dst);
+        size_t innerBlocks;
 
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
-        {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
+    private:
+        const float *src;
+        float *dst, *buf;
+        size_t channels, innerSize;
+    };
 
-            //sum exp along axis
-            for (size_t i = 0; i < innerSize; i++)
-                bufPtr[bufOffset + i] = 0.f;
+    void forward(std::vector<Mat*> &inputs, std::vector<Mat> &outputs)
+    {
+        const Mat &src = *inputs[0];
+        Mat &dst = outputs[0];
 
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    bufPtr[bufOffset + i] += dstPtr[srcOffset + cnDim * cnStep + i];
-            }
+        CV_Assert(src.type() == CV_32F);
+        CV_Assert(src.isContinuous() && dst.isContinuous());
 
-            //divide by computed sum
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    dstPtr[srcOffset + cnDim * cnStep + i] /= bufPtr[bufOffset + i];
-            }
-        }
+        SoftmaxInvoker invoker(src.ptr<float>(), dst.ptr<float>(), buf.ptr<float>(), channels, innerSize);
+        parallel_for_(Range(0, (int)(outerSize * invoker.innerBlocks)), invoker);
     }
 
     int axis, axisRaw;
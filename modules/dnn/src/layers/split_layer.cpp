@@ -73,6 +73,7 @@ public:
         if (outputsCount >= 0)
             outputs.resize(outputsCount);
 
+        //outputs which aren't overwritten by their readers are bound to the input by the net, see Net::Impl::allocateLayer()
         for (size_t i = 0; i < outputs.size(); i++)
             outputs[i].create(inp0.dims, inp0.size.p, inp0.type());
     }
@@ -81,7 +82,8 @@ public:
     {
         for (size_t i = 0; i < outputs.size(); i++)
         {
-            inputs[0]->copyTo(outputs[i]);
+            if (outputs[i].data != inputs[0]->data)
+                inputs[0]->copyTo(outputs[i]);
         }
     }
 };
@@ -70,12 +70,28 @@ void blobShapeFromTensor(const tensorflow::TensorProto &tensor, std::vector<int>
 }
 
 template <typename T>
-void parseTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob)
+void parseTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob, const Ptr<MappedFile> &file)
 {
     std::vector<int> shape;
     blobShapeFromTensor(tensor, shape);
     int dims = (int)shape.size();
 
+    int size = tensor.tensor_content().size() / sizeof(T);
+    const T *data = reinterpret_cast<const T*>(tensor.tensor_content().c_str());
+
+    if (dims != 4 && DataType<T>::type == CV_32F)
+    {
+        // float tensors which aren't reordered are used from the mapped file as they are
+        int total = 1;
+        for (int i = 0; i < dims; i++)
+            total *= shape[i];
+        CV_Assert(size == total);
+
+        dstBlob = getMappedMat(file, data, shape, CV_32F);
+        if (!dstBlob.empty())
+            return;
+    }
+
     if (dims == 4)
     {
         // REORDER blob NHWC to NCHW
@@ -84,46 +100,37 @@ void parseTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob)
     }
 
     dstBlob.create(shape, CV_32F);
-
-    int size = tensor.tensor_content().size() / sizeof(T);
     CV_Assert(size == (int)dstBlob.total());
 
-    float *dstData = dstBlob.ptr<float>();
-    const T *data = reinterpret_cast<const T*>(tensor.tensor_content().c_str());
+    Mat src(1, size, DataType<T>::type, (void*)data);
 
     if (dims == 4)
     {
-        int num = shape[0], channels = shape[1], height = shape[2], width = shape[3];
-        int total = num*channels*height*width;
-        for(int i_n = 0; i_n < shape[0]; i_n++) {
-            for(int i_c = 0; i_c < shape[1]; i_c++) {
-                for(int i_h = 0; i_h < shape[2]; i_h++) {
-                    for(int i_w = 0; i_w < shape[3]; i_w++) {
-                       int dst_i = channels*height*width*i_n + height*width*i_c + width*i_h + i_w;
-                       int src_i = channels*height*width*i_n + i_c + channels*width*i_h + channels*i_w;
-
-                       CV_Assert(dst_i < total);
-                       CV_Assert(src_i < total);
-
-                       dstData[dst_i] = data[src_i];
-                    }
-                }
-            }
+        // each NHWC image is a (H*W) x C matrix, so transpose it to C x (H*W)
+        int num = shape[0], channels = shape[1], planeSize = shape[2]*shape[3];
+        Mat src32f;
+        src.convertTo(src32f, CV_32F);
+        for (int i_n = 0; i_n < num; i_n++)
+        {
+            Mat srcImg(planeSize, channels, CV_32F, src32f.ptr<float>() + (size_t)i_n*planeSize*channels);
+            Mat dstImg(channels, planeSize, CV_32F, dstBlob.ptr<float>(i_n));
+            transpose(srcImg, dstImg);
         }
     } else {
-        for (int i = 0; i < size; i++)
-            dstData[i] = data[i];
+        Mat dst(1, size, CV_32F, dstBlob.ptr<float>());
+        src.convertTo(dst, CV_32F);
     }
 }
 
-void blobFromTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob)
+void blobFromTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob,
+                    const Ptr<MappedFile> &file = Ptr<MappedFile>())
 {
     switch (tensor.dtype()) {
         case tensorflow::DT_FLOAT:
-            parseTensor<float>(tensor, dstBlob);
+            parseTensor<float>(tensor, dstBlob, file);
             break;
         case tensorflow::DT_DOUBLE:
-            parseTensor<double>(tensor, dstBlob);
+            parseTensor<double>(tensor, dstBlob, file);
             break;
         default:
             CV_Error(Error::StsError, "Tensor's data type is not supported");
@@ -386,12 +393,13 @@ private:
 
 
     tensorflow::GraphDef net;
+    Ptr<MappedFile> netFile;
 };
 
 TFImporter::TFImporter(const char *model)
 {
     if (model && model[0])
-        ReadTFNetParamsFromBinaryFileOrDie(model, &net);
+        ReadTFNetParamsFromBinaryFileOrDie(model, &net, &netFile);
 }
 
 void TFImporter::kernelFromTensor(const tensorflow::TensorProto &tensor, Mat &dstBlob)
@@ -414,23 +422,17 @@ void TFImporter::kernelFromTensor(const tensorflow::TensorProto &tensor, Mat &ds
     int size = tensor.tensor_content().size() / sizeof(float);
     CV_Assert(size == (int)dstBlob.total());
 
-    float *dstData = dstBlob.ptr<float>();
     const float *data = reinterpret_cast<const float*>(tensor.tensor_content().c_str());
 
-    int out_c = shape[0], input_c = shape[1], height = shape[2], width = shape[3];
-    int total = out_c*input_c*height*width;
-    for(int i_oc = 0; i_oc < out_c; i_oc++) {
-        for(int i_ic = 0; i_ic < input_c; i_ic++) {
-            for(int i_h = 0; i_h < height; i_h++) {
-                for(int i_w = 0; i_w < width; i_w++) {
-                    int dst_i = input_c*height*width*i_oc + height*width*i_ic + width*i_h + i_w;
-                    int src_i = out_c*input_c*width*i_h + out_c*input_c*i_w + out_c*i_ic + i_oc;
-                    CV_Assert(dst_i < total);
-                    CV_Assert(src_i < total);
-                   dstData[dst_i] = data[src_i];
-                }
-            }
-        }
+    // HWIO kernel is a (H*W*I) x O matrix, its transposition gives O x (H*W) x I blob,
+    // then each (H*W) x I kernel is transposed to I x (H*W)
+    int out_c = shape[0], input_c = shape[1], planeSize = shape[2]*shape[3];
+    Mat kernelsOHWI;
+    transpose(Mat(planeSize*input_c, out_c, CV_32F, (void*)data), kernelsOHWI);
+    for (int i_oc = 0; i_oc < out_c; i_oc++)
+    {
+        Mat dstKernel(input_c, planeSize, CV_32F, dstBlob.ptr<float>(i_oc));
+        transpose(kernelsOHWI.row(i_oc).reshape(1, planeSize), dstKernel);
     }
 }
 
@@ -532,7 +534,7 @@ void TFImporter::populateNet(Net dstNet)
 
                 int weights_layer_index = next_layers[0].second;
 
-                blobFromTensor(getConstBlob(net.node(weights_layer_index), value_id), layerParams.blobs[1]);
+                blobFromTensor(getConstBlob(net.node(weights_layer_index), value_id), layerParams.blobs[1], netFile);
                 ExcludeLayer(net, weights_layer_index, 0, false);
                 layers_to_ignore[weights_layer_index] = next_layers[0].first;
             }
@@ -555,7 +557,7 @@ void TFImporter::populateNet(Net dstNet)
         else if (type == "BiasAdd" || type == "Add")
         {
             layerParams.blobs.resize(1);
-            blobFromTensor(getConstBlob(layer, value_id), layerParams.blobs[0]);
+            blobFromTensor(getConstBlob(layer, value_id), layerParams.blobs[0], netFile);
 
             int id = dstNet.addLayer(name, "Shift", layerParams);
             layer_id[name] = id;
@@ -584,13 +586,13 @@ void TFImporter::populateNet(Net dstNet)
                 layerParams.blobs.resize(2);
 
                 int weights_layer_index = next_layers[0].second;
-                blobFromTensor(getConstBlob(net.node(weights_layer_index), value_id), layerParams.blobs[1]);
+                blobFromTensor(getConstBlob(net.node(weights_layer_index), value_id), layerParams.blobs[1], netFile);
                 ExcludeLayer(net, weights_layer_index, 0, false);
                 layers_to_ignore[weights_layer_index] = next_layers[0].first;
             }
 
             int kernel_blob_index = -1;
-            blobFromTensor(getConstBlob(layer, value_id, -1, &kernel_blob_index), layerParams.blobs[0]);
+            blobFromTensor(getConstBlob(layer, value_id, -1, &kernel_blob_index), layerParams.blobs[0], netFile);
 
             if (kernel_blob_index == 1) { // In this case output is computed by x*W formula - W should be transposed
                 Mat data = layerParams.blobs[0].t();
@@ -23,6 +23,7 @@ Implementation of various functions which are related to Tensorflow models readi
 
 #include "graph.pb.h"
 #include "tf_io.hpp"
+#include "../caffe/caffe_io.hpp"
 #include "../caffe/glog_emulator.hpp"
 
 namespace cv {
@@ -34,28 +35,20 @@ using namespace tensorflow;
 using namespace ::google::protobuf;
 using namespace ::google::protobuf::io;
 
-const int kProtoReadBytesLimit = INT_MAX;  // Max size of 2 GB minus 1 byte.
-
-// TODO: remove Caffe duplicate
-bool ReadProtoFromBinaryFileTF(const char* filename, Message* proto) {
-    std::ifstream fs(filename, std::ifstream::in | std::ifstream::binary);
-    CHECK(fs.is_open()) << "Can't open \"" << filename << "\"";
-    ZeroCopyInputStream* raw_input = new IstreamInputStream(&fs);
-    CodedInputStream* coded_input = new CodedInputStream(raw_input);
-    coded_input->SetTotalBytesLimit(kProtoReadBytesLimit, 536870912);
-
-    bool success = proto->ParseFromCodedStream(coded_input);
-
-    delete coded_input;
-    delete raw_input;
-    fs.close();
-    return success;
-}
-
 void ReadTFNetParamsFromBinaryFileOrDie(const char* param_file,
-                                      tensorflow::GraphDef* param) {
-  CHECK(ReadProtoFromBinaryFileTF(param_file, param))
+                                      tensorflow::GraphDef* param,
+                                      Ptr<MappedFile>* mapped) {
+  Ptr<MappedFile> file;
+  CHECK(ReadProtoFromBinaryFile(param_file, param, &file))
       << "Failed to parse GraphDef file: " << param_file;
+
+  if (mapped) {
+    // tensor_content of the tensors of the attributes (map entries) of the nodes
+    static const int tensorContents[] = {1, 5, 2, 8, 4};
+    if (file && !file->indexFields(std::vector<int>(tensorContents, tensorContents + 5)))
+      file.release();
+    *mapped = file;
+  }
 }
 
 }
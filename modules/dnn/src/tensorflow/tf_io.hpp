@@ -14,13 +14,17 @@ Declaration of various functions which are related to Tensorflow models reading.
 #if HAVE_PROTOBUF
 
 #include "graph.pb.h"
+#include "../caffe/caffe_io.hpp"
 
 namespace cv {
 namespace dnn {
 
-// Read parameters from a file into a GraphDef proto message.
+// Read parameters from a file into a GraphDef proto message. If @p mapped isn't NULL,
+// it receives the mapping of the file with the contents of the tensors of the node
+// attributes indexed (see MappedFile), or an empty Ptr.
 void ReadTFNetParamsFromBinaryFileOrDie(const char* param_file,
-                                      tensorflow::GraphDef* param);
+                                      tensorflow::GraphDef* param,
+                                      Ptr<MappedFile>* mapped = NULL);
 
 }
 }
@@ -41,6 +41,8 @@
 
 #include "test_precomp.hpp"
 #include "npy_blob.hpp"
+#include <fstream>
+#include <iterator>
 
 namespace cvtest
 {
@@ -74,6 +76,97 @@ TEST(Test_Caffe, read_googlenet)
     }
 }
 
+//minimal protobuf wire format encoder, used to write .caffemodel files
+static void writeVarint(std::string &buf, uint64 v)
+{
+    for (; v >= 0x80; v >>= 7)
+        buf += (char)((v & 0x7f) | 0x80);
+    buf += (char)v;
+}
+
+static void writeField(std::string &buf, int field, const std::string &bytes)
+{
+    writeVarint(buf, ((uint64)field << 3) | 2); //length-delimited
+    writeVarint(buf, bytes.size());
+    buf += bytes;
+}
+
+static std::string blobProto(const Mat &blob)
+{
+    std::string dims, shape, proto;
+    for (int i = 0; i < blob.dims; i++)
+        writeVarint(dims, blob.size[i]);
+    writeField(shape, 1, dims);
+    writeField(proto, 7, shape);
+    writeField(proto, 5, std::string((const char*)blob.data, blob.total() * blob.elemSize()));
+    return proto;
+}
+
+TEST(Test_Caffe, read_binary_weights)
+{
+    const int inpCn = 3, outCn = 5;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights(4, wsz, CV_32F), bias(1, outCn, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+
+    const char *proto =
+        "input: \"data\"\n"
+        "input_dim: 1 input_dim: 3 input_dim: 4 input_dim: 4\n"
+        "layer { name: \"conv\" type: \"Convolution\" bottom: \"data\" top: \"conv\"\n"
+        "        convolution_param { num_output: 5 kernel_size: 3 pad: 1 } }\n";
+
+    std::string protoPath = tempfile(".prototxt");
+    {
+        std::ofstream protoFile(protoPath.c_str());
+        protoFile << proto;
+    }
+
+    //the net name moves the packed weights to every offset modulo the size of float
+    for (int pad = 0; pad < 4; pad++)
+    {
+        std::string layer, model;
+        writeField(layer, 1, "conv");
+        writeField(layer, 2, "Convolution");
+        writeField(layer, 7, blobProto(weights));
+        writeField(layer, 7, blobProto(bias));
+        writeField(model, 1, std::string("test") + std::string(pad, '_'));
+        writeField(model, 100, layer);
+
+        size_t offset = model.find(std::string((const char*)weights.data, weights.total() * weights.elemSize()));
+        ASSERT_NE(std::string::npos, offset);
+
+        std::string modelPath = tempfile(".caffemodel");
+        {
+            std::ofstream modelFile(modelPath.c_str(), std::ios::binary);
+            modelFile.write(model.data(), model.size());
+        }
+
+        {
+            Net net = readNetFromCaffe(protoPath, modelPath);
+            ASSERT_FALSE(net.empty());
+
+            Mat netWeights = net.getParam("conv", 0);
+            normAssert(weights, netWeights);
+            normAssert(bias.reshape(1, 1), net.getParam("conv", 1).reshape(1, 1));
+
+            //aligned weights are used from the mapped file, unaligned ones are copied
+            bool mapped = netWeights.u && netWeights.u->currAllocator != Mat::getDefaultAllocator();
+            EXPECT_EQ(offset % sizeof(float) == 0, mapped) << "offset " << offset;
+
+            //the mapping is copy-on-write, the file doesn't change
+            netWeights.setTo(0);
+            std::ifstream modelFile(modelPath.c_str(), std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(modelFile)), std::istreambuf_iterator<char>());
+            EXPECT_TRUE(content == model);
+        }
+        remove(modelPath.c_str());
+    }
+    remove(protoPath.c_str());
+}
+
 TEST(Reproducibility_AlexNet, Accuracy)
 {
     Net net;
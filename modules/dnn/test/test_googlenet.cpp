@@ -56,7 +56,7 @@ static std::string _tf(TString filename)
     return (getOpenCVExtraDir() + "/dnn/") + filename;
 }
 
-static void launchGoogleNetTest()
+static void launchGoogleNetTest(bool memoryReuse = false)
 {
     Net net;
     {
@@ -66,6 +66,7 @@ static void launchGoogleNetTest()
         ASSERT_TRUE(importer != NULL);
         importer->populateNet(net);
     }
+    net.enableMemoryReuse(memoryReuse);
 
     std::vector<Mat> inpMats;
     inpMats.push_back( imread(_tf("googlenet_0.jpg")) );
@@ -85,4 +86,43 @@ TEST(Reproducibility_GoogLeNet, Accuracy)
     launchGoogleNetTest();
 }
 
+TEST(Reproducibility_GoogLeNet, MemoryReuse)
+{
+    launchGoogleNetTest(true);
+}
+
+TEST(Reproducibility_GoogLeNet, PerfProfile)
+{
+    Net net = readNetFromCaffe(findDataFile("dnn/bvlc_googlenet.prototxt", false),
+                               findDataFile("dnn/bvlc_googlenet.caffemodel", false));
+    ASSERT_FALSE(net.empty());
+    net.enableProfiling();
+
+    std::vector<Mat> inpMats;
+    inpMats.push_back( imread(_tf("googlenet_0.jpg")) );
+    ASSERT_TRUE(!inpMats[0].empty());
+
+    net.setBlob(".data", blobFromImages(inpMats, 1.));
+    net.forward();
+
+    std::vector<double> timings;
+    int64 total = net.getPerfProfile(timings);
+    EXPECT_GT(total, 0);
+    ASSERT_EQ(net.getLayerNames().size(), timings.size());
+
+    std::vector<LayerProfile> profile;
+    net.getPerfProfile(profile);
+    ASSERT_EQ(timings.size(), profile.size());
+
+    int64 convFlops = 0;
+    for (size_t i = 0; i < profile.size(); i++)
+    {
+        EXPECT_EQ(timings[i], (double)profile[i].ticks);
+        if (profile[i].type == "Convolution")
+            convFlops += profile[i].flops;
+    }
+    //GoogLeNet makes about 1.5 GMAC per image
+    EXPECT_GT(convFlops, (int64)2e9);
+}
+
 }
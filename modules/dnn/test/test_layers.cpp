@@ -42,6 +42,7 @@
 #include "test_precomp.hpp"
 #include <opencv2/core/ocl.hpp>
 #include <iostream>
+#include <float.h>
 #include "npy_blob.hpp"
 #include <opencv2/dnn/all_layers.hpp>
 #include <opencv2/ts/ocl_test.hpp>
@@ -184,6 +185,781 @@ TEST(Layer_Test_BatchNorm, Accuracy)
      testLayerUsingCaffeModels("layer_batch_norm", true);
 }
 
+//straightforward convolution with unit stride used as a reference
+static Mat referenceConvolution(const Mat &inp, const Mat &weights, const Mat &bias, int pad)
+{
+    int N = inp.size[0], inpCn = inp.size[1], inpH = inp.size[2], inpW = inp.size[3];
+    int outCn = weights.size[0], ksz = weights.size[2];
+    int outH = inpH + 2*pad - ksz + 1, outW = inpW + 2*pad - ksz + 1;
+
+    int outSize[] = {N, outCn, outH, outW};
+    Mat out(4, outSize, CV_32F);
+    for (int n = 0; n < N; n++)
+        for (int oc = 0; oc < outCn; oc++)
+            for (int y = 0; y < outH; y++)
+                for (int x = 0; x < outW; x++)
+                {
+                    double sum = bias.at<float>(oc);
+                    for (int ic = 0; ic < inpCn; ic++)
+                        for (int ky = 0; ky < ksz; ky++)
+                            for (int kx = 0; kx < ksz; kx++)
+                            {
+                                int iy = y + ky - pad, ix = x + kx - pad;
+                                if (0 <= iy && iy < inpH && 0 <= ix && ix < inpW)
+                                    sum += inp.ptr<float>(n, ic)[iy*inpW + ix] * weights.ptr<float>(oc, ic)[ky*ksz + kx];
+                            }
+                    out.ptr<float>(n, oc)[y*outW + x] = (float)sum;
+                }
+    return out;
+}
+
+typedef testing::TestWithParam<int> Layer_Test_Convolution_Paths;
+TEST_P(Layer_Test_Convolution_Paths, Accuracy)
+{
+    const int ksz = GetParam(), pad = ksz / 2, inpCn = 32, outCn = 24;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, ksz, ksz}, isz[] = {2, inpCn, 7, 9};
+    Mat weights(4, wsz, CV_32F), bias(outCn, 1, CV_32F), input(4, isz, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+    rng.fill(input, RNG::UNIFORM, -1, 1);
+
+    LayerParams lp;
+    lp.set("kernel_size", ksz);
+    lp.set("pad", pad);
+    lp.set("num_output", outCn);
+    lp.blobs.push_back(weights);
+    lp.blobs.push_back(bias);
+
+    std::vector<Mat> inputs(1, input), outputs;
+    runLayer(ConvolutionLayer::create(lp), inputs, outputs);
+
+    normAssert(referenceConvolution(input, weights, bias, pad), outputs[0]);
+}
+INSTANTIATE_TEST_CASE_P(/**/, Layer_Test_Convolution_Paths, testing::Values(1, 3, 5));
+
+//1x1 convolution, 1x1 deconvolution and inner product are single dnn::gemm calls with
+//no transposition, transposed A and transposed B (accumulating the bias) respectively;
+//M, N and K are chosen to leave tails of the tiles, of the K slices and of the micro-kernel
+typedef testing::TestWithParam<std::tr1::tuple<int, int, int> > Layer_Test_GEMM;
+TEST_P(Layer_Test_GEMM, Accuracy)
+{
+    const int M = std::tr1::get<0>(GetParam()), N = std::tr1::get<1>(GetParam()), K = std::tr1::get<2>(GetParam());
+    RNG rng(0);
+
+    Mat A(M, K, CV_32F), B(K, N, CV_32F), bias(1, N, CV_32F);
+    rng.fill(A, RNG::UNIFORM, -1, 1);
+    rng.fill(B, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+
+    Mat ref;
+    cv::gemm(A, B, 1, noArray(), 0, ref);
+
+    {
+        int wsz[] = {M, K, 1, 1}, isz[] = {1, K, 1, N};
+        LayerParams lp;
+        lp.set("kernel_size", 1);
+        lp.set("num_output", M);
+        lp.set("bias_term", false);
+        lp.blobs.push_back(A.clone().reshape(1, 4, wsz));
+
+        std::vector<Mat> inputs(1, B.reshape(1, 4, isz)), outputs;
+        runLayer(ConvolutionLayer::create(lp), inputs, outputs);
+        normAssert(ref, outputs[0].reshape(1, M), "A * B");
+    }
+    {
+        //deconvolution weights are read as an inpCn x outCn matrix
+        Mat C(M, N, CV_32F), refT;
+        rng.fill(C, RNG::UNIFORM, -1, 1);
+        cv::gemm(A, C, 1, noArray(), 0, refT, GEMM_1_T);
+
+        int wsz[] = {K, M, 1, 1}, isz[] = {1, M, 1, N};
+        LayerParams lp;
+        lp.set("kernel_size", 1);
+        lp.set("num_output", K);
+        lp.set("bias_term", false);
+        lp.blobs.push_back(A.clone().reshape(1, 4, wsz));
+
+        std::vector<Mat> inputs(1, C.reshape(1, 4, isz)), outputs;
+        runLayer(DeconvolutionLayer::create(lp), inputs, outputs);
+        normAssert(refT, outputs[0].reshape(1, K), "A^T * C");
+    }
+    {
+        LayerParams lp;
+        lp.set("num_output", N);
+        lp.blobs.push_back(B.t());
+        lp.blobs.push_back(bias.clone());
+
+        std::vector<Mat> inputs(1, A), outputs;
+        runLayer(InnerProductLayer::create(lp), inputs, outputs);
+        normAssert(ref + repeat(bias, M, 1), outputs[0].reshape(1, M), "A * B^T + bias");
+    }
+}
+INSTANTIATE_TEST_CASE_P(/**/, Layer_Test_GEMM, testing::Values(
+    std::tr1::make_tuple(1, 1, 1),
+    std::tr1::make_tuple(3, 7, 5),
+    std::tr1::make_tuple(4, 8, 256),
+    std::tr1::make_tuple(67, 131, 259),
+    std::tr1::make_tuple(130, 257, 513)));
+
+//depthwise (one input channel per group) and grouped convolutions with and without stride
+typedef testing::TestWithParam<std::tr1::tuple<int, int> > Layer_Test_Grouped_Convolution;
+TEST_P(Layer_Test_Grouped_Convolution, Accuracy)
+{
+    const int inpGroupCn = std::tr1::get<0>(GetParam()), stride = std::tr1::get<1>(GetParam());
+    const int group = 8, inpCn = inpGroupCn * group, outCn = 2 * group, outGroupCn = outCn / group;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpGroupCn, 3, 3}, isz[] = {2, inpCn, 9, 13};
+    Mat weights(4, wsz, CV_32F), bias(outCn, 1, CV_32F), input(4, isz, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+    rng.fill(input, RNG::UNIFORM, -1, 1);
+
+    LayerParams lp;
+    lp.set("kernel_size", 3);
+    lp.set("pad", 1);
+    lp.set("stride", stride);
+    lp.set("group", group);
+    lp.set("num_output", outCn);
+    lp.blobs.push_back(weights);
+    lp.blobs.push_back(bias);
+
+    std::vector<Mat> inputs(1, input), outputs;
+    runLayer(ConvolutionLayer::create(lp), inputs, outputs);
+
+    //each group is a separate convolution
+    for (int g = 0; g < group; g++)
+    {
+        Range inpRanges[] = {Range::all(), Range(g*inpGroupCn, (g + 1)*inpGroupCn), Range::all(), Range::all()};
+        Range outRanges[] = {Range::all(), Range(g*outGroupCn, (g + 1)*outGroupCn), Range::all(), Range::all()};
+        Range wRanges[] = {Range(g*outGroupCn, (g + 1)*outGroupCn), Range::all(), Range::all(), Range::all()};
+
+        Mat ref = referenceConvolution(input(inpRanges), weights(wRanges), bias.rowRange(outRanges[1]), 1);
+        if (stride > 1)
+        {
+            //strided convolution samples every stride-th output of the unit stride one
+            int osz[] = {ref.size[0], ref.size[1], (ref.size[2] - 1) / stride + 1, (ref.size[3] - 1) / stride + 1};
+            Mat sampled(4, osz, CV_32F);
+            for (int n = 0; n < osz[0]; n++)
+                for (int c = 0; c < osz[1]; c++)
+                    for (int y = 0; y < osz[2]; y++)
+                        for (int x = 0; x < osz[3]; x++)
+                            sampled.ptr<float>(n, c)[y*osz[3] + x] = ref.ptr<float>(n, c)[y*stride*ref.size[3] + x*stride];
+            ref = sampled;
+        }
+        normAssert(ref, outputs[0](outRanges).clone());
+    }
+}
+INSTANTIATE_TEST_CASE_P(/**/, Layer_Test_Grouped_Convolution, testing::Combine(testing::Values(1, 4), testing::Values(1, 2)));
+
+typedef testing::TestWithParam<std::tr1::tuple<int, int> > Layer_Test_MaxPooling_Paths;
+TEST_P(Layer_Test_MaxPooling_Paths, Accuracy)
+{
+    const int ksz = std::tr1::get<0>(GetParam()), pad = std::tr1::get<1>(GetParam()), stride = 2;
+    RNG rng(0);
+
+    int isz[] = {2, 3, 17, 22};
+    Mat input(4, isz, CV_32F);
+    rng.fill(input, RNG::UNIFORM, -1, 1);
+
+    LayerParams lp;
+    lp.set("pool", "max");
+    lp.set("kernel_size", ksz);
+    lp.set("stride", stride);
+    lp.set("pad", pad);
+
+    std::vector<Mat> inputs(1, input), outputs;
+    runLayer(PoolingLayer::create(lp), inputs, outputs);
+    ASSERT_EQ(2u, outputs.size());
+
+    //straightforward max pooling over the clipped windows
+    int outH = outputs[0].size[2], outW = outputs[0].size[3];
+    for (int n = 0; n < isz[0]; n++)
+        for (int c = 0; c < isz[1]; c++)
+        {
+            const float *src = input.ptr<float>(n, c);
+            for (int y = 0; y < outH; y++)
+                for (int x = 0; x < outW; x++)
+                {
+                    float maxVal = -FLT_MAX;
+                    int maxIdx = -1;
+                    for (int h = std::max(y*stride - pad, 0); h < std::min(y*stride - pad + ksz, isz[2]); h++)
+                        for (int w = std::max(x*stride - pad, 0); w < std::min(x*stride - pad + ksz, isz[3]); w++)
+                            if (src[h*isz[3] + w] > maxVal)
+                            {
+                                maxVal = src[h*isz[3] + w];
+                                maxIdx = h*isz[3] + w;
+                            }
+                    ASSERT_EQ(maxVal, outputs[0].ptr<float>(n, c)[y*outW + x]);
+                    ASSERT_EQ((float)maxIdx, outputs[1].ptr<float>(n, c)[y*outW + x]);
+                }
+        }
+}
+INSTANTIATE_TEST_CASE_P(/**/, Layer_Test_MaxPooling_Paths, testing::Combine(testing::Values(2, 3, 5), testing::Values(0, 1)));
+
+static Net createConvBatchNormScaleReLU(const std::vector<LayerParams> &params)
+{
+    static const char* types[] = {"Convolution", "BatchNorm", "Scale", "ReLU"};
+
+    Net net;
+    int prevId = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        LayerParams lp = params[i];
+        int id = net.addLayer(format("layer%d", i), types[i], lp);
+        net.connect(prevId, 0, id, 0);
+        prevId = id;
+    }
+    return net;
+}
+
+static std::vector<LayerParams> convBatchNormScaleReLUParams(RNG &rng, int inpCn, int outCn)
+{
+    std::vector<LayerParams> params(4);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights(4, wsz, CV_32F), bias(outCn, 1, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+    params[0].set("kernel_size", 3);
+    params[0].set("pad", 1);
+    params[0].set("num_output", outCn);
+    params[0].blobs.push_back(weights);
+    params[0].blobs.push_back(bias);
+
+    Mat mean(outCn, 1, CV_32F), var(outCn, 1, CV_32F);
+    rng.fill(mean, RNG::UNIFORM, -1, 1);
+    rng.fill(var, RNG::UNIFORM, 0.5, 2);
+    params[1].blobs.push_back(mean);
+    params[1].blobs.push_back(var);
+    params[1].blobs.push_back(Mat(1, 1, CV_32F, Scalar(1)));
+
+    Mat scale(outCn, 1, CV_32F), shift(outCn, 1, CV_32F);
+    rng.fill(scale, RNG::UNIFORM, -1, 1);
+    rng.fill(shift, RNG::UNIFORM, -1, 1);
+    params[2].set("bias_term", true);
+    params[2].blobs.push_back(scale);
+    params[2].blobs.push_back(shift);
+    return params;
+}
+
+TEST(Layer_Test_Fusion, Conv_BatchNorm_Scale_ReLU)
+{
+    const int inpCn = 3;
+    RNG rng(0);
+    std::vector<LayerParams> params = convBatchNormScaleReLUParams(rng, inpCn, 4);
+
+    int isz[] = {2, inpCn, 5, 6};
+    Mat input(4, isz, CV_32F);
+    rng.fill(input, RNG::UNIFORM, -1, 1);
+
+    Net net = createConvBatchNormScaleReLU(params);
+    net.enableFusion(false);
+    net.setBlob("", input);
+    net.forward();
+
+    Net fusedNet = createConvBatchNormScaleReLU(params);
+    fusedNet.enableFusion(true);
+    fusedNet.setBlob("", input);
+    fusedNet.forward();
+
+    normAssert(net.getBlob("layer3"), fusedNet.getBlob("layer3"));
+}
+
+TEST(Layer_Test_Fusion, Intermediate_Blobs)
+{
+    const int inpCn = 3;
+    RNG rng(0);
+    std::vector<LayerParams> params = convBatchNormScaleReLUParams(rng, inpCn, 4);
+
+    int isz[] = {2, inpCn, 5, 6};
+    Mat input(4, isz, CV_32F);
+    rng.fill(input, RNG::UNIFORM, -1, 1);
+    Mat convRef = referenceConvolution(input, params[0].blobs[0], params[0].blobs[1], 1);
+
+    //the fusion is disabled by default, so every layer keeps its own output
+    Net net = createConvBatchNormScaleReLU(params);
+    net.setBlob("", input);
+    net.forward();
+    normAssert(convRef, net.getBlob("layer0"));
+    EXPECT_NE(net.getBlob("layer0").data, net.getBlob("layer3").data);
+    EXPECT_GT(norm(net.getBlob("layer1"), net.getBlob("layer3"), NORM_INF), 0);
+
+    //merged layers share the output of the last one
+    Net fusedNet = createConvBatchNormScaleReLU(params);
+    fusedNet.enableFusion(true);
+    fusedNet.setBlob("", input);
+    fusedNet.forward();
+    Mat out = fusedNet.getBlob("layer3");
+    normAssert(net.getBlob("layer3"), out);
+    for (int i = 0; i < 3; i++)
+        EXPECT_EQ(out.data, fusedNet.getBlob(format("layer%d", i)).data);
+}
+
+TEST(Layer_Test_Reshape_Input, Conv_ReLU)
+{
+    const int inpCn = 3, outCn = 4;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights(4, wsz, CV_32F), bias(outCn, 1, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+
+    LayerParams lp;
+    lp.set("kernel_size", 3);
+    lp.set("pad", 1);
+    lp.set("num_output", outCn);
+    lp.blobs.push_back(weights);
+    lp.blobs.push_back(bias);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", lp);
+    net.connect(0, 0, convId, 0);
+    LayerParams reluParams;
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect(convId, 0, reluId, 0);
+
+    //grow batch and spatial size, then shrink them back
+    int shapes[][4] = {{1, inpCn, 5, 6}, {3, inpCn, 8, 7}, {2, inpCn, 4, 4}, {1, inpCn, 5, 6}};
+    for (int i = 0; i < 4; i++)
+    {
+        Mat input(4, shapes[i], CV_32F);
+        rng.fill(input, RNG::UNIFORM, -1, 1);
+
+        net.setBlob("", input);
+        net.forward();
+
+        Mat ref = max(referenceConvolution(input, weights, bias, 1), 0);
+        normAssert(ref, net.getBlob("relu"), format("shape #%d", i).c_str());
+    }
+}
+
+//counts allocations of Mat data made by the default allocator
+class CountingAllocator : public MatAllocator
+{
+public:
+    CountingAllocator() : count(0) {}
+
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, UMatUsageFlags usageFlags) const
+    {
+        if (!data)
+            CV_XADD(&count, 1);
+        return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+
+    void deallocate(UMatData* u) const
+    {
+        Mat::getStdAllocator()->deallocate(u);
+    }
+
+    mutable int count;
+};
+
+TEST(Layer_Test_Reshape_Input, No_Reallocation)
+{
+    LayerParams poolParams, reluParams;
+    poolParams.set("pool", "ave");
+    poolParams.set("kernel_size", 2);
+    poolParams.set("stride", 2);
+
+    Net net;
+    int poolId = net.addLayer("pool", "Pooling", poolParams);
+    net.connect(0, 0, poolId, 0);
+    net.addLayerToPrev("relu", "ReLU", reluParams);
+
+    //the largest shape goes first, then blobs only shrink and grow back
+    int shapes[][4] = {{3, 4, 8, 10}, {1, 4, 6, 6}, {2, 4, 8, 8}, {3, 4, 8, 10}, {1, 4, 4, 4}};
+    RNG rng(0);
+    for (int i = 0; i < 5; i++)
+    {
+        Mat input(4, shapes[i], CV_32F);
+        rng.fill(input, RNG::UNIFORM, -1, 1);
+
+        CountingAllocator allocator;
+        MatAllocator *defaultAllocator = Mat::getDefaultAllocator();
+        Mat::setDefaultAllocator(&allocator);
+        net.setBlob("", input);
+        net.forward();
+        Mat::setDefaultAllocator(defaultAllocator);
+
+        if (i > 0)
+            EXPECT_EQ(0, allocator.count) << format("shape #%d", i);
+
+        Mat out = net.getBlob("relu");
+        int outShape[] = {shapes[i][0], shapes[i][1], shapes[i][2] / 2, shapes[i][3] / 2};
+        ASSERT_TRUE(shapeEqual(makeShape(outShape[0], outShape[1], outShape[2], outShape[3]), getShape(out)));
+        for (int n = 0; n < outShape[0]; n++)
+            for (int c = 0; c < outShape[1]; c++)
+                for (int y = 0; y < outShape[2]; y++)
+                    for (int x = 0; x < outShape[3]; x++)
+                    {
+                        const float *src = input.ptr<float>(n, c) + 2*y*shapes[i][3] + 2*x;
+                        float ref = std::max(0.f, (src[0] + src[1] + src[shapes[i][3]] + src[shapes[i][3] + 1]) / 4);
+                        ASSERT_NEAR(ref, out.ptr<float>(n, c)[y*outShape[3] + x], 1e-5);
+                    }
+    }
+}
+
+TEST(Layer_Test_Concat_Views, Conv_ReLU_Concat)
+{
+    const int inpCn = 3, outCn = 4;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights[2], bias[2];
+    Net net;
+    for (int i = 0; i < 2; i++)
+    {
+        weights[i].create(4, wsz, CV_32F);
+        bias[i].create(outCn, 1, CV_32F);
+        rng.fill(weights[i], RNG::UNIFORM, -1, 1);
+        rng.fill(bias[i], RNG::UNIFORM, -1, 1);
+
+        LayerParams lp;
+        lp.set("kernel_size", 3);
+        lp.set("pad", 1);
+        lp.set("num_output", outCn);
+        lp.blobs.push_back(weights[i]);
+        lp.blobs.push_back(bias[i]);
+        int convId = net.addLayer(format("conv%d", i), "Convolution", lp);
+        net.connect(0, 0, convId, 0);
+    }
+    LayerParams reluParams, concatParams;
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect("conv0", "relu");
+    int concatId = net.addLayer("concat", "Concat", concatParams);
+    net.connect(reluId, 0, concatId, 0);
+    net.connect(net.getLayerId("conv1"), 0, concatId, 1);
+
+    //slices of the batch larger than 1 aren't continuous, so they are copied
+    int shapes[][4] = {{1, inpCn, 5, 6}, {2, inpCn, 5, 6}};
+    for (int reuse = 0; reuse < 2; reuse++)
+    {
+        net.enableMemoryReuse(reuse != 0);
+        for (int i = 0; i < 2; i++)
+        {
+            Mat input(4, shapes[i], CV_32F);
+            rng.fill(input, RNG::UNIFORM, -1, 1);
+
+            net.setBlob("", input);
+            net.forward();
+
+            Mat ref0 = max(referenceConvolution(input, weights[0], bias[0], 1), 0);
+            Mat ref1 = referenceConvolution(input, weights[1], bias[1], 1);
+            int refShape[] = {shapes[i][0], 2 * outCn, 5, 6};
+            Mat ref;
+            hconcat(ref0.reshape(1, shapes[i][0]), ref1.reshape(1, shapes[i][0]), ref);
+            ref = ref.reshape(1, 4, refShape);
+            Mat out = net.getBlob("concat");
+            normAssert(ref, out, format("reuse %d, shape #%d", reuse, i).c_str());
+
+            if (shapes[i][0] == 1)
+            {
+                //convolutions write to the concatenated blob directly
+                EXPECT_EQ(out.data, net.getBlob("conv0").data);
+                EXPECT_EQ(out.data, net.getBlob("relu").data);
+                EXPECT_EQ(out.ptr<float>() + ref0.total(), net.getBlob("conv1").ptr<float>());
+            }
+        }
+    }
+}
+
+TEST(Layer_Test_Concat_Views, Concat_ReLU)
+{
+    const int inpCn = 3, outCn = 4;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights[2], bias[2];
+    Net net;
+    for (int i = 0; i < 2; i++)
+    {
+        weights[i].create(4, wsz, CV_32F);
+        bias[i].create(outCn, 1, CV_32F);
+        rng.fill(weights[i], RNG::UNIFORM, -1, 1);
+        rng.fill(bias[i], RNG::UNIFORM, -1, 1);
+
+        LayerParams lp;
+        lp.set("kernel_size", 3);
+        lp.set("pad", 1);
+        lp.set("num_output", outCn);
+        lp.blobs.push_back(weights[i]);
+        lp.blobs.push_back(bias[i]);
+        int convId = net.addLayer(format("conv%d", i), "Convolution", lp);
+        net.connect(0, 0, convId, 0);
+    }
+    LayerParams concatParams, reluParams;
+    int concatId = net.addLayer("concat", "Concat", concatParams);
+    net.connect(net.getLayerId("conv0"), 0, concatId, 0);
+    net.connect(net.getLayerId("conv1"), 0, concatId, 1);
+    net.addLayerToPrev("relu", "ReLU", reluParams);
+
+    //ReLU overwrites the concatenated blob in place, so it must be bound to the memory the convolutions write to
+    int isz[] = {1, inpCn, 5, 6};
+    for (int reuse = 0; reuse < 2; reuse++)
+    {
+        net.enableMemoryReuse(reuse != 0);
+        for (int i = 0; i < 2; i++)
+        {
+            Mat input(4, isz, CV_32F);
+            rng.fill(input, RNG::UNIFORM, -1, 1);
+
+            net.setBlob("", input);
+            net.forward();
+
+            Mat ref0 = referenceConvolution(input, weights[0], bias[0], 1);
+            Mat ref1 = referenceConvolution(input, weights[1], bias[1], 1);
+            int refShape[] = {1, 2 * outCn, 5, 6};
+            Mat ref;
+            hconcat(ref0.reshape(1, 1), ref1.reshape(1, 1), ref);
+            ref = max(ref.reshape(1, 4, refShape), 0);
+
+            Mat out = net.getBlob("relu");
+            normAssert(ref, out, format("reuse %d, iteration %d", reuse, i).c_str());
+            EXPECT_EQ(net.getBlob("concat").data, out.data);
+            EXPECT_EQ(net.getBlob("conv0").data, out.data);
+        }
+    }
+}
+
+TEST(Layer_Test_Split, InPlace_Reader)
+{
+    const int inpCn = 3, outCn = 4;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3};
+    Mat weights(4, wsz, CV_32F), bias(outCn, 1, CV_32F);
+    rng.fill(weights, RNG::UNIFORM, -1, 1);
+    rng.fill(bias, RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams, splitParams, reluParams, identityParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("pad", 1);
+    convParams.set("num_output", outCn);
+    convParams.blobs.push_back(weights);
+    convParams.blobs.push_back(bias);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    net.connect(0, 0, convId, 0);
+    int splitId = net.addLayer("split", "Split", splitParams);
+    net.connect(convId, 0, splitId, 0);
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect(splitId, 0, reluId, 0);
+    int identityId = net.addLayer("identity", "Identity", identityParams);
+    net.connect(splitId, 1, identityId, 0);
+
+    //ReLU works in place, so it must get a copy, while the other branch reads the input of Split directly
+    int isz[] = {2, inpCn, 5, 6};
+    for (int reuse = 0; reuse < 2; reuse++)
+    {
+        net.enableMemoryReuse(reuse != 0);
+
+        Mat input(4, isz, CV_32F);
+        rng.fill(input, RNG::UNIFORM, -1, 1);
+
+        net.setBlob("", input);
+        net.forward();
+
+        Mat ref = referenceConvolution(input, weights, bias, 1);
+        normAssert(max(ref, 0), net.getBlob("relu"), format("reuse %d", reuse).c_str());
+        normAssert(ref, net.getBlob("identity"), format("reuse %d", reuse).c_str());
+        EXPECT_NE(net.getBlob("conv").data, net.getBlob("split.0").data);
+        EXPECT_EQ(net.getBlob("conv").data, net.getBlob("split.1").data);
+    }
+}
+
+static Net createConvReLUInnerProduct(const Mat &convWeights, const Mat &convBias, const Mat &ipWeights, const Mat &ipBias)
+{
+    LayerParams convParams, reluParams, ipParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("pad", 1);
+    convParams.set("num_output", convWeights.size[0]);
+    convParams.blobs.push_back(convWeights);
+    convParams.blobs.push_back(convBias);
+
+    ipParams.set("num_output", ipWeights.rows);
+    ipParams.blobs.push_back(ipWeights);
+    ipParams.blobs.push_back(ipBias);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    net.connect(0, 0, convId, 0);
+    net.addLayerToPrev("relu", "ReLU", reluParams);
+    net.addLayerToPrev("fc", "InnerProduct", ipParams);
+    return net;
+}
+
+TEST(Layer_Test_Reduced_Precision, Conv_ReLU_InnerProduct)
+{
+    const int inpCn = 8, outCn = 16, numOutput = 10;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3}, isz[] = {2, inpCn, 6, 6};
+    Mat convWeights(4, wsz, CV_32F), convBias(outCn, 1, CV_32F);
+    Mat ipWeights(numOutput, outCn * 6 * 6, CV_32F), ipBias(numOutput, 1, CV_32F);
+    rng.fill(convWeights, RNG::UNIFORM, -1, 1);
+    rng.fill(convBias, RNG::UNIFORM, -1, 1);
+    rng.fill(ipWeights, RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(ipBias, RNG::UNIFORM, -1, 1);
+
+    std::vector<Mat> samples(3);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i].create(4, isz, CV_32F);
+        rng.fill(samples[i], RNG::UNIFORM, -1, 1);
+    }
+    Mat input = samples[0];
+
+    Net net = createConvReLUInnerProduct(convWeights, convBias, ipWeights, ipBias);
+    net.setBlob("", input);
+    net.forward();
+    Mat ref = net.getBlob("fc").clone();
+    double refNorm = norm(ref, NORM_INF);
+
+    Net fp16Net = createConvReLUInnerProduct(convWeights, convBias, ipWeights, ipBias);
+    fp16Net.convertWeightsToFp16();
+    EXPECT_EQ(CV_16S, fp16Net.getParam("conv", 0).type());
+    EXPECT_EQ(CV_16S, fp16Net.getParam("fc", 0).type());
+    fp16Net.setBlob("", input);
+    fp16Net.forward();
+    EXPECT_LE(norm(ref, fp16Net.getBlob("fc"), NORM_INF), 1e-3 * refNorm);
+
+    Net int8Net = createConvReLUInnerProduct(convWeights, convBias, ipWeights, ipBias);
+    int8Net.quantizeWeightsToInt8(samples);
+    EXPECT_EQ(CV_8S, int8Net.getParam("conv", 0).type());
+    EXPECT_EQ(CV_8S, int8Net.getParam("fc", 0).type());
+    int8Net.setBlob("", input);
+    int8Net.forward();
+    EXPECT_LE(norm(ref, int8Net.getBlob("fc"), NORM_INF), 5e-2 * refNorm);
+}
+
+class ForwardContextsBody : public ParallelLoopBody
+{
+public:
+    ForwardContextsBody(std::vector<Net> &_contexts, const std::vector<Mat> &_inputs, std::vector<Mat> &_outputs)
+        : contexts(_contexts), inputs(_inputs), outputs(_outputs) {}
+
+    void operator()(const Range &r) const
+    {
+        for (int i = r.start; i < r.end; i++)
+        {
+            contexts[i].setBlob("", inputs[i]);
+            contexts[i].forward();
+            outputs[i] = contexts[i].getBlob("fc").clone();
+        }
+    }
+
+private:
+    std::vector<Net> &contexts;
+    const std::vector<Mat> &inputs;
+    std::vector<Mat> &outputs;
+};
+
+TEST(Layer_Test_Execution_Context, Concurrent_Forward)
+{
+    const int inpCn = 16, outCn = 16, numOutput = 10, numContexts = 4;
+    RNG rng(0);
+
+    int wsz[] = {outCn, inpCn, 3, 3}, isz[] = {1, inpCn, 8, 8};
+    Mat convWeights(4, wsz, CV_32F), convBias(outCn, 1, CV_32F);
+    Mat ipWeights(numOutput, outCn * 8 * 8, CV_32F), ipBias(numOutput, 1, CV_32F);
+    rng.fill(convWeights, RNG::UNIFORM, -1, 1);
+    rng.fill(convBias, RNG::UNIFORM, -1, 1);
+    rng.fill(ipWeights, RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(ipBias, RNG::UNIFORM, -1, 1);
+
+    Net net = createConvReLUInnerProduct(convWeights, convBias, ipWeights, ipBias);
+
+    std::vector<Net> contexts;
+    std::vector<Mat> inputs(numContexts), refs(numContexts), outputs(numContexts);
+    for (int i = 0; i < numContexts; i++)
+    {
+        contexts.push_back(net.createExecutionContext());
+        inputs[i].create(4, isz, CV_32F);
+        rng.fill(inputs[i], RNG::UNIFORM, -1, 1);
+    }
+
+    for (int i = 0; i < numContexts; i++)
+    {
+        net.setBlob("", inputs[i]);
+        net.forward();
+        refs[i] = net.getBlob("fc").clone();
+    }
+
+    parallel_for_(Range(0, numContexts), ForwardContextsBody(contexts, inputs, outputs));
+
+    for (int i = 0; i < numContexts; i++)
+    {
+        normAssert(refs[i], outputs[i]);
+        EXPECT_EQ(net.getParam("conv", 0).data, contexts[i].getParam("conv", 0).data);
+        EXPECT_EQ(net.getParam("fc", 0).data, contexts[i].getParam("fc", 0).data);
+    }
+}
+
+static void testDetectionOutput(int keepTopK, const Mat& ref)
+{
+    const int numPriors = 6, numClasses = 3;
+    LayerParams lp;
+    lp.set("num_classes", numClasses);
+    lp.set("share_location", 1);
+    lp.set("background_label_id", 0);
+    lp.set("keep_top_k", keepTopK);
+    lp.set("confidence_threshold", 0.1);
+    lp.set("nms_threshold", 0.5);
+    lp.set("code_type", "CENTER_SIZE");
+
+    //zero offsets make decoded boxes equal to priors
+    Mat loc = Mat::zeros(1, numPriors * 4, CV_32F);
+    float priorsData[] = {0.f, 0.f, 0.5f, 0.5f,
+                          0.05f, 0.f, 0.55f, 0.5f,
+                          0.5f, 0.5f, 1.f, 1.f,
+                          0.6f, 0.5f, 1.2f, 1.f,
+                          0.f, 0.6f, 0.3f, 0.9f,
+                          0.7f, 0.f, 0.9f, 0.2f,
+                          0.1f, 0.1f, 0.2f, 0.2f, 0.1f, 0.1f, 0.2f, 0.2f,
+                          0.1f, 0.1f, 0.2f, 0.2f, 0.1f, 0.1f, 0.2f, 0.2f,
+                          0.1f, 0.1f, 0.2f, 0.2f, 0.1f, 0.1f, 0.2f, 0.2f};
+    int priorsShape[] = {1, 2, numPriors * 4};
+    Mat priors(3, priorsShape, CV_32F, priorsData);
+    //background, class 1 and class 2 scores of every prior
+    float confData[] = {0.1f, 0.9f, 0.01f,
+                        0.1f, 0.8f, 0.01f,
+                        0.1f, 0.05f, 0.7f,
+                        0.1f, 0.05f, 0.6f,
+                        0.1f, 0.05f, 0.01f,
+                        0.1f, 0.05f, 0.95f};
+    Mat conf(1, numPriors * numClasses, CV_32F, confData);
+
+    std::vector<Mat> inputs, outputs;
+    inputs.push_back(loc);
+    inputs.push_back(conf);
+    inputs.push_back(priors);
+    runLayer(DetectionOutputLayer::create(lp), inputs, outputs);
+
+    ASSERT_EQ(outputs[0].total(), ref.total());
+    normAssert(ref, outputs[0].reshape(1, ref.rows));
+}
+
+TEST(Layer_Test_DetectionOutput, NMS_KeepTopK)
+{
+    //[image_id, label, confidence, xmin, ymin, xmax, ymax], priors 1 and 3 are suppressed by NMS
+    Mat ref = (Mat_<float>(3, 7) << 0, 1, 0.9f, 0.f, 0.f, 0.5f, 0.5f,
+                                    0, 2, 0.95f, 0.7f, 0.f, 0.9f, 0.2f,
+                                    0, 2, 0.7f, 0.5f, 0.5f, 1.f, 1.f);
+    testDetectionOutput(-1, ref);
+    //only two the most confident detections are kept
+    testDetectionOutput(2, ref.rowRange(0, 2));
+}
+
 //template<typename XMat>
 //static void test_Layer_Concat()
 //{
@@ -334,6 +1110,132 @@ TEST(Layer_RNN_Test_Accuracy_with_, CaffeRecurrent)
 }
 
 
+static float sigmoid(float x)
+{
+    return 1.f / (1.f + std::exp(-x));
+}
+
+//straightforward LSTM: gates = Wx * x_t + Wh * h_{t-1} + b are split into i, f, o, g blocks,
+//c_t = f * c_{t-1} + i * g, h_t = o * tanh(c_t)
+static void referenceLSTM(const Mat &inp, const Mat &Wh, const Mat &Wx, const Mat &b,
+                          Mat h, Mat c, Mat &hOut, Mat &cOut)
+{
+    int numTs = inp.size[0], numSamples = inp.size[1], numOut = Wh.cols;
+    int outShape[] = {numTs, numSamples, numOut};
+    hOut.create(3, outShape, CV_32F);
+    cOut.create(3, outShape, CV_32F);
+
+    for (int t = 0; t < numTs; t++)
+    {
+        Mat x(numSamples, inp.size[2], CV_32F, (void*)inp.ptr<float>(t));
+        Mat gates = x * Wx.t() + h * Wh.t();
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            const float *g = gates.ptr<float>(n), *bias = b.ptr<float>();
+            float *hp = h.ptr<float>(n), *cp = c.ptr<float>(n);
+            for (int j = 0; j < numOut; j++)
+            {
+                float ig = sigmoid(g[j] + bias[j]);
+                float fg = sigmoid(g[numOut + j] + bias[numOut + j]);
+                float og = sigmoid(g[2*numOut + j] + bias[2*numOut + j]);
+                float gg = std::tanh(g[3*numOut + j] + bias[3*numOut + j]);
+                cp[j] = fg * cp[j] + ig * gg;
+                hp[j] = og * std::tanh(cp[j]);
+            }
+        }
+        h.copyTo(Mat(numSamples, numOut, CV_32F, hOut.ptr<float>(t)));
+        c.copyTo(Mat(numSamples, numOut, CV_32F, cOut.ptr<float>(t)));
+    }
+}
+
+TEST(Layer_LSTM_Test_Accuracy_with_, Reference)
+{
+    //numOut spans more than one block of hidden units and isn't a multiple of the vector width
+    const int numTs = 3, numSamples = 2, numInp = 7, numOut = 259;
+    RNG rng(0);
+
+    Mat Wh(4*numOut, numOut, CV_32F), Wx(4*numOut, numInp, CV_32F), b(4*numOut, 1, CV_32F);
+    rng.fill(Wh, RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(Wx, RNG::UNIFORM, -1, 1);
+    rng.fill(b, RNG::UNIFORM, -1, 1);
+
+    Mat h0(numSamples, numOut, CV_32F), c0(numSamples, numOut, CV_32F);
+    rng.fill(h0, RNG::UNIFORM, -1, 1);
+    rng.fill(c0, RNG::UNIFORM, -1, 1);
+
+    int inpShape[] = {numTs, numSamples, numInp};
+    Mat inp(3, inpShape, CV_32F);
+    rng.fill(inp, RNG::UNIFORM, -1, 1);
+
+    Ptr<LSTMLayer> layer = LSTMLayer::create(LayerParams());
+    layer->setWeights(Wh, Wx, b);
+    layer->setProduceCellOutput(true);
+    layer->setH(h0);
+    layer->setC(c0);
+
+    std::vector<Mat> inputs(1, inp), outputs;
+    runLayer(layer, inputs, outputs);
+    ASSERT_EQ(2u, outputs.size());
+
+    Mat hRef, cRef;
+    referenceLSTM(inp, Wh, Wx, b, h0.clone(), c0.clone(), hRef, cRef);
+    normAssert(hRef, outputs[0], "h");
+    normAssert(cRef, outputs[1], "c");
+}
+
+//straightforward RNN: h_t = tanh(Wxh * x_t + Whh * h_{t-1} + bh), o_t = tanh(Who * h_t + bo)
+TEST(Layer_RNN_Test_Accuracy_with_, Reference)
+{
+    const int numTs = 4, numSamples = 3, numX = 7, numH = 261, numO = 19;
+    RNG rng(0);
+
+    Mat Wxh(numH, numX, CV_32F), bh(numH, 1, CV_32F), Whh(numH, numH, CV_32F);
+    Mat Who(numO, numH, CV_32F), bo(numO, 1, CV_32F);
+    rng.fill(Wxh, RNG::UNIFORM, -1, 1);
+    rng.fill(bh, RNG::UNIFORM, -1, 1);
+    rng.fill(Whh, RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(Who, RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(bo, RNG::UNIFORM, -1, 1);
+
+    int inpShape[] = {numTs, numSamples, numX};
+    Mat inp(3, inpShape, CV_32F);
+    rng.fill(inp, RNG::UNIFORM, -1, 1);
+
+    Ptr<RNNLayer> layer = RNNLayer::create(LayerParams());
+    layer->setWeights(Wxh, bh, Whh, Who, bo);
+    layer->setProduceHiddenOutput(true);
+
+    std::vector<Mat> inputs(1, inp), outputs;
+    runLayer(layer, inputs, outputs);
+    ASSERT_EQ(2u, outputs.size());
+
+    int oShape[] = {numTs, numSamples, numO}, hShape[] = {numTs, numSamples, numH};
+    Mat oRef(3, oShape, CV_32F), hRef(3, hShape, CV_32F);
+    Mat h = Mat::zeros(numSamples, numH, CV_32F);
+    for (int t = 0; t < numTs; t++)
+    {
+        Mat x(numSamples, numX, CV_32F, inp.ptr<float>(t));
+        Mat hOut(numSamples, numH, CV_32F, hRef.ptr<float>(t));
+        Mat oOut(numSamples, numO, CV_32F, oRef.ptr<float>(t));
+
+        h = x * Wxh.t() + h * Whh.t() + repeat(bh.t(), numSamples, 1);
+        for (int n = 0; n < numSamples; n++)
+            for (int j = 0; j < numH; j++)
+                h.at<float>(n, j) = std::tanh(h.at<float>(n, j));
+        h.copyTo(hOut);
+
+        Mat o = h * Who.t() + repeat(bo.t(), numSamples, 1);
+        for (int n = 0; n < numSamples; n++)
+            for (int j = 0; j < numO; j++)
+                o.at<float>(n, j) = std::tanh(o.at<float>(n, j));
+        o.copyTo(oOut);
+    }
+
+    normAssert(oRef, outputs[0], "o");
+    normAssert(hRef, outputs[1], "h");
+}
+
 class Layer_RNN_Test : public ::testing::Test
 {
 public:
@@ -523,6 +523,73 @@ class CV_EXPORTS TrackerModel
 
 };
 
+/************************************ Tracker Frame Context ************************************/
+
+/** @brief Images derived from a single frame, shared by all the trackers updated with this frame.
+
+The derived images are computed on the first request and cached while the context is alive, so
+several trackers updated with the same context don't repeat grayscale conversion, resizing, blurring,
+integral images and pyramids. The context may be used by trackers which are updated concurrently.
+Returned images must not be modified.
+ */
+class CV_EXPORTS TrackerFrameContext
+{
+ public:
+  /** @brief Constructor
+    @param image The frame, it must not be modified while the context is alive
+     */
+  explicit TrackerFrameContext( const Mat& image );
+
+  /** @brief The frame itself
+     */
+  Mat getImage() const;
+
+  /** @brief Grayscale frame
+    @param code Color conversion code, single-channel frames are returned as is
+     */
+  Mat getGray( int code = CV_BGR2GRAY );
+
+  /** @brief Resized frame
+    @param size Size of the result, the source image is returned as is if it has the same size
+    @param interpolation Interpolation method
+    @param code Color conversion code of the grayscale source image, negative value means the frame itself
+     */
+  Mat getResized( Size size, int interpolation = CV_INTER_LINEAR, int code = -1 );
+
+  /** @brief Resized grayscale frame smoothed by GaussianBlur with the default sigma
+    @param size Size of the result, see getResized()
+    @param ksize Gaussian kernel size
+    @param interpolation Interpolation method
+    @param code Color conversion code of the grayscale source image
+     */
+  Mat getBlurred( Size size, Size ksize, int interpolation = CV_INTER_LINEAR, int code = CV_BGR2GRAY );
+
+  /** @brief Integral image
+    @param sdepth Depth of the integral image, CV_32S, CV_32F or CV_64F
+    @param code Color conversion code of the grayscale source image, negative value means the frame itself
+     */
+  Mat getIntegral( int sdepth, int code = -1 );
+
+  /** @brief Integral image and integral image of squared pixel values
+    @param sum Integral image
+    @param sqsum Integral image of squared pixel values, always CV_64F
+    @param sdepth Depth of the integral image, CV_32S, CV_32F or CV_64F
+    @param code Color conversion code of the grayscale source image, negative value means the frame itself
+     */
+  void getIntegral( Mat& sum, Mat& sqsum, int sdepth, int code = -1 );
+
+  /** @brief Pyramid of the grayscale frame built by buildOpticalFlowPyramid (without derivatives)
+    @param winSize Window size of the optical flow algorithm
+    @param maxLevel 0-based maximal pyramid level number
+    @param code Color conversion code of the grayscale source image
+     */
+  std::vector<Mat> getPyramid( Size winSize, int maxLevel, int code = CV_BGR2GRAY );
+
+ private:
+  struct Impl;
+  Ptr<Impl> impl;
+};
+
 /************************************ Tracker Base Class ************************************/
 
 /** @brief Base abstract class for the long-term tracker:
@@ -552,6 +619,15 @@ class CV_EXPORTS_W Tracker : public virtual Algorithm
      */
   CV_WRAP bool update( const Mat& image, CV_OUT Rect2d& boundingBox );
 
+  /** @brief Update the tracker with a frame shared by several trackers
+    @param frame The current frame and the images derived from it, see TrackerFrameContext
+    @param boundingBox The boundig box that represent the new target location, see update()
+
+    The result is the same as the result of update() with the same frame, but the grayscale conversion,
+    pyramids and other preprocessing are computed once for all the trackers updated with this context.
+     */
+  bool update( TrackerFrameContext& frame, CV_OUT Rect2d& boundingBox );
+
   /** @brief Creates a tracker by its name.
     @param trackerType Tracker type
 
@@ -569,6 +645,9 @@ class CV_EXPORTS_W Tracker : public virtual Algorithm
 
   virtual bool initImpl( const Mat& image, const Rect2d& boundingBox ) = 0;
   virtual bool updateImpl( const Mat& image, Rect2d& boundingBox ) = 0;
+  /** @brief Update implementation which reuses the derived images, by default calls updateImpl() with the frame
+     */
+  virtual bool updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox );
 
   bool isInit;
 
@@ -1286,12 +1365,23 @@ public:
   @param parameters GOTURN parameters TrackerGOTURN::Params
   */
   BOILERPLATE_CODE("GOTURN", TrackerGOTURN);
+
+  /** @brief Updates several GOTURN trackers with a single forward pass of the network
+  @param trackers Initialized GOTURN trackers
+  @param image The current frame
+  @param boundingBoxes The new target locations, one per tracker
+
+  The patches of all the targets are stacked into one batch, so the network runs once per frame
+  instead of once per target. The results are the same as the results of the separate update() calls.
+  @return True if all the trackers were updated
+  */
+  static bool updateMultiple(const std::vector<Ptr<TrackerGOTURN> >& trackers, const Mat& image, std::vector<Rect2d>& boundingBoxes);
 };
 
 /************************************ MultiTracker Class ---By Laksono Kurnianggoro---) ************************************/
 /** @brief This class is used to track multiple objects using the specified tracker algorithm.
 * The MultiTracker is naive implementation of multiple object tracking.
-* It process the tracked objects independently without any optimization accross the tracked objects.
+* It process the tracked objects independently, only the preprocessing of the frame is shared (see TrackerFrameContext).
 */
 class CV_EXPORTS_W MultiTracker
 {
@@ -1357,12 +1447,25 @@ public:
   */
   CV_WRAP bool update(const Mat& image, CV_OUT std::vector<Rect2d> & boundingBox);
 
+  /**
+  * \brief Enable or disable the concurrent update of the trackers.
+  * Trackers are independent, so they are updated in parallel and the results don't depend on the number of
+  * threads. Trackers which use the global random number generator during the update (Boosting) are
+  * updated sequentially in the order they were added. GOTURN trackers are updated together by one
+  * batched forward of the network, see TrackerGOTURN::updateMultiple().
+  * @param enable true to update the trackers in parallel (disabled by default)
+  */
+  CV_WRAP void setParallelUpdate(bool enable);
+
 protected:
   //!<  storage for the tracker algorithms.
   std::vector< Ptr<Tracker> > trackerList;
 
   //!<  default algorithm for the tracking method.
   String defaultAlgorithm;
+
+  //!<  update the trackers concurrently, see setParallelUpdate()
+  bool parallelUpdate;
 };
 
 /************************************ Multi-Tracker Classes ---By Tyan Vladimir---************************************/
@@ -1379,6 +1482,7 @@ public:
   MultiTracker_Alt()
   {
     targetNum = 0;
+    parallelUpdate = false;
   }
 
   /** @brief Add a new target to a tracking-list and initialize the tracker with a know bounding box that surrounding the target
@@ -1399,6 +1503,14 @@ public:
   */
   bool update(const Mat& image);
 
+  /** @brief Enable or disable the concurrent update of the trackers
+
+  In the parallel mode all the trackers are updated even if some of them couldn't locate their targets,
+  the results don't depend on the number of threads. GOTURN trackers are updated by one batched forward.
+  @param enable true to update the trackers in parallel (disabled by default)
+  */
+  void setParallelUpdate(bool enable) { parallelUpdate = enable; }
+
   /** @brief Current number of targets in tracking-list
   */
   int targetNum;
@@ -1413,6 +1525,11 @@ public:
   /** @brief List of randomly generated colors for bounding boxes display
   */
   std::vector<Scalar> colors;
+
+protected:
+  /** @brief Update the trackers concurrently, see setParallelUpdate()
+  */
+  bool parallelUpdate;
 };
 
 /** @brief Multi Object Tracker for TLD. TLD is a novel tracking framework that explicitly decomposes
@@ -43,7 +43,8 @@
 #include <stdlib.h>
 
 namespace cv{
-  const double ColorNames[][10]={
+  // the table is indexed by 15-bit RGB codes: (r>>3) + 32*(g>>3) + 32*32*(b>>3)
+  const float ColorNames[][10]={
       {0.45975,0.014802,0.044289,-0.028193,0.001151,-0.0050145,0.34522,0.018362,0.23994,0.1689},
       {0.47157,0.021424,0.041444,-0.030215,0.0019002,-0.0029264,0.32875,0.0082059,0.2502,0.17007},
       {0.47098,0.042624,0.025014,-0.033501,0.0028958,-0.001415,0.29519,-0.0072627,0.26919,0.16947},
@@ -32813,4 +32814,48 @@ namespace cv{
       {0.0030858,-0.016151,0.013017,0.0072284,-0.53357,0.30985,0.0041336,-0.012531,0.00142,-0.33842},
       {0.0087778,-0.015645,0.004769,0.011785,-0.54199,0.31505,0.00020476,-0.020282,0.00021236,-0.34675}
   };
-}
\ No newline at end of file
+
+namespace tracking{
+  /*
+   * Converts rows of BGR patch to windowed ColorNames features
+   */
+  class ParallelExtractCN : public ParallelLoopBody {
+  public:
+    ParallelExtractCN(const Mat & _patch, const Mat & _window, Mat & _dest) : patch(_patch), window(_window), dest(_dest) {}
+
+    virtual void operator()(const Range& range) const {
+      for(int i=range.start;i<range.end;i++){
+        const uchar* src=patch.ptr<uchar>(i);
+        const double* win=window.ptr<double>(i);
+        double* dst=dest.ptr<double>(i);
+
+        for(int j=0;j<patch.cols;j++,src+=3,dst+=10){
+          // 15-bit color code, 5 most significant bits of every channel
+          const float* cn=ColorNames[(src[2]>>3)+((src[1]>>3)<<5)+((src[0]>>3)<<10)];
+          double w=win[j];
+          for(int _k=0;_k<10;_k++){
+            dst[_k]=cn[_k]*w;
+          }
+        }
+      }
+    }
+
+  private:
+    const Mat & patch;
+    const Mat & window;
+    Mat & dest;
+  };
+
+  /* Convert BGR to ColorNames
+   */
+  void extractColorNames(const Mat & patch_data, const Mat & window, Mat & cnFeatures) {
+    CV_Assert(patch_data.type() == CV_8UC3 && window.type() == CV_64F && patch_data.size() == window.size());
+
+    cnFeatures.create(patch_data.rows,patch_data.cols,CV_64FC(10));
+
+    // rows are processed in parallel only when there is enough work to split
+    int nstripes=patch_data.total() >= 64*64 ? patch_data.rows : 1;
+    parallel_for_(Range(0, patch_data.rows), ParallelExtractCN(patch_data, window, cnFeatures), nstripes);
+  }
+}
+}
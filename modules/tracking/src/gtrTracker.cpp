@@ -62,6 +62,52 @@ Ptr<TrackerGOTURN> TrackerGOTURN::createTracker(const TrackerGOTURN::Params &par
 #endif
 }
 
+bool TrackerGOTURN::updateMultiple(const std::vector<Ptr<TrackerGOTURN> >& trackers, const Mat& image, std::vector<Rect2d>& boundingBoxes)
+{
+#ifdef HAVE_OPENCV_DNN
+    const int n = (int)trackers.size();
+    boundingBoxes.resize(n);
+    if (n == 0)
+        return true;
+    if (image.empty())
+        return false;
+
+    std::vector<gtr::TrackerGOTURNImpl*> impls(n);
+    for (int i = 0; i < n; i++)
+    {
+        impls[i] = trackers[i].dynamicCast<gtr::TrackerGOTURNImpl>();
+        CV_Assert(impls[i] != NULL);
+        if (!trackers[i]->isInit)
+            return false;
+    }
+
+    std::vector<Mat> targetPatches(n), searchPatches(n);
+    std::vector<Rect2f> targetPatchRects(n);
+    for (int i = 0; i < n; i++)
+        impls[i]->preprocess(image, targetPatches[i], searchPatches[i], targetPatchRects[i]);
+
+    //All the trackers load the same network, one forward of the first one serves the whole batch
+    dnn::Net& net = impls[0]->net;
+    net.setBlob(".data1", dnn::blobFromImages(targetPatches));
+    net.setBlob(".data2", dnn::blobFromImages(searchPatches));
+
+    net.forward();
+    Mat resMat = net.getBlob("scale").reshape(1, n);
+
+    //The models share one copy of the current frame
+    Mat curFrame = image.clone();
+    for (int i = 0; i < n; i++)
+        boundingBoxes[i] = impls[i]->postprocess(resMat.ptr<float>(i), targetPatchRects[i], curFrame);
+
+    return true;
+#else
+    (void)(trackers);
+    (void)(image);
+    (void)(boundingBoxes);
+    CV_ErrorNoReturn(cv::Error::StsNotImplemented , "to use GOTURN, the tracking module needs to be built with opencv_dnn !");
+#endif
+}
+
 
 #ifdef HAVE_OPENCV_DNN
 namespace gtr
@@ -73,7 +119,8 @@ public:
     Rect2d getBoundingBox(){ return boundingBox_; }
     void setBoudingBox(Rect2d boundingBox){ boundingBox_ = boundingBox; }
     Mat getImage(){ return image_; }
-    void setImage(const Mat& image){ image.copyTo(image_); }
+    //The image is not copied, it must not be modified afterwards
+    void setImage(const Mat& image){ image_ = image; }
 protected:
     Rect2d boundingBox_;
     Mat image_;
@@ -100,7 +147,7 @@ bool TrackerGOTURNImpl::initImpl(const Mat& image, const Rect2d& boundingBox)
 {
     //Make a simple model from frame and bounding box
     model = Ptr<TrackerGOTURNModel>(new TrackerGOTURNModel(params));
-    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setImage(image.clone());
     ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setBoudingBox(boundingBox);
 
     //Load GOTURN architecture from *.prototxt and pretrained weights from *.caffemodel
@@ -126,20 +173,27 @@ bool TrackerGOTURNImpl::initImpl(const Mat& image, const Rect2d& boundingBox)
     return true;
 }
 
-bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
+//Crop of the frame extended by the replicated border, the same as the crop of the copyMakeBorder() result
+static Mat getReplicatedPatch(const Mat& frame, const Rect& roi)
+{
+    int x0 = std::min(std::max(roi.x, 0), frame.cols - 1), x1 = std::max(std::min(roi.x + roi.width, frame.cols), x0 + 1);
+    int y0 = std::min(std::max(roi.y, 0), frame.rows - 1), y1 = std::max(std::min(roi.y + roi.height, frame.rows), y0 + 1);
+    int left = std::max(x0 - roi.x, 0), right = std::max(roi.x + roi.width - x1, 0);
+    int top = std::max(y0 - roi.y, 0), bottom = std::max(roi.y + roi.height - y1, 0);
+
+    Mat padded;
+    copyMakeBorder(frame(Rect(x0, y0, x1 - x0, y1 - y0)), padded, top, bottom, left, right, BORDER_REPLICATE);
+    return padded(Rect(roi.x - x0 + left, roi.y - y0 + top, roi.width, roi.height)).clone();
+}
+
+void TrackerGOTURNImpl::preprocess(const Mat& curFrame, Mat& targetPatch, Mat& searchPatch, Rect2f& targetPatchRect)
 {
-    int INPUT_SIZE = 227;
     //Using prevFrame & prevBB from model and curFrame GOTURN calculating curBB
-    Mat curFrame = image.clone();
     Mat prevFrame = ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->getImage();
     Rect2d prevBB = ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    Rect2d curBB;
 
     float padTargetPatch = 2.0;
-    Rect2f searchPatchRect, targetPatchRect;
-    Point2f currCenter, prevCenter;
-    Mat prevFramePadded, curFramePadded;
-    Mat searchPatch, targetPatch;
+    Point2f prevCenter;
 
     prevCenter.x = (float)(prevBB.x + prevBB.width / 2);
     prevCenter.y = (float)(prevBB.y + prevBB.height / 2);
@@ -149,11 +203,13 @@ bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
     targetPatchRect.x = (float)(prevCenter.x - prevBB.width*padTargetPatch / 2.0 + targetPatchRect.width);
     targetPatchRect.y = (float)(prevCenter.y - prevBB.height*padTargetPatch / 2.0 + targetPatchRect.height);
 
-    copyMakeBorder(prevFrame, prevFramePadded, (int)targetPatchRect.height, (int)targetPatchRect.height, (int)targetPatchRect.width, (int)targetPatchRect.width, BORDER_REPLICATE);
-    targetPatch = prevFramePadded(targetPatchRect).clone();
-
-    copyMakeBorder(curFrame, curFramePadded, (int)targetPatchRect.height, (int)targetPatchRect.height, (int)targetPatchRect.width, (int)targetPatchRect.width, BORDER_REPLICATE);
-    searchPatch = curFramePadded(targetPatchRect).clone();
+    //targetPatchRect is given in the coordinates of the frame padded by its size,
+    //only the patch itself is padded instead of the whole frames
+    Rect patchRect = targetPatchRect;
+    patchRect.x -= (int)targetPatchRect.width;
+    patchRect.y -= (int)targetPatchRect.height;
+    targetPatch = getReplicatedPatch(prevFrame, patchRect);
+    searchPatch = getReplicatedPatch(curFrame, patchRect);
 
     //Preprocess
     //Resize
@@ -163,6 +219,28 @@ bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
     //Mean Subtract
     targetPatch = targetPatch - 128;
     searchPatch = searchPatch - 128;
+}
+
+Rect2d TrackerGOTURNImpl::postprocess(const float* res, const Rect2f& targetPatchRect, const Mat& curFrame)
+{
+    Rect2d curBB;
+    curBB.x = targetPatchRect.x + (res[0] * targetPatchRect.width / INPUT_SIZE) - targetPatchRect.width;
+    curBB.y = targetPatchRect.y + (res[1] * targetPatchRect.height / INPUT_SIZE) - targetPatchRect.height;
+    curBB.width = (res[2] - res[0]) * targetPatchRect.width / INPUT_SIZE;
+    curBB.height = (res[3] - res[1]) * targetPatchRect.height / INPUT_SIZE;
+
+    //Set new model image and BB from current frame
+    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setImage(curFrame);
+    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setBoudingBox(curBB);
+
+    return curBB;
+}
+
+bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
+{
+    Mat targetPatch, searchPatch;
+    Rect2f targetPatchRect;
+    preprocess(image, targetPatch, searchPatch, targetPatchRect);
 
     //Convert to Float type
     Mat targetBlob = dnn::blobFromImage(targetPatch);
@@ -174,17 +252,8 @@ bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
     net.forward();
     Mat resMat = net.getBlob("scale").reshape(1, 1);
 
-    curBB.x = targetPatchRect.x + (resMat.at<float>(0) * targetPatchRect.width / INPUT_SIZE) - targetPatchRect.width;
-    curBB.y = targetPatchRect.y + (resMat.at<float>(1) * targetPatchRect.height / INPUT_SIZE) - targetPatchRect.height;
-    curBB.width = (resMat.at<float>(2) - resMat.at<float>(0)) * targetPatchRect.width / INPUT_SIZE;
-    curBB.height = (resMat.at<float>(3) - resMat.at<float>(1)) * targetPatchRect.height / INPUT_SIZE;
-
     //Predicted BB
-    boundingBox = curBB;
-
-    //Set new model image and BB from current frame
-    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setImage(curFrame);
-    ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setBoudingBox(curBB);
+    boundingBox = postprocess(resMat.ptr<float>(), targetPatchRect, image.clone());
 
     return true;
 }
@@ -69,6 +69,13 @@ public:
     bool initImpl(const Mat& image, const Rect2d& boundingBox);
     bool updateImpl(const Mat& image, Rect2d& boundingBox);
 
+    //Network input patches of the target in the previous frame and of the search area in curFrame
+    void preprocess(const Mat& curFrame, Mat& targetPatch, Mat& searchPatch, Rect2f& targetPatchRect);
+    //Decodes the network output and moves the model to curFrame, which is kept without copying
+    Rect2d postprocess(const float* res, const Rect2f& targetPatchRect, const Mat& curFrame);
+
+    enum { INPUT_SIZE = 227 };
+
     TrackerGOTURN::Params params;
 
     dnn::Net net;
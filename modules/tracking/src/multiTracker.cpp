@@ -75,8 +75,12 @@ namespace cv
 
 	bool MultiTracker_Alt::update(const Mat& image)
 	{
+		TrackerFrameContext frame(image);
+		if (parallelUpdate)
+			return tracking::updateTrackers(trackers, frame, boundingBoxes);
+
 		for (int i = 0; i < (int)trackers.size(); i++)
-			if (!trackers[i]->update(image, boundingBoxes[i]))
+			if (!trackers[i]->update(frame, boundingBoxes[i]))
 				return false;
 
 		return true;
@@ -44,7 +44,7 @@
 namespace cv {
 
   // constructor
-  MultiTracker::MultiTracker(const String& trackerType):defaultAlgorithm(trackerType){};
+  MultiTracker::MultiTracker(const String& trackerType):defaultAlgorithm(trackerType),parallelUpdate(false){};
 
   // destructor
   MultiTracker::~MultiTracker(){};
@@ -104,8 +104,14 @@ namespace cv {
 
   // update position of the tracked objects, the result is stored in internal storage
   bool MultiTracker::update( const Mat& image){
+    TrackerFrameContext frame(image);
+    if(parallelUpdate){
+      tracking::updateTrackers(trackerList, frame, objects);
+      return true;
+    }
+
     for(unsigned i=0;i< trackerList.size(); i++){
-      trackerList[i]->update(image, objects[i]);
+      trackerList[i]->update(frame, objects[i]);
     }
     return true;
   };
@@ -117,4 +123,67 @@ namespace cv {
     return true;
   };
 
+  void MultiTracker::setParallelUpdate(bool enable){
+    parallelUpdate=enable;
+  }
+
+  namespace tracking {
+
+  class ParallelTrackersUpdate : public ParallelLoopBody{
+  public:
+    ParallelTrackersUpdate(const std::vector<Ptr<Tracker> >& _trackers, const std::vector<int>& _indices,
+                           TrackerFrameContext& _frame, std::vector<Rect2d>& _boundingBoxes, std::vector<uchar>& _located)
+      : trackers(_trackers), indices(_indices), frame(_frame), boundingBoxes(_boundingBoxes), located(_located){}
+
+    virtual void operator()(const Range& range) const{
+      for(int i=range.start;i<range.end;i++){
+        int idx=indices[i];
+        located[idx]=trackers[idx]->update(frame, boundingBoxes[idx]);
+      }
+    }
+
+  private:
+    const std::vector<Ptr<Tracker> >& trackers;
+    const std::vector<int>& indices;
+    TrackerFrameContext& frame;
+    std::vector<Rect2d>& boundingBoxes;
+    std::vector<uchar>& located;
+  };
+
+  bool updateTrackers( const std::vector<Ptr<Tracker> >& trackers, TrackerFrameContext& frame, std::vector<Rect2d>& boundingBoxes ){
+    CV_Assert(trackers.size() == boundingBoxes.size());
+
+    // online boosting draws from rand(), so its results depend on the order of the updates
+    // GOTURN targets share one batched forward of the network
+    std::vector<int> concurrent, sequential, batched;
+    std::vector<Ptr<TrackerGOTURN> > goturn;
+    for(int i=0;i<(int)trackers.size();i++){
+      if(trackers[i].dynamicCast<TrackerBoosting>())
+        sequential.push_back(i);
+      else if(trackers[i].dynamicCast<TrackerGOTURN>()){
+        batched.push_back(i);
+        goturn.push_back(trackers[i].dynamicCast<TrackerGOTURN>());
+      }
+      else
+        concurrent.push_back(i);
+    }
+
+    std::vector<uchar> located(trackers.size(), 0);
+    if(!goturn.empty()){
+      std::vector<Rect2d> goturnBoxes;
+      if(TrackerGOTURN::updateMultiple(goturn, frame.getImage(), goturnBoxes)){
+        for(size_t j=0;j<batched.size();j++){
+          boundingBoxes[batched[j]]=goturnBoxes[j];
+          located[batched[j]]=1;
+        }
+      }
+    }
+    parallel_for_(Range(0, (int)concurrent.size()), ParallelTrackersUpdate(trackers, concurrent, frame, boundingBoxes, located));
+    ParallelTrackersUpdate(trackers, sequential, frame, boundingBoxes, located)(Range(0, (int)sequential.size()));
+
+    return std::find(located.begin(), located.end(), 0) == located.end();
+  }
+
+  } /* namespace tracking */
+
 } /* namespace cv */
\ No newline at end of file
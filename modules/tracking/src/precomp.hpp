@@ -50,7 +50,7 @@
 
 namespace cv
 {
-	extern const double ColorNames[][10];
+	extern const float ColorNames[][10];
 
     namespace tracking {
 
@@ -101,6 +101,22 @@ namespace cv
         return success;
     }
 
+    /* Updates the trackers concurrently.
+     Every tracker writes only its own bounding box, so the results don't depend on the scheduling.
+     Trackers which draw from the global rand() during the update are updated sequentially.
+     GOTURN trackers are updated together by one batched forward of the network.
+     The images derived from the frame are computed once and shared through the context.
+     Returns true if all the targets were located.
+    */
+    bool updateTrackers( const std::vector<Ptr<Tracker> >& trackers, TrackerFrameContext& frame, std::vector<Rect2d>& boundingBoxes );
+
+    /* Converts a BGR patch to ColorNames features.
+     patch - CV_8UC3 patch,
+     window - CV_64F window of the patch size, the features of every pixel are multiplied by its value,
+     cnFeatures - CV_64FC(10) features.
+    */
+    CV_EXPORTS void extractColorNames( const Mat& patch, const Mat& window, Mat& cnFeatures );
+
     } // tracking
 } // cv
 
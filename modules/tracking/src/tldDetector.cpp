@@ -42,6 +42,7 @@
 #include "tldDetector.hpp"
 
 #include <opencv2/core/utility.hpp>
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -97,11 +98,8 @@ namespace cv
 			UMat devNCC(1, 2*MAX_EXAMPLES_IN_MODEL, CV_32FC1, ACCESS_RW, USAGE_ALLOCATE_DEVICE_MEMORY);
 
 
-			ocl::Kernel k;
-			ocl::ProgramSource src = ocl::tracking::tldDetector_oclsrc;
-			String error;
-			ocl::Program prog(src, String(), error);
-			k.create("NCC", prog);
+			// the program is compiled once and cached by the OpenCL context
+			ocl::Kernel k("NCC", ocl::tracking::tldDetector_oclsrc);
 			if (k.empty())
 				printf("Kernel create failed!!!\n");
 			k.args(
@@ -138,11 +136,7 @@ namespace cv
 			UMat devPosNCC(MAX_EXAMPLES_IN_MODEL, numOfPatches, CV_32FC1, ACCESS_RW, USAGE_ALLOCATE_DEVICE_MEMORY);
 			UMat devNegNCC(MAX_EXAMPLES_IN_MODEL, numOfPatches, CV_32FC1, ACCESS_RW, USAGE_ALLOCATE_DEVICE_MEMORY);
 
-			ocl::Kernel k;
-			ocl::ProgramSource src = ocl::tracking::tldDetector_oclsrc;
-			String error;
-			ocl::Program prog(src, String(), error);
-			k.create("batchNCC", prog);
+			ocl::Kernel k("batchNCC", ocl::tracking::tldDetector_oclsrc);
 			if (k.empty())
 				printf("Kernel create failed!!!\n");
 			k.args(
@@ -172,7 +166,7 @@ namespace cv
 				{
 					spr = std::max(spr, 0.5 * (posNCC.at<float>(id * 500 + i) + 1.0));
 					if ((int)(*timeStampsPositive)[i] <= med)
-						spc = std::max(spr, 0.5 * (posNCC.at<float>(id * 500 + i) + 1.0));
+						spc = std::max(spc, 0.5 * (posNCC.at<float>(id * 500 + i) + 1.0));
 				}
 				for (int i = 0; i < *negNum; i++)
 					smc = smr = std::max(smr, 0.5 * (negNCC.at<float>(id * 500 + i) + 1.0));
@@ -216,6 +210,160 @@ namespace cv
 			return splus / (sminus + splus);
 		}
 
+		// Candidates which are compared with a model sample at once, the sample is loaded only once for them
+		static const int NCC_BLOCK = 4;
+
+		static inline void patchSums(const uchar* patch, int& sum, int& sqsum)
+		{
+			sum = sqsum = 0;
+			for (int j = 0; j < STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE; j++)
+			{
+				sum += patch[j];
+				sqsum += patch[j] * patch[j];
+			}
+		}
+
+		// Dot products of the sample with NCC_BLOCK patches
+		static inline void dotProducts(const uchar* sample, const uchar* const* patches, int* prods)
+		{
+			const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+			int j = 0;
+#if CV_SIMD128
+			v_int32x4 acc[NCC_BLOCK];
+			for (int k = 0; k < NCC_BLOCK; k++)
+				acc[k] = v_setzero_s32();
+			for (; j <= N - 16; j += 16)
+			{
+				v_uint16x8 a0, a1;
+				v_expand(v_load(sample + j), a0, a1);
+				v_int16x8 sa0 = v_reinterpret_as_s16(a0), sa1 = v_reinterpret_as_s16(a1);
+				for (int k = 0; k < NCC_BLOCK; k++)
+				{
+					v_uint16x8 b0, b1;
+					v_expand(v_load(patches[k] + j), b0, b1);
+					acc[k] += v_dotprod(sa0, v_reinterpret_as_s16(b0)) + v_dotprod(sa1, v_reinterpret_as_s16(b1));
+				}
+			}
+			for (int k = 0; k < NCC_BLOCK; k++)
+				prods[k] = v_reduce_sum(acc[k]);
+#else
+			for (int k = 0; k < NCC_BLOCK; k++)
+				prods[k] = 0;
+#endif
+			for (; j < N; j++)
+				for (int k = 0; k < NCC_BLOCK; k++)
+					prods[k] += sample[j] * patches[k][j];
+		}
+
+		// Same as NCC() of the sample (s1, sq1) and the patch (s2, sq2)
+		static inline double nccFromSums(int prod, int s1, double sq1, int s2, double sq2)
+		{
+			const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+			return (sq2 == 0) ? sq1 / std::abs(sq1) : (prod - s1 * s2 / N) / sq1 / sq2;
+		}
+
+		// The NN-model samples are only appended, so the sums of the already known ones are kept
+		void TLDDetector::prepareNNModelSums()
+		{
+			const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+			for (int positive = 0; positive < 2; positive++)
+			{
+				const uchar* samples = positive ? posExp->data : negExp->data;
+				const int num = positive ? *posNum : *negNum;
+				std::vector<int>& sums = positive ? posSums : negSums;
+				std::vector<double>& norms = positive ? posNorms : negNorms;
+				for (int i = (int)sums.size(); i < num; i++)
+				{
+					int sum, sqsum;
+					patchSums(samples + i * N, sum, sqsum);
+					sums.push_back(sum);
+					norms.push_back(sqrt(std::max(0.0, sqsum - 1.0 * sum * sum / N)));
+				}
+			}
+		}
+
+		class BatchSrScParallelLoopBody : public cv::ParallelLoopBody
+		{
+		public:
+			BatchSrScParallelLoopBody(const TLDDetector* detector, const Mat_<uchar>& patches, int median,
+				double* resultSr, double* resultSc, int numOfPatches) :
+				detectorF(detector), patchesF(patches), medianF(median),
+				resultSrF(resultSr), resultScF(resultSc), numOfPatchesF(numOfPatches)
+			{
+			}
+
+			virtual void operator () (const cv::Range & r) const
+			{
+				const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+				const TLDDetector* d = detectorF;
+				const std::vector<int>& timeStamps = *d->timeStampsPositive;
+				for (int block = r.start; block < r.end; block++)
+				{
+					const int first = block * NCC_BLOCK, count = std::min(NCC_BLOCK, numOfPatchesF - first);
+					const uchar* patches[NCC_BLOCK];
+					int s2[NCC_BLOCK], prods[NCC_BLOCK];
+					double sq2[NCC_BLOCK], spr[NCC_BLOCK], spc[NCC_BLOCK], sm[NCC_BLOCK];
+					for (int k = 0; k < NCC_BLOCK; k++)
+					{
+						// the last block is filled up by its last patch
+						patches[k] = patchesF.ptr(first + std::min(k, count - 1));
+						int sqsum;
+						patchSums(patches[k], s2[k], sqsum);
+						sq2[k] = sqrt(std::max(0.0, sqsum - 1.0 * s2[k] * s2[k] / N));
+						spr[k] = spc[k] = sm[k] = 0.0;
+					}
+
+					for (int i = 0; i < *d->posNum; i++)
+					{
+						dotProducts(d->posExp->data + i * N, patches, prods);
+						const bool conservative = timeStamps[i] <= medianF;
+						for (int k = 0; k < count; k++)
+						{
+							double sim = 0.5 * (nccFromSums(prods[k], d->posSums[i], d->posNorms[i], s2[k], sq2[k]) + 1.0);
+							spr[k] = std::max(spr[k], sim);
+							if (conservative)
+								spc[k] = std::max(spc[k], sim);
+						}
+					}
+					for (int i = 0; i < *d->negNum; i++)
+					{
+						dotProducts(d->negExp->data + i * N, patches, prods);
+						for (int k = 0; k < count; k++)
+							sm[k] = std::max(sm[k], 0.5 * (nccFromSums(prods[k], d->negSums[i], d->negNorms[i], s2[k], sq2[k]) + 1.0));
+					}
+
+					for (int k = 0; k < count; k++)
+					{
+						resultSrF[first + k] = (spr[k] + sm[k] == 0.0) ? 0.0 : spr[k] / (sm[k] + spr[k]);
+						if (resultScF)
+							resultScF[first + k] = (spc[k] + sm[k] == 0.0) ? 0.0 : spc[k] / (sm[k] + spc[k]);
+					}
+				}
+			}
+
+		private:
+			const TLDDetector* detectorF;
+			const Mat_<uchar>& patchesF;
+			const int medianF;
+			double* resultSrF;
+			double* resultScF;
+			const int numOfPatchesF;
+		};
+
+		// Calculate Sr and Sc of the patches stored in the rows, the same values as Sr() and Sc() of every patch
+		void TLDDetector::batchSrSc(const Mat_<uchar>& patches, double *resultSr, double *resultSc, int numOfPatches)
+		{
+			CV_Assert(patches.isContinuous() && patches.cols == STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE);
+			CV_Assert(patches.rows >= numOfPatches);
+			if (numOfPatches <= 0)
+				return;
+
+			prepareNNModelSums();
+			int med = timeStampsPositive->empty() ? 0 : getMedian((*timeStampsPositive));
+			cv::parallel_for_(cv::Range(0, (numOfPatches + NCC_BLOCK - 1) / NCC_BLOCK),
+				BatchSrScParallelLoopBody(this, patches, med, resultSr, resultSc, numOfPatches));
+		}
+
 #ifdef HAVE_OPENCL
 		double TLDDetector::ocl_Sc(const Mat_<uchar>& patch)
 		{
@@ -227,11 +375,7 @@ namespace cv
 			UMat devNCC(1, 2 * MAX_EXAMPLES_IN_MODEL, CV_32FC1, ACCESS_RW, USAGE_ALLOCATE_DEVICE_MEMORY);
 
 
-			ocl::Kernel k;
-			ocl::ProgramSource src = ocl::tracking::tldDetector_oclsrc;
-			String error;
-			ocl::Program prog(src, String(), error);
-			k.create("NCC", prog);
+			ocl::Kernel k("NCC", ocl::tracking::tldDetector_oclsrc);
 			if (k.empty())
 				printf("Kernel create failed!!!\n");
 			k.args(
@@ -300,10 +444,10 @@ namespace cv
 
 		//Detection - returns most probable new target location (Max Sc)
 
-		class CalcScSrParallelLoopBody: public cv::ParallelLoopBody
+		class ResampleParallelLoopBody: public cv::ParallelLoopBody
 		{
 		public:
-			explicit CalcScSrParallelLoopBody (TLDDetector * detector, Size initSize):
+			explicit ResampleParallelLoopBody (TLDDetector * detector, Size initSize):
 				detectorF (detector),
 				initSizeF (initSize)
 			{
@@ -313,20 +457,18 @@ namespace cv
 			{
 				for (int ind = r.start; ind < r.end; ++ind)
 				{
+					Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE, detectorF->stdPatches.ptr(ind));
 					resample(detectorF->resized_imgs[detectorF->ensScaleIDs[ind]],
 						Rect2d(detectorF->ensBuffer[ind], initSizeF),
-						detectorF->standardPatches[ind]);
-
-					detectorF->scValues[ind] = detectorF->Sc (detectorF->standardPatches[ind]);
-					detectorF->srValues[ind] = detectorF->Sr (detectorF->standardPatches[ind]);
+						standardPatch);
 				}
 			}
 
 			TLDDetector * detectorF;
 			const Size initSizeF;
 		private:
-			CalcScSrParallelLoopBody (const CalcScSrParallelLoopBody&);
-			CalcScSrParallelLoopBody& operator= (const CalcScSrParallelLoopBody&);
+			ResampleParallelLoopBody (const ResampleParallelLoopBody&);
+			ResampleParallelLoopBody& operator= (const ResampleParallelLoopBody&);
 		};
 
 		bool TLDDetector::detect(const Mat& img, const Mat& imgBlurred, Rect2d& res, std::vector<LabeledPatch>& patches, Size initSize)
@@ -387,24 +529,16 @@ namespace cv
 				ensScaleIDs.push_back(varScaleIDs[i]);
 			}
 
-			//Batch preparation
-			srValues.resize (ensBuffer.size());
-			scValues.resize (ensBuffer.size());
-
-			//Carefully resize standard patches with reference-counted Mat members
-			const int oldPatchesSize = (int)standardPatches.size();
-			standardPatches.resize (ensBuffer.size());
-			if ((int)ensBuffer.size() > oldPatchesSize)
-			{
-				Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-				for (int i = oldPatchesSize; i < (int)ensBuffer.size(); ++i)
-				{
-					standardPatches[i] = standardPatch.clone();
-				}
-			}
+			//Batch preparation, the standard patches are stored in the rows of one buffer
+			const int numOfPatches = (int)ensBuffer.size();
+			srValues.resize (numOfPatches);
+			scValues.resize (numOfPatches);
+			stdPatches.create (std::max(numOfPatches, 1), STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE);
+			cv::parallel_for_ (cv::Range (0, numOfPatches), ResampleParallelLoopBody (this, initSize));
 
 			//Batch calculation
-			cv::parallel_for_ (cv::Range (0, (int)ensBuffer.size ()), CalcScSrParallelLoopBody (this, initSize));
+			if (numOfPatches > 0)
+				batchSrSc (stdPatches, &srValues[0], &scValues[0], numOfPatches);
 
 			//NN classification
 			for (int i = 0; i < (int)ensBuffer.size(); i++)
@@ -509,8 +643,7 @@ namespace cv
 			//Prepare batch of patches
 			int numOfPatches = (int)ensBuffer.size();
 			Mat_<uchar> stdPatches(numOfPatches, 225);
-			double *resultSr = new double[numOfPatches];
-			double *resultSc = new double[numOfPatches];
+			std::vector<double> resultSr(numOfPatches), resultSc(numOfPatches);
 
 			uchar *patchesData = stdPatches.data;
 			for (int i = 0; i < (int)ensBuffer.size(); i++)
@@ -521,7 +654,8 @@ namespace cv
 					patchesData[225*i+j] = stdPatchData[j];
 			}
 			//Calculate Sr and Sc batches
-			ocl_batchSrSc(stdPatches, resultSr, resultSc, numOfPatches);
+			if (numOfPatches > 0)
+				ocl_batchSrSc(stdPatches, &resultSr[0], &resultSc[0], numOfPatches);
 
 
 			for (int i = 0; i < (int)ensBuffer.size(); i++)
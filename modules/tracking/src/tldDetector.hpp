@@ -68,7 +68,8 @@ namespace cv
 
 
 
-		class TLDDetector
+		// Exported for the accuracy tests of the batched NN classification
+		class CV_EXPORTS TLDDetector
 		{
 		public:
 			TLDDetector(){}
@@ -77,6 +78,7 @@ namespace cv
 			void prepareClassifiers(int rowstep);
 			double Sr(const Mat_<uchar>& patch) const;
 			double Sc(const Mat_<uchar>& patch) const;
+			void batchSrSc(const Mat_<uchar>& patches, double *resultSr, double *resultSc, int numOfPatches);
 #ifdef HAVE_OPENCL
 			double ocl_Sr(const Mat_<uchar>& patch);
 			double ocl_Sc(const Mat_<uchar>& patch);
@@ -90,7 +92,12 @@ namespace cv
 			std::vector<int> *timeStampsPositive, *timeStampsNegative;
 			double *originalVariancePtr;
 			std::vector<double> scValues, srValues;
-			std::vector<Mat_<uchar> > standardPatches;
+			Mat_<uchar> stdPatches;
+
+			//Sums and norms (see NCC) of the NN-model samples, used by batchSrSc
+			std::vector<int> posSums, negSums;
+			std::vector<double> posNorms, negNorms;
+			void prepareNNModelSums();
 
 			std::vector <Mat> resized_imgs, blurred_imgs;
 			std::vector <Point> varBuffer, ensBuffer;
@@ -184,37 +184,23 @@ namespace cv
 
 		}
 
-		class CalcSrParallelLoopBody: public cv::ParallelLoopBody
-		{
-		public:
-			explicit CalcSrParallelLoopBody (TrackerTLDModel * model, const std::vector<Mat_<uchar> >& eForModel):
-				modelF (model),
-				eForModelF (eForModel)
-			{
-			}
-
-			virtual void operator () (const cv::Range & r) const
-			{
-				for (int ind = r.start; ind < r.end; ++ind)
-				{
-					modelF->srValues[ind] = modelF->detector->Sr (eForModelF[ind]);
-				}
-			}
-
-			TrackerTLDModel * modelF;
-			const std::vector<Mat_<uchar> >& eForModelF;
-		private:
-			CalcSrParallelLoopBody (const CalcSrParallelLoopBody&);
-			CalcSrParallelLoopBody& operator= (const CalcSrParallelLoopBody&);
-		};
-
 		void TrackerTLDModel::integrateAdditional(const std::vector<Mat_<uchar> >& eForModel, const std::vector<Mat_<uchar> >& eForEnsemble, bool isPositive)
 		{
 			int positiveIntoModel = 0, negativeIntoModel = 0, positiveIntoEnsemble = 0, negativeIntoEnsemble = 0;
 			if ((int)eForModel.size() == 0) return;
 
-			srValues.resize (eForModel.size ());
-			cv::parallel_for_ (cv::Range (0, (int)eForModel.size ()), CalcSrParallelLoopBody (this, eForModel));
+			//Prepare batch of patches
+			int numOfPatches = (int)eForModel.size();
+			Mat_<uchar> stdPatches(numOfPatches, STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE);
+			for (int i = 0; i < numOfPatches; i++)
+			{
+				Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE, stdPatches.ptr(i));
+				eForModel[i].copyTo(standardPatch);
+			}
+
+			//Calculate Sr batch, Sc is not needed
+			srValues.resize (numOfPatches);
+			detector->batchSrSc(stdPatches, &srValues[0], NULL, numOfPatches);
 
 			for (int k = 0; k < (int)eForModel.size(); k++)
 			{
@@ -257,8 +243,7 @@ namespace cv
 			//Prepare batch of patches
 			int numOfPatches = (int)eForModel.size();
 			Mat_<uchar> stdPatches(numOfPatches, 225);
-			double *resultSr = new double[numOfPatches];
-			double *resultSc = new double[numOfPatches];
+			std::vector<double> resultSr(numOfPatches), resultSc(numOfPatches);
 			uchar *patchesData = stdPatches.data;
 			for (int i = 0; i < numOfPatches; i++)
 			{
@@ -268,7 +253,7 @@ namespace cv
 			}
 
 			//Calculate Sr and Sc batches
-			detector->ocl_batchSrSc(stdPatches, resultSr, resultSc, numOfPatches);
+			detector->ocl_batchSrSc(stdPatches, &resultSr[0], &resultSc[0], numOfPatches);
 
 			for (int k = 0; k < (int)eForModel.size(); k++)
 			{
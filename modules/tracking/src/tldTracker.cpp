@@ -114,14 +114,20 @@ bool TrackerTLDImpl::initImpl(const Mat& image, const Rect2d& boundingBox)
 
 bool TrackerTLDImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
 {
-    Mat image_gray, image_blurred, imageForDetector;
-    cvtColor( image, image_gray, COLOR_BGR2GRAY );
+    TrackerFrameContext frame(image);
+    return updateWithContext(frame, boundingBox);
+}
+
+bool TrackerTLDImpl::updateWithContext(TrackerFrameContext& frame, Rect2d& boundingBox)
+{
+    Mat image = frame.getImage();
+    Mat image_gray = frame.getGray();
     double scale = data->getScale();
+    Size detectorSize = image.size();
     if( scale > 1.0 )
-        resize(image_gray, imageForDetector, Size(cvRound(image.cols*scale), cvRound(image.rows*scale)), 0, 0, DOWNSCALE_MODE);
-    else
-        imageForDetector = image_gray;
-    GaussianBlur(imageForDetector, image_blurred, GaussBlurKernelSize, 0.0);
+        detectorSize = Size(cvRound(image.cols*scale), cvRound(image.rows*scale));
+    Mat imageForDetector = frame.getResized(detectorSize, DOWNSCALE_MODE, COLOR_BGR2GRAY);
+    Mat image_blurred = frame.getBlurred(detectorSize, GaussBlurKernelSize, DOWNSCALE_MODE, COLOR_BGR2GRAY);
     TrackerTLDModel* tldModel = ((TrackerTLDModel*)static_cast<TrackerModel*>(model));
     data->frameNum++;
     Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
@@ -144,7 +150,7 @@ bool TrackerTLDImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
 #endif
 				DETECT_FLG = tldModel->detector->detect(imageForDetector, image_blurred, tmpCandid, detectorResults, tldModel->getMinSize());
 		}
-        if( ( (i == 0) && !data->failedLastTime && trackerProxy->update(image, tmpCandid) ) || ( DETECT_FLG))
+        if( ( (i == 0) && !data->failedLastTime && trackerProxy->update(frame, tmpCandid) ) || ( DETECT_FLG))
         {
             candidates.push_back(tmpCandid);
             if( i == 0 )
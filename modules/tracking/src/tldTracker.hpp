@@ -59,6 +59,7 @@ class TrackerProxy
 public:
 	virtual bool init(const Mat& image, const Rect2d& boundingBox) = 0;
 	virtual bool update(const Mat& image, Rect2d& boundingBox) = 0;
+	virtual bool update(TrackerFrameContext& frame, Rect2d& boundingBox) = 0;
 	virtual ~TrackerProxy(){}
 };
 
@@ -105,6 +106,10 @@ public:
 	{
 		return trackerPtr->update(image, boundingBox);
 	}
+	bool update(TrackerFrameContext& frame, Rect2d& boundingBox)
+	{
+		return trackerPtr->update(frame, boundingBox);
+	}
 private:
 	Ptr<T> trackerPtr;
 	Tparams params_;
@@ -161,6 +166,7 @@ public:
 
 	bool initImpl(const Mat& image, const Rect2d& boundingBox);
 	bool updateImpl(const Mat& image, Rect2d& boundingBox);
+	bool updateWithContext(TrackerFrameContext& frame, Rect2d& boundingBox);
 
 	TrackerTLD::Params params;
 	Ptr<Data> data;
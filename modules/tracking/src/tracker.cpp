@@ -40,6 +40,9 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/video/tracking.hpp"
+#include "opencv2/imgproc.hpp"
+#include <map>
 
 #undef BOILERPLATE_CODE
 #define BOILERPLATE_CODE(name,classname)\
@@ -50,6 +53,160 @@
 namespace cv
 {
 
+/*
+ *  TrackerFrameContext
+ */
+
+struct TrackerFrameContext::Impl
+{
+  // a derived image, computed by the first thread which requests it while the others wait for it
+  struct Entry
+  {
+    Entry() : ready( false ) {}
+
+    Mutex mutex;
+    bool ready;
+    std::vector<Mat> mats;
+  };
+
+  Mat image;
+  // the mutex guards the map only, the images are computed under the locks of their entries,
+  // so different images are computed concurrently
+  std::map<String, Ptr<Entry> > cache;
+  Mutex mutex;
+
+  Entry& entry( const String& key )
+  {
+    AutoLock lock( mutex );
+    Ptr<Entry>& e = cache[key];
+    if( e.empty() )
+      e = makePtr<Entry>();
+    return *e;
+  }
+
+  Mat gray( int code )
+  {
+    if( image.channels() == 1 )
+      return image;
+
+    Entry& e = entry( format( "gray %d", code ) );
+    AutoLock lock( e.mutex );
+    if( !e.ready )
+    {
+      e.mats.resize( 1 );
+      cvtColor( image, e.mats[0], code );
+      e.ready = true;
+    }
+    return e.mats[0];
+  }
+
+  Mat source( int code )
+  {
+    return code < 0 ? image : gray( code );
+  }
+
+  Mat resized( Size size, int interpolation, int code )
+  {
+    Mat src = source( code );
+    if( src.size() == size )
+      return src;
+
+    Entry& e = entry( format( "resized %dx%d %d %d", size.width, size.height, interpolation, code ) );
+    AutoLock lock( e.mutex );
+    if( !e.ready )
+    {
+      e.mats.resize( 1 );
+      resize( src, e.mats[0], size, 0, 0, interpolation );
+      e.ready = true;
+    }
+    return e.mats[0];
+  }
+
+  Mat blurred( Size size, Size ksize, int interpolation, int code )
+  {
+    Entry& e = entry( format( "blurred %dx%d %dx%d %d %d", size.width, size.height, ksize.width, ksize.height, interpolation, code ) );
+    AutoLock lock( e.mutex );
+    if( !e.ready )
+    {
+      e.mats.resize( 1 );
+      GaussianBlur( resized( size, interpolation, code ), e.mats[0], ksize, 0.0 );
+      e.ready = true;
+    }
+    return e.mats[0];
+  }
+
+  std::vector<Mat> integral( int sdepth, int code, bool squared )
+  {
+    Entry& e = entry( format( "integral %d %d %d", sdepth, code, (int)squared ) );
+    AutoLock lock( e.mutex );
+    if( !e.ready )
+    {
+      e.mats.resize( squared ? 2 : 1 );
+      if( squared )
+        cv::integral( source( code ), e.mats[0], e.mats[1], sdepth, CV_64F );
+      else
+        cv::integral( source( code ), e.mats[0], sdepth );
+      e.ready = true;
+    }
+    return e.mats;
+  }
+
+  std::vector<Mat> pyramid( Size winSize, int maxLevel, int code )
+  {
+    Entry& e = entry( format( "pyramid %dx%d %d %d", winSize.width, winSize.height, maxLevel, code ) );
+    AutoLock lock( e.mutex );
+    if( !e.ready )
+    {
+      // never reuse the frame memory, the levels may outlive the context
+      buildOpticalFlowPyramid( gray( code ), e.mats, winSize, maxLevel, false, BORDER_REFLECT_101, BORDER_CONSTANT, false );
+      e.ready = true;
+    }
+    return e.mats;
+  }
+};
+
+TrackerFrameContext::TrackerFrameContext( const Mat& image ) : impl( new Impl )
+{
+  impl->image = image;
+}
+
+Mat TrackerFrameContext::getImage() const
+{
+  return impl->image;
+}
+
+Mat TrackerFrameContext::getGray( int code )
+{
+  return impl->gray( code );
+}
+
+Mat TrackerFrameContext::getResized( Size size, int interpolation, int code )
+{
+  return impl->resized( size, interpolation, code );
+}
+
+Mat TrackerFrameContext::getBlurred( Size size, Size ksize, int interpolation, int code )
+{
+  return impl->blurred( size, ksize, interpolation, code );
+}
+
+Mat TrackerFrameContext::getIntegral( int sdepth, int code )
+{
+  return impl->integral( sdepth, code, false )[0];
+}
+
+void TrackerFrameContext::getIntegral( Mat& sum, Mat& sqsum, int sdepth, int code )
+{
+  std::vector<Mat> entry = impl->integral( sdepth, code, true );
+  sum = entry[0];
+  sqsum = entry[1];
+}
+
+std::vector<Mat> TrackerFrameContext::getPyramid( Size winSize, int maxLevel, int code )
+{
+  return impl->pyramid( winSize, maxLevel, code );
+}
+
 /*
  *  Tracker
  */
@@ -104,6 +261,25 @@ bool Tracker::update( const Mat& image, Rect2d& boundingBox )
   return updateImpl( image, boundingBox );
 }
 
+bool Tracker::update( TrackerFrameContext& frame, Rect2d& boundingBox )
+{
+
+  if( !isInit )
+  {
+    return false;
+  }
+
+  if( frame.getImage().empty() )
+    return false;
+
+  return updateWithContext( frame, boundingBox );
+}
+
+bool Tracker::updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox )
+{
+  return updateImpl( frame.getImage(), boundingBox );
+}
+
 Ptr<Tracker> Tracker::create( const String& trackerType )
 {
   BOILERPLATE_CODE("MIL",TrackerMIL);
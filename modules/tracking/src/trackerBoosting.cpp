@@ -56,6 +56,7 @@ class TrackerBoostingImpl : public TrackerBoosting
 
   bool initImpl( const Mat& image, const Rect2d& boundingBox );
   bool updateImpl( const Mat& image, Rect2d& boundingBox );
+  bool updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox );
 
   TrackerBoosting::Params params;
 };
@@ -202,11 +203,13 @@ bool TrackerBoostingImpl::initImpl( const Mat& image, const Rect2d& boundingBox
 
 bool TrackerBoostingImpl::updateImpl( const Mat& image, Rect2d& boundingBox )
 {
-  Mat_<int> intImage;
-  Mat_<double> intSqImage;
-  Mat image_;
-  cvtColor( image, image_, CV_RGB2GRAY );
-  integral( image_, intImage, intSqImage, CV_32S );
+  TrackerFrameContext frame( image );
+  return updateWithContext( frame, boundingBox );
+}
+
+bool TrackerBoostingImpl::updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox )
+{
+  Mat_<int> intImage = frame.getIntegral( CV_32S, CV_RGB2GRAY );
   //get the last location [AAM] X(k-1)
   Ptr<TrackerTargetState> lastLocation = model->getLastTargetState();
   Rect lastBoundingBox( (int)lastLocation->getTargetPosition().x, (int)lastLocation->getTargetPosition().y, lastLocation->getTargetWidth(),
@@ -81,6 +81,7 @@ namespace cv{
     */
     bool initImpl( const Mat& /*image*/, const Rect2d& boundingBox );
     bool updateImpl( const Mat& image, Rect2d& boundingBox );
+    bool updateWithContext( TrackerFrameContext& context, Rect2d& boundingBox );
 
     TrackerKCF::Params params;
 
@@ -91,16 +92,15 @@ namespace cv{
     void inline fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const;
     void inline fft2(const Mat src, Mat & dest) const;
     void inline ifft2(const Mat src, Mat & dest) const;
-    void inline pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB=false) const;
-    void inline sumChannels(std::vector<Mat> src, Mat & dest) const;
+    void inline pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat> & dest, const int flags, const bool conjB=false) const;
+    void inline sumChannels(const std::vector<Mat> & src, Mat & dest) const;
     void inline updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix,double pca_rate, int compressed_sz,
                                        std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat v) const;
     void inline compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const;
     bool getSubWindow(const Mat img, const Rect roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc = GRAY) const;
     bool getSubWindow(const Mat img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const;
-    void extractCN(Mat patch_data, Mat & cnFeatures) const;
     void denseGaussKernel(const double sigma, const Mat , const Mat y_data, Mat & k_data,
-                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const;
+                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> & xyf_v, Mat & xy, Mat & xyf ) const;
     void calcResponse(const Mat alphaf_data, const Mat kf_data, Mat & response_data, Mat & spec_data) const;
     void calcResponse(const Mat alphaf_data, const Mat alphaf_den_data, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const;
 
@@ -112,7 +112,6 @@ namespace cv{
     double output_sigma;
     Rect2d roi;
     Mat hann; 	//hann window filter
-    Mat hann_cn; //10 dimensional hann-window filter for CN features,
 
     Mat y,yf; 	// training response and its FFT
     Mat x; 	// observation and its FFT
@@ -127,7 +126,7 @@ namespace cv{
     // pre-defined Mat variables for optimization of private functions
     Mat spec, spec2;
     std::vector<Mat> layers;
-    std::vector<Mat> vxf,vyf,vxyf;
+    std::vector<Mat> vxf,vyf,vxyf; // per-channel spectra in the packed CCS format, reused between frames
     Mat xy_data,xyf_data;
     Mat data_temp, compress_data;
     std::vector<Mat> layers_pca_data;
@@ -214,10 +213,6 @@ namespace cv{
     // initialize the hann window filter
     createHanningWindow(hann, roi.size(), CV_64F);
 
-    // hann window filter for CN feature
-    Mat _layer[] = {hann, hann, hann, hann, hann, hann, hann, hann, hann, hann};
-    merge(_layer, 10, hann_cn);
-
     // create gaussian response
     y=Mat::zeros((int)roi.height,(int)roi.width,CV_64F);
     for(unsigned i=0;i<roi.height;i++){
@@ -268,15 +263,20 @@ namespace cv{
    * Main part of the KCF algorithm
    */
   bool TrackerKCFImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
+    TrackerFrameContext context(image);
+    return updateWithContext(context, boundingBox);
+  }
+
+  bool TrackerKCFImpl::updateWithContext( TrackerFrameContext& context, Rect2d& boundingBox ){
     double minVal, maxVal;	// min-max response
     Point minLoc,maxLoc;	// min-max location
 
-    Mat img=image.clone();
+    Mat img=context.getImage();
     // check the channels of the input image, grayscale is preferred
     CV_Assert(img.channels() == 1 || img.channels() == 3);
 
-    // resize the image whenever needed
-    if(resizeImage)resize(img,img,Size(img.cols/2,img.rows/2));
+    // resize the image whenever needed, the shared context keeps the result for the other trackers
+    if(resizeImage)img=context.getResized(Size(img.cols/2,img.rows/2));
 
     // detection part
     if(frame>0){
@@ -494,12 +494,31 @@ namespace cv{
     dft(src,dest,DFT_COMPLEX_OUTPUT);
   }
 
+  /*
+   * transforms every channel of a real multi-channel Mat into a packed CCS spectrum,
+   * channels are transformed in parallel
+   */
+  class ParallelFFT2 : public ParallelLoopBody {
+  public:
+    ParallelFFT2(const std::vector<Mat> & _src, std::vector<Mat> & _dest) : src(_src), dest(_dest) {}
+
+    virtual void operator()(const Range& range) const {
+      for(int i=range.start;i<range.end;i++){
+        dft(src[i],dest[i]);
+      }
+    }
+
+  private:
+    const std::vector<Mat> & src;
+    std::vector<Mat> & dest;
+  };
+
   void inline TrackerKCFImpl::fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const {
     split(src, layers_data);
 
-    for(int i=0;i<src.channels();i++){
-      dft(layers_data[i],dest[i],DFT_COMPLEX_OUTPUT);
-    }
+    // spectra of the previous frame have the same size, so dft() doesn't reallocate them
+    dest.resize(src.channels());
+    parallel_for_(Range(0, src.channels()), ParallelFFT2(layers_data, dest));
   }
 
   /*
@@ -512,19 +531,37 @@ namespace cv{
   /*
    * Point-wise multiplication of two Multichannel Mat data
    */
-  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB) const {
-    for(unsigned i=0;i<src1.size();i++){
-      mulSpectrums(src1[i], src2[i], dest[i],flags,conjB);
+  class ParallelMulSpectrums : public ParallelLoopBody {
+  public:
+    ParallelMulSpectrums(const std::vector<Mat> & _src1, const std::vector<Mat> & _src2, std::vector<Mat> & _dest, int _flags, bool _conjB)
+      : src1(_src1), src2(_src2), dest(_dest), flags(_flags), conjB(_conjB) {}
+
+    virtual void operator()(const Range& range) const {
+      for(int i=range.start;i<range.end;i++){
+        mulSpectrums(src1[i], src2[i], dest[i], flags, conjB);
+      }
     }
+
+  private:
+    const std::vector<Mat> & src1;
+    const std::vector<Mat> & src2;
+    std::vector<Mat> & dest;
+    int flags;
+    bool conjB;
+  };
+
+  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat> & dest, const int flags, const bool conjB) const {
+    dest.resize(src1.size());
+    parallel_for_(Range(0, (int)src1.size()), ParallelMulSpectrums(src1, src2, dest, flags, conjB));
   }
 
   /*
    * Combines all channels in a multi-channels Mat data into a single channel
    */
-  void inline TrackerKCFImpl::sumChannels(std::vector<Mat> src, Mat & dest) const {
-    dest=src[0].clone();
+  void inline TrackerKCFImpl::sumChannels(const std::vector<Mat> & src, Mat & dest) const {
+    src[0].copyTo(dest);
     for(unsigned i=1;i<src.size();i++){
-      dest+=src[i];
+      add(dest, src[i], dest);
     }
   }
 
@@ -607,8 +644,7 @@ namespace cv{
     switch(desc){
       case CN:
         CV_Assert(img.channels() == 3);
-        extractCN(patch,feat);
-        feat=feat.mul(hann_cn); // hann window filter
+        tracking::extractColorNames(patch,hann,feat); // hann window filter is applied during the extraction
         break;
       default: // GRAY
         if(img.channels()>1)
@@ -657,45 +693,48 @@ namespace cv{
     return true;
   }
 
-  /* Convert BGR to ColorNames
-   */
-  void TrackerKCFImpl::extractCN(Mat patch_data, Mat & cnFeatures) const {
-    Vec3b & pixel = patch_data.at<Vec3b>(0,0);
-    unsigned index;
-
-    if(cnFeatures.type() != CV_64FC(10))
-      cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_64FC(10));
-
-    for(int i=0;i<patch_data.rows;i++){
-      for(int j=0;j<patch_data.cols;j++){
-        pixel=patch_data.at<Vec3b>(i,j);
-        index=(unsigned)(floor((float)pixel[2]/8)+32*floor((float)pixel[1]/8)+32*32*floor((float)pixel[0]/8));
-
-        //copy the values
-        for(int _k=0;_k<10;_k++){
-          cnFeatures.at<Vec<double,10> >(i,j)[_k]=ColorNames[index][_k];
-        }
-      }
-    }
-
-  }
-
   /*
    *  dense gauss kernel function
    */
   void TrackerKCFImpl::denseGaussKernel(const double sigma, const Mat x_data, const Mat y_data, Mat & k_data,
-                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const {
+                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> & xyf_v, Mat & xy, Mat & xyf ) const {
     double normX, normY;
 
-    fft2(x_data,xf_data,layers_data);
-    fft2(y_data,yf_data,layers_data);
-
     normX=norm(x_data);
     normX*=normX;
-    normY=norm(y_data);
-    normY*=normY;
 
-    pixelWiseMult(xf_data,yf_data,xyf_v,0,true);
+    if(useOptimized()){
+      // the spectra are packed (CCS), the correlation of real signals doesn't need the complex ones
+      fft2(x_data,xf_data,layers_data);
+
+      // autocorrelation during the training reuses the spectra of x
+      bool autocorrelation = y_data.data == x_data.data;
+      if(autocorrelation){
+        normY=normX;
+      }else{
+        fft2(y_data,yf_data,layers_data);
+        normY=norm(y_data);
+        normY*=normY;
+      }
+
+      pixelWiseMult(xf_data,autocorrelation ? xf_data : yf_data,xyf_v,0,true);
+    }else{
+      // reference path: complex spectra of both signals, channel by channel
+      std::vector<Mat> x_layers, y_layers;
+      split(x_data, x_layers);
+      split(y_data, y_layers);
+      normY=norm(y_data);
+      normY*=normY;
+
+      xyf_v.resize(x_layers.size());
+      for(unsigned i=0;i<x_layers.size();i++){
+        Mat xf_layer, yf_layer;
+        dft(x_layers[i],xf_layer,DFT_COMPLEX_OUTPUT);
+        dft(y_layers[i],yf_layer,DFT_COMPLEX_OUTPUT);
+        mulSpectrums(xf_layer,yf_layer,xyf_v[i],0,true);
+      }
+    }
+
     sumChannels(xyf_v,xyf);
     ifft2(xyf,xyf);
 
@@ -704,19 +743,11 @@ namespace cv{
       shiftCols(xyf, x_data.cols/2);
     }
 
-    //(xx + yy - 2 * xy) / numel(x)
-    xy=(normX+normY-2*xyf)/(x_data.rows*x_data.cols*x_data.channels());
-
-    // TODO: check wether we really need thresholding or not
-    //threshold(xy,xy,0.0,0.0,THRESH_TOZERO);//max(0, (xx + yy - 2 * xy) / numel(x))
-    for(int i=0;i<xy.rows;i++){
-      for(int j=0;j<xy.cols;j++){
-        if(xy.at<double>(i,j)<0.0)xy.at<double>(i,j)=0.0;
-      }
-    }
-
+    //exp(-max(0, (xx + yy - 2 * xy) / numel(x)) / sigma^2), computed in place
     double sig=-1.0/(sigma*sigma);
-    xy=sig*xy;
+    double numel=x_data.rows*x_data.cols*x_data.channels();
+    xyf.convertTo(xy, CV_64F, -2.0*sig/numel, (normX+normY)*sig/numel);
+    min(xy, 0.0, xy);
     exp(xy,k_data);
 
   }
@@ -56,7 +56,9 @@ class TrackerMILImpl : public TrackerMIL
 
   bool initImpl( const Mat& image, const Rect2d& boundingBox );
   bool updateImpl( const Mat& image, Rect2d& boundingBox );
+  bool updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox );
   void compute_integral( const Mat & img, Mat & ii_img );
+  void compute_integral( TrackerFrameContext& frame, Mat & ii_img );
 
   TrackerMIL::Params params;
 };
@@ -126,11 +128,18 @@ void TrackerMILImpl::write( cv::FileStorage& fs ) const
 
 void TrackerMILImpl::compute_integral( const Mat & img, Mat & ii_img )
 {
-  Mat ii;
-  std::vector<Mat> ii_imgs;
-  integral( img, ii, CV_32F );
-  split( ii, ii_imgs );
-  ii_img = ii_imgs[0];
+  TrackerFrameContext frame( img );
+  compute_integral( frame, ii_img );
+}
+
+void TrackerMILImpl::compute_integral( TrackerFrameContext& frame, Mat & ii_img )
+{
+  // integral image of the first channel, the integral of the frame is shared with other trackers
+  Mat ii = frame.getIntegral( CV_32F );
+  if( ii.channels() == 1 )
+    ii_img = ii;
+  else
+    extractChannel( ii, ii_img, 0 );
 }
 
 bool TrackerMILImpl::initImpl( const Mat& image, const Rect2d& boundingBox )
@@ -196,9 +205,15 @@ bool TrackerMILImpl::initImpl( const Mat& image, const Rect2d& boundingBox )
 }
 
 bool TrackerMILImpl::updateImpl( const Mat& image, Rect2d& boundingBox )
+{
+  TrackerFrameContext frame( image );
+  return updateWithContext( frame, boundingBox );
+}
+
+bool TrackerMILImpl::updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox )
 {
   Mat intImage;
-  compute_integral( image, intImage );
+  compute_integral( frame, intImage );
 
   //get the last location [AAM] X(k-1)
   Ptr<TrackerTargetState> lastLocation = model->getLastTargetState();
@@ -79,7 +79,8 @@ public:
 private:
     bool initImpl( const Mat& image, const Rect2d& boundingBox );
     bool updateImpl( const Mat& image, Rect2d& boundingBox );
-    bool medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox);
+    bool updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox );
+    bool medianFlowImpl(const std::vector<Mat>& oldImagePyr,const std::vector<Mat>& newImagePyr,Rect2d& oldBox);
     Rect2d vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD);
     float dist(Point2f p1,Point2f p2);
     std::string type2str(int type);
@@ -125,11 +126,12 @@ public:
     TrackerMedianFlowModel(TrackerMedianFlow::Params /*params*/){}
     Rect2d getBoundingBox(){return boundingBox_;}
     void setBoudingBox(Rect2d boundingBox){boundingBox_=boundingBox;}
-    Mat getImage(){return image_;}
-    void setImage(const Mat& image){image.copyTo(image_);}
+    const std::vector<Mat>& getPyramid(){return pyramid_;}
+    // the pyramid owns its levels (they are copied into the bordered buffers), so the frame is not referenced
+    void setPyramid(const std::vector<Mat>& pyramid){pyramid_=pyramid;}
 protected:
     Rect2d boundingBox_;
-    Mat image_;
+    std::vector<Mat> pyramid_;
     void modelEstimationImpl( const std::vector<Mat>& /*responses*/ ){}
     void modelUpdateImpl(){}
 };
@@ -146,20 +148,27 @@ void TrackerMedianFlowImpl::write( cv::FileStorage& fs ) const
 
 bool TrackerMedianFlowImpl::initImpl( const Mat& image, const Rect2d& boundingBox ){
     model=Ptr<TrackerMedianFlowModel>(new TrackerMedianFlowModel(params));
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    TrackerFrameContext frame(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setPyramid(frame.getPyramid(params.winSize, params.maxLevel));
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(boundingBox);
     return true;
 }
 
 bool TrackerMedianFlowImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
-    Mat oldImage=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getImage();
+    TrackerFrameContext frame(image);
+    return updateWithContext(frame, boundingBox);
+}
+
+bool TrackerMedianFlowImpl::updateWithContext( TrackerFrameContext& frame, Rect2d& boundingBox ){
+    const std::vector<Mat>& oldImagePyr=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getPyramid();
+    std::vector<Mat> newImagePyr=frame.getPyramid(params.winSize, params.maxLevel);
 
     Rect2d oldBox=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    if(!medianFlowImpl(oldImage,image,oldBox)){
+    if(!medianFlowImpl(oldImagePyr,newImagePyr,oldBox)){
         return false;
     }
     boundingBox=oldBox;
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setPyramid(newImagePyr);
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(oldBox);
     return true;
 }
@@ -197,19 +206,12 @@ size_t filterPointsInVectors(std::vector<T>& status, std::vector<Point2f>& vec1,
     return first_bad_idx;
 }
 
-bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox){
+bool TrackerMedianFlowImpl::medianFlowImpl(const std::vector<Mat>& oldImagePyr,const std::vector<Mat>& newImagePyr,Rect2d& oldBox){
     std::vector<Point2f> pointsToTrackOld,pointsToTrackNew;
 
-    Mat oldImage_gray,newImage_gray;
-    if (oldImage.channels() != 1)
-        cvtColor( oldImage, oldImage_gray, COLOR_BGR2GRAY );
-    else
-        oldImage.copyTo(oldImage_gray);
-
-    if (newImage.channels() != 1)
-        cvtColor( newImage, newImage_gray, COLOR_BGR2GRAY );
-    else
-        newImage.copyTo(newImage_gray);
+    // the base level of the pyramid is the grayscale image itself
+    const Mat& oldImage_gray=oldImagePyr[0];
+    const Mat& newImage_gray=newImagePyr[0];
 
     //"open ended" grid
     for(int i=0;i<params.pointsInGrid;i++){
@@ -223,12 +225,6 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
     std::vector<uchar> status(pointsToTrackOld.size());
     std::vector<float> errors(pointsToTrackOld.size());
 
-    std::vector<Mat> oldImagePyr;
-    buildOpticalFlowPyramid(oldImage_gray, oldImagePyr, params.winSize, params.maxLevel, false);
-
-    std::vector<Mat> newImagePyr;
-    buildOpticalFlowPyramid(newImage_gray, newImagePyr, params.winSize, params.maxLevel, false);
-
     calcOpticalFlowPyrLK(oldImagePyr,newImagePyr,pointsToTrackOld,pointsToTrackNew,status,errors,
                          params.winSize, params.maxLevel, params.termCriteria, 0);
 
@@ -0,0 +1,107 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2017, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+#include "../src/precomp.hpp"
+
+using namespace cv;
+
+// the color codes of the pixels with every channel below 16
+static const unsigned oldIndices[] = {0, 1, 32, 33, 1024, 1025, 1056, 1057};
+
+// the rows at these codes of the double ColorNames table the float one replaced
+static const double oldColorNames[][10] = {
+    {0.45975,0.014802,0.044289,-0.028193,0.001151,-0.0050145,0.34522,0.018362,0.23994,0.1689},
+    {0.47157,0.021424,0.041444,-0.030215,0.0019002,-0.0029264,0.32875,0.0082059,0.2502,0.17007},
+    {0.45189,0.016535,0.061726,-0.027316,0.0012303,-0.0041319,0.32553,0.027836,0.22868,0.16959},
+    {0.46226,0.023961,0.051722,-0.028453,0.0015605,-0.0028334,0.30868,0.015618,0.24439,0.1701},
+    {0.46155,0.016194,0.041011,-0.030696,0.0017903,-0.0035989,0.34279,0.010131,0.24645,0.16975},
+    {0.47039,0.022371,0.034269,-0.033667,0.0022674,-0.0017498,0.32786,-0.001591,0.25831,0.1708},
+    {0.46278,0.017858,0.047327,-0.029713,0.0016388,-0.0029173,0.32792,0.013495,0.24459,0.17032},
+    {0.47291,0.024266,0.038023,-0.031176,0.0019589,-0.001536,0.31359,0.0027013,0.25823,0.17096}
+};
+
+// the CN extraction of KCF before the float table: float divisions for the color code,
+// then the window merged to 10 channels and multiplied with the features
+static void extractColorNamesOld(const Mat& patch, const Mat& window, Mat& cnFeatures)
+{
+    const int nIndices = (int)(sizeof(oldIndices) / sizeof(oldIndices[0]));
+    cnFeatures = Mat::zeros(patch.rows, patch.cols, CV_64FC(10));
+    for (int i = 0; i < patch.rows; i++)
+    {
+        for (int j = 0; j < patch.cols; j++)
+        {
+            Vec3b pixel = patch.at<Vec3b>(i, j);
+            unsigned index = (unsigned)(floor((float)pixel[2] / 8) + 32 * floor((float)pixel[1] / 8) + 32 * 32 * floor((float)pixel[0] / 8));
+            int row = (int)(std::find(oldIndices, oldIndices + nIndices, index) - oldIndices);
+            CV_Assert(row < nIndices);
+            for (int k = 0; k < 10; k++)
+                cnFeatures.at<Vec<double, 10> >(i, j)[k] = oldColorNames[row][k];
+        }
+    }
+
+    Mat layers[] = {window, window, window, window, window, window, window, window, window, window};
+    Mat window_cn;
+    merge(layers, 10, window_cn);
+    cnFeatures = cnFeatures.mul(window_cn);
+}
+
+TEST(KCF, ColorNames_Match_Double_Table)
+{
+    // the second size is large enough for the rows to be extracted in parallel
+    const Size sizes[] = {Size(16, 12), Size(80, 72)};
+    RNG rng(0);
+    for (int s = 0; s < 2; s++)
+    {
+        Mat patch(sizes[s], CV_8UC3), window;
+        rng.fill(patch, RNG::UNIFORM, 0, 16);
+        createHanningWindow(window, patch.size(), CV_64F);
+
+        Mat ref, cn;
+        extractColorNamesOld(patch, window, ref);
+        tracking::extractColorNames(patch, window, cn);
+
+        ASSERT_EQ(ref.type(), cn.type());
+        ASSERT_EQ(ref.size(), cn.size());
+        // the float table differs from the double one by rounding only
+        EXPECT_LE(norm(ref, cn, NORM_INF), 1e-6) << "size " << sizes[s];
+    }
+}
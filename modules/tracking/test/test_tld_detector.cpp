@@ -0,0 +1,159 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2015, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+#include "../src/tldDetector.hpp"
+
+using namespace cv;
+using namespace cv::tld;
+
+static const int PATCH_AREA = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+
+// NN-model of random samples, stored the way TrackerTLDModel stores them
+class TLD_NN_Classification : public testing::Test
+{
+protected:
+    Mat posExp, negExp;
+    int posNum, negNum;
+    std::vector<int> timeStampsPositive, timeStampsNegative;
+    TLDDetector detector;
+    RNG rng;
+
+    void SetUp()
+    {
+        posExp = Mat::zeros(MAX_EXAMPLES_IN_MODEL, PATCH_AREA, CV_8U);
+        negExp = Mat::zeros(MAX_EXAMPLES_IN_MODEL, PATCH_AREA, CV_8U);
+        posNum = negNum = 0;
+        rng = RNG(0);
+
+        detector.posExp = &posExp;
+        detector.negExp = &negExp;
+        detector.posNum = &posNum;
+        detector.negNum = &negNum;
+        detector.timeStampsPositive = &timeStampsPositive;
+        detector.timeStampsNegative = &timeStampsNegative;
+    }
+
+    void addExamples(bool positive, int count, int timeStamp)
+    {
+        Mat& samples = positive ? posExp : negExp;
+        int& num = positive ? posNum : negNum;
+        std::vector<int>& timeStamps = positive ? timeStampsPositive : timeStampsNegative;
+        for (int i = 0; i < count; i++, num++)
+        {
+            Mat row = samples.row(num);
+            rng.fill(row, RNG::UNIFORM, 0, 256);
+            timeStamps.push_back(timeStamp);
+        }
+    }
+
+    // Random patches, noisy copies of the positive examples and a constant patch
+    Mat_<uchar> makeCandidates(int count)
+    {
+        Mat_<uchar> patches(count, PATCH_AREA);
+        rng.fill(patches, RNG::UNIFORM, 0, 256);
+        for (int i = 0; i < count / 2; i++)
+        {
+            Mat noise(1, PATCH_AREA, CV_16S);
+            rng.fill(noise, RNG::NORMAL, 0, 20);
+            Mat noisy;
+            add(posExp.row(rng.uniform(0, posNum)), noise, noisy, noArray(), CV_8U);
+            noisy.copyTo(patches.row(i));
+        }
+        patches.row(count - 1).setTo(100);
+        return patches;
+    }
+
+    void checkBatch(const Mat_<uchar>& patches, bool ocl)
+    {
+        const int count = patches.rows;
+        std::vector<double> sr(count, -1.0), sc(count, -1.0);
+#ifdef HAVE_OPENCL
+        if (ocl)
+            detector.ocl_batchSrSc(patches, &sr[0], &sc[0], count);
+        else
+#endif
+            detector.batchSrSc(patches, &sr[0], &sc[0], count);
+
+        // the OpenCL kernels compute NCC in single precision
+        const double eps = ocl ? 1e-5 : 1e-12;
+        for (int i = 0; i < count; i++)
+        {
+            Mat_<uchar> patch = patches.row(i).reshape(1, STANDARD_PATCH_SIZE);
+            EXPECT_NEAR(detector.Sr(patch), sr[i], eps) << "patch " << i;
+            EXPECT_NEAR(detector.Sc(patch), sc[i], eps) << "patch " << i;
+        }
+    }
+};
+
+TEST_F(TLD_NN_Classification, batchSrSc)
+{
+    addExamples(true, 7, 0);
+    addExamples(false, 13, 0);
+    // the number of candidates isn't a multiple of the block of the batch
+    Mat_<uchar> patches = makeCandidates(23);
+    checkBatch(patches, false);
+
+    // the sums of the examples seen by the previous call are cached, the appended ones are new
+    addExamples(true, 5, 1);
+    addExamples(true, 4, 2);
+    addExamples(false, 3, 1);
+    checkBatch(patches, false);
+    checkBatch(makeCandidates(9), false);
+}
+
+#ifdef HAVE_OPENCL
+TEST_F(TLD_NN_Classification, ocl_batchSrSc)
+{
+    if (!ocl::useOpenCL())
+        return;
+
+    addExamples(true, 7, 0);
+    addExamples(false, 13, 0);
+    Mat_<uchar> patches = makeCandidates(23);
+    checkBatch(patches, true);
+
+    addExamples(true, 5, 1);
+    addExamples(true, 4, 2);
+    addExamples(false, 3, 1);
+    checkBatch(patches, true);
+}
+#endif
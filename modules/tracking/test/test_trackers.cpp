@@ -538,4 +538,148 @@ TEST_P(DistanceAndOverlap, DISABLED_GOTURN)
 
 INSTANTIATE_TEST_CASE_P( Tracking, DistanceAndOverlap, TESTSET_NAMES);
 
+// textured squares moving over a noisy background
+static void createMovingSquaresFrame(int frameIdx, Mat& frame)
+{
+    RNG rng(0);
+    frame.create(240, 320, CV_8UC3);
+    rng.fill(frame, RNG::UNIFORM, 0, 64);
+    for (int i = 0; i < 4; i++)
+    {
+        Mat square = frame(Rect(20 + 70 * i + 2 * frameIdx, 40 + 30 * i + frameIdx, 40, 40));
+        rng.fill(square, RNG::UNIFORM, 128, 256);
+    }
+}
+
+TEST(MultiTracker, Parallel_Update_Is_Deterministic)
+{
+    const char* types[] = {"KCF", "MEDIANFLOW", "KCF", "MEDIANFLOW"};
+    MultiTracker serial, parallel;
+    parallel.setParallelUpdate(true);
+
+    Mat frame;
+    createMovingSquaresFrame(0, frame);
+    for (int i = 0; i < 4; i++)
+    {
+        Rect2d roi(20 + 70 * i, 40 + 30 * i, 40, 40);
+        ASSERT_TRUE(serial.add(types[i], frame, roi));
+        ASSERT_TRUE(parallel.add(types[i], frame, roi));
+    }
+
+    for (int frameIdx = 1; frameIdx < 10; frameIdx++)
+    {
+        createMovingSquaresFrame(frameIdx, frame);
+        std::vector<Rect2d> serialBoxes, parallelBoxes;
+        serial.update(frame, serialBoxes);
+        parallel.update(frame, parallelBoxes);
+
+        ASSERT_EQ(serialBoxes.size(), parallelBoxes.size());
+        for (size_t i = 0; i < serialBoxes.size(); i++)
+            EXPECT_EQ(serialBoxes[i], parallelBoxes[i]) << "frame " << frameIdx << ", object " << i;
+    }
+}
+
+TEST(Tracker, Shared_Frame_Context_Matches_Plain_Update)
+{
+    const char* types[] = {"KCF", "MEDIANFLOW"};
+    const int n = (int)(sizeof(types) / sizeof(types[0]));
+    std::vector<Ptr<Tracker> > plain, shared;
+
+    Mat frame;
+    createMovingSquaresFrame(0, frame);
+    for (int i = 0; i < n; i++)
+    {
+        Rect2d roi(20 + 70 * i, 40 + 30 * i, 40, 40);
+        plain.push_back(Tracker::create(types[i]));
+        shared.push_back(Tracker::create(types[i]));
+        ASSERT_TRUE(plain[i]->init(frame, roi));
+        ASSERT_TRUE(shared[i]->init(frame, roi));
+    }
+
+    for (int frameIdx = 1; frameIdx < 10; frameIdx++)
+    {
+        createMovingSquaresFrame(frameIdx, frame);
+        TrackerFrameContext context(frame);
+        for (int i = 0; i < n; i++)
+        {
+            Rect2d plainBox, sharedBox;
+            bool plainResult = plain[i]->update(frame, plainBox);
+            bool sharedResult = shared[i]->update(context, sharedBox);
+            EXPECT_EQ(plainResult, sharedResult) << types[i] << ", frame " << frameIdx;
+            EXPECT_EQ(plainBox, sharedBox) << types[i] << ", frame " << frameIdx;
+        }
+    }
+}
+
+// the packed spectra of the optimized KCF path against the complex spectra of the reference one
+TEST(KCF, Packed_Spectra_Match_Complex_Spectra)
+{
+    TrackerKCF::Params params[2];
+    params[1].desc_pca = TrackerKCF::GRAY | TrackerKCF::CN;
+    params[1].desc_npca = 0;
+    params[1].compress_feature = false;
+    params[1].split_coeff = false;
+
+    bool optimized = useOptimized();
+    for (int p = 0; p < 2; p++)
+    {
+        Ptr<Tracker> packed = TrackerKCF::createTracker(params[p]);
+        Ptr<Tracker> reference = TrackerKCF::createTracker(params[p]);
+
+        Mat frame;
+        createMovingSquaresFrame(0, frame);
+        Rect2d roi(20, 40, 40, 40);
+        ASSERT_TRUE(packed->init(frame, roi));
+        setUseOptimized(false);
+        ASSERT_TRUE(reference->init(frame, roi));
+        setUseOptimized(optimized);
+
+        for (int frameIdx = 1; frameIdx < 10; frameIdx++)
+        {
+            createMovingSquaresFrame(frameIdx, frame);
+            Rect2d packedBox, referenceBox;
+            bool packedResult = packed->update(frame, packedBox);
+            setUseOptimized(false);
+            bool referenceResult = reference->update(frame, referenceBox);
+            setUseOptimized(optimized);
+            EXPECT_EQ(packedResult, referenceResult) << "params " << p << ", frame " << frameIdx;
+            EXPECT_EQ(packedBox, referenceBox) << "params " << p << ", frame " << frameIdx;
+        }
+    }
+}
+
+// needs goturn.prototxt and goturn.caffemodel in the working directory
+TEST(GOTURN, DISABLED_Batched_Update_Matches_Single_Updates)
+{
+    std::vector<Ptr<TrackerGOTURN> > single, batched;
+
+    Mat frame;
+    createMovingSquaresFrame(0, frame);
+    for (int i = 0; i < 4; i++)
+    {
+        Rect2d roi(20 + 70 * i, 40 + 30 * i, 40, 40);
+        single.push_back(TrackerGOTURN::createTracker());
+        batched.push_back(TrackerGOTURN::createTracker());
+        ASSERT_TRUE(single[i]->init(frame, roi));
+        ASSERT_TRUE(batched[i]->init(frame, roi));
+    }
+
+    for (int frameIdx = 1; frameIdx < 5; frameIdx++)
+    {
+        createMovingSquaresFrame(frameIdx, frame);
+        std::vector<Rect2d> batchedBoxes;
+        ASSERT_TRUE(TrackerGOTURN::updateMultiple(batched, frame, batchedBoxes));
+        ASSERT_EQ(single.size(), batchedBoxes.size());
+        for (size_t i = 0; i < single.size(); i++)
+        {
+            Rect2d box;
+            ASSERT_TRUE(single[i]->update(frame, box));
+            EXPECT_NEAR(box.x, batchedBoxes[i].x, 1e-3) << "frame " << frameIdx << ", object " << i;
+            EXPECT_NEAR(box.y, batchedBoxes[i].y, 1e-3) << "frame " << frameIdx << ", object " << i;
+            EXPECT_NEAR(box.width, batchedBoxes[i].width, 1e-3) << "frame " << frameIdx << ", object " << i;
+            EXPECT_NEAR(box.height, batchedBoxes[i].height, 1e-3) << "frame " << frameIdx << ", object " << i;
+        }
+    }
+}
+
 /* End of file. */
@@ -93,6 +93,30 @@ public:
      */
     CV_WRAP virtual void iterate( int num_iterations = 10 ) = 0;
 
+    /** @brief Calculates the superpixel segmentation of the next frame of a video, starting from
+    the segmentation of the previous one.
+
+    @param image Next frame. It should have the same size, number of channels and depth as the image
+    given to createSuperpixelLSC().
+
+    @param num_iterations Number of iterations. As the clustering starts from the labels of the
+    previous frame, a few iterations are usually enough.
+
+    @param change_threshold Mean absolute difference between the frames, over a region_size x
+    region_size tile and all channels, above which the tile is re-clustered. Labels of the other
+    tiles are kept.
+
+    The function makes the superpixels of consecutive frames temporally coherent and costs much less
+    than segmenting every frame from scratch. Seeds are placed at the centroids of the current
+    superpixels, and only pixels inside changed tiles are reassigned.
+
+    Reassigned pixels may leave disconnected fragments of a superpixel behind. The function does
+    not enforce connectivity itself, since that renumbers all the labels: call
+    enforceLabelConnectivity() afterwards if connected superpixels are needed.
+     */
+    CV_WRAP virtual void iterateNextFrame( InputArray image, int num_iterations = 3,
+                                           float change_threshold = 2.0f ) = 0;
+
     /** @brief Returns the segmentation labeling of the image.
 
     Each label represents a superpixel, and each pixel is assigned to one superpixel label.
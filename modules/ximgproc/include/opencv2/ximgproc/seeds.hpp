@@ -98,6 +98,26 @@ public:
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
+    /** @brief Calculates the superpixel segmentation of the next frame of a video, starting from
+    the segmentation of the previous one.
+
+    @param img Next frame, with the same requirements as for iterate() and the same depth as the
+    previous frame.
+
+    @param num_iterations Number of pixel level iterations.
+
+    @param change_threshold Fraction of pixels of a superpixel sized tile that changed their
+    histogram bin since the previous frame, above which the tile is updated. Boundaries inside the
+    other tiles are kept.
+
+    The function makes the superpixels of consecutive frames temporally coherent and costs much less
+    than iterate(). The block levels are skipped: histograms of the current superpixels are rebuilt
+    on the new frame, and pixel level updates are run inside changed tiles only. If no frame was
+    segmented yet, the function falls back to iterate().
+     */
+    CV_WRAP virtual void iterateNextFrame(InputArray img, int num_iterations=2,
+                                          float change_threshold=0.05f) = 0;
+
     /** @brief Returns the segmentation labeling of the image.
 
     Each label represents a superpixel, and each pixel is assigned to one superpixel label.
@@ -77,7 +77,8 @@ enum WMFWeightType
 * For more details about this implementation, please see @cite zhang2014100+
 *
 * @param   joint       Joint 8-bit, 1-channel or 3-channel image.
-* @param   src         Source 8-bit or floating-point, 1-channel or 3-channel image.
+* @param   src         Source 8-bit, 16-bit or floating-point, 1-channel or 3-channel image.
+*                      16-bit and floating-point values are adaptively quantized to 256 levels.
 * @param   dst         Destination image.
 * @param   r           Radius of filtering kernel, should be a positive integer.
 * @param   sigma       Filter range standard deviation for the joint image.
@@ -85,4 +85,35 @@
 
      SANITY_CHECK_NOTHING();
  }
+
+ typedef tuple<Size, MatType, int> WMFLargeRadiusTestParam;
+ typedef TestBaseWithParam<WMFLargeRadiusTestParam> WeightedMedianFilterLargeRadiusTest;
+
+ PERF_TEST_P(WeightedMedianFilterLargeRadiusTest, perf,
+     Combine(
+     Values(szVGA, sz720p),
+     Values(CV_16UC1, CV_32FC1),
+     Values(15, 31))
+ )
+ {
+     WMFLargeRadiusTestParam params = GetParam();
+
+     Size sz    = get<0>(params);
+     int srcType = get<1>(params);
+     int r      = get<2>(params);
+
+     Mat joint(sz, CV_8UC3);
+     Mat src(sz, srcType);
+     Mat dst(sz, src.type());
+
+     cv::setNumThreads(cv::getNumberOfCPUs());
+     declare.in(joint, src, WARMUP_RNG).out(dst).tbb_threads(cv::getNumberOfCPUs());
+
+     TEST_CYCLE_N(1)
+     {
+         weightedMedianFilter(joint, src, dst, r, 25.5, WMF_EXP);
+     }
+
+     SANITY_CHECK_NOTHING();
+ }
  }
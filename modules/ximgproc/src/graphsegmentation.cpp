@@ -49,37 +49,27 @@ namespace cv {
 
             // Helpers
 
-            // Represent an edge between two pixels
-            class Edge {
-                public:
-                    int from;
-                    int to;
-                    float weight;
-
-                    bool operator <(const Edge& e) const {
-                        return weight < e.weight;
-                    }
-            };
-
-            // A point in the sets of points
-            class PointSetElement {
-                public:
-                    int p;
-                    int size;
-
-                    PointSetElement() { }
+            // Edges between neighbouring pixels, packed for the sort: the bits of the (non negative) weight
+            // are the high part, so the integer order is the order of the weights. The low part is
+            // from * 2 + direction, the edge goes to the right pixel for direction 0 and to the bottom one for 1
+            typedef uint64 Edge;
+
+            static inline Edge makeEdge(float weight, int from, int direction) {
+                Cv32suf w;
+                w.f = weight;
+                return ((uint64)w.u << 32) | (uint64)(from * 2 + direction);
+            }
 
-                    PointSetElement(int p_) {
-                        p = p_;
-                        size = 1;
-                    }
-            };
+            static inline float edgeWeight(Edge e) {
+                Cv32suf w;
+                w.u = (unsigned)(e >> 32);
+                return w.f;
+            }
 
             // An object to manage set of points, who can be fusionned
             class PointSet {
                 public:
                     PointSet(int nb_elements_);
-                    ~PointSet();
 
                     int nb_elements;
 
@@ -90,10 +80,11 @@ namespace cv {
                     void joinPoints(int p_a, int p_b);
 
                     // Return the set size of a set (based on the main point)
-                    int size(unsigned int p) { return mapping[p].size; }
+                    int size(unsigned int p) { return sizes[p]; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<int> parents;
+                    std::vector<int> sizes;
 
             };
 
@@ -144,17 +135,17 @@ namespace cv {
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
-                    // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    // Build the graph between each pixels, the edges are sorted by weight
+                    void buildGraph(std::vector<Edge> &edges, const Mat &img_filtered);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(const std::vector<Edge> &edges, const Mat & img_filtered, PointSet &es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, const Mat & img_filtered, PointSet &es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
             };
 
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
@@ -168,112 +159,159 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+            // Computes the edges of a range of rows, row i starts at i * (2 * cols - 1): the cols - 1 edges to
+            // the right pixels, then the cols edges to the bottom pixels (none for the last row)
+            class BuildGraphInvoker : public ParallelLoopBody {
+                public:
+                    BuildGraphInvoker(const Mat& img_filtered_, std::vector<Edge>& edges_) : img_filtered(img_filtered_), edges(edges_) {
+                    }
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                    virtual void operator()(const Range& range) const {
+                        const int rows = img_filtered.rows, cols = img_filtered.cols, nb_channels = img_filtered.channels();
 
-                nb_edges = 0;
+                        for (int i = range.start; i < range.end; i++) {
+                            const float* p = img_filtered.ptr<float>(i);
+                            const float* p2 = i + 1 < rows ? img_filtered.ptr<float>(i + 1) : NULL;
+                            Edge* row_edges = &edges[(size_t)i * (2 * cols - 1)];
 
-                int nb_channels = img_filtered.channels();
+                            for (int j = 0; j < cols - 1; j++) {
+                                *row_edges++ = makeEdge(distance(p + j * nb_channels, p + (j + 1) * nb_channels, nb_channels), i * cols + j, 0);
+                            }
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                            if (p2) {
+                                for (int j = 0; j < cols; j++) {
+                                    *row_edges++ = makeEdge(distance(p + j * nb_channels, p2 + j * nb_channels, nb_channels), i * cols + j, 1);
+                                }
+                            }
+                        }
+                    }
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                private:
+                    static inline float distance(const float* a, const float* b, int nb_channels) {
+                        float tmp_total = 0;
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                        for (int channel = 0; channel < nb_channels; channel++) {
+                            float diff = a[channel] - b[channel];
+                            tmp_total += diff * diff;
+                        }
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                        return sqrt(tmp_total);
+                    }
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                    const Mat& img_filtered;
+                    std::vector<Edge>& edges;
+            };
 
-                                    float tmp_total = 0;
+            // Stable LSD radix sort on the weight bits, 3 passes of 11 bits
+            static void sortEdges(std::vector<Edge> &edges) {
+                const int bits = 11, nb_buckets = 1 << bits, nb_passes = 3;
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+                std::vector<size_t> counts(nb_buckets * nb_passes, 0);
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                for (size_t e = 0; e < edges.size(); e++) {
+                    unsigned key = (unsigned)(edges[e] >> 32);
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+                    for (int pass = 0; pass < nb_passes; pass++) {
+                        counts[pass * nb_buckets + ((key >> (pass * bits)) & (nb_buckets - 1))]++;
+                    }
+                }
 
-                                    nb_edges++;
-                                }
-                            }
-                        }
+                std::vector<Edge> buffer(edges.size());
+
+                for (int pass = 0; pass < nb_passes; pass++) {
+                    size_t* offsets = &counts[pass * nb_buckets];
+
+                    // All the edges are in the same bucket, this pass doesn't change the order
+                    if (offsets[(edges[0] >> (32 + pass * bits)) & (nb_buckets - 1)] == edges.size()) {
+                        continue;
                     }
+
+                    size_t total = 0;
+
+                    for (int b = 0; b < nb_buckets; b++) {
+                        size_t count = offsets[b];
+                        offsets[b] = total;
+                        total += count;
+                    }
+
+                    for (size_t e = 0; e < edges.size(); e++) {
+                        buffer[offsets[(edges[e] >> (32 + pass * bits)) & (nb_buckets - 1)]++] = edges[e];
+                    }
+
+                    edges.swap(buffer);
                 }
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &img_filtered) {
 
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                int rows = img_filtered.rows, cols = img_filtered.cols;
+
+                if (rows * cols <= 1) {
+                    edges.clear();
+                    return;
+                }
+
+                edges.resize((size_t)(rows - 1) * (2 * cols - 1) + (cols - 1));
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                parallel_for_(Range(0, rows), BuildGraphInvoker(img_filtered, edges));
 
-                // Create a set with all point (by default mapped to themselfs)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                sortEdges(edges);
+            }
+
+            void GraphSegmentationImpl::segmentGraph(const std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es) {
+
+                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                int cols = img_filtered.cols;
 
                 // Thresholds
-                float* thresholds = new float[total_points];
+                std::vector<float> thresholds(total_points, k);
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                    int from = (int)(edges[i] & 0xffffffff) >> 1;
+                    int to = from + ((edges[i] & 1) ? cols : 1);
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    int p_a = es.getBasePoint(from);
+                    int p_b = es.getBasePoint(to);
 
                     if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                        float weight = edgeWeight(edges[i]);
 
-                            edges[i].weight = 0;
+                        if (weight <= thresholds[p_a] && weight <= thresholds[p_b]) {
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = weight + k / es.size(p_a);
                         }
                     }
                 }
-
-                delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                int cols = img_filtered.cols;
 
-                    if (edges[i].weight > 0) {
+                // The edges joined by segmentGraph connect points of the same set, so they are skipped
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                    int from = (int)(edges[i] & 0xffffffff) >> 1;
+                    int to = from + ((edges[i] & 1) ? cols : 1);
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                    int p_a = es.getBasePoint(from);
+                    int p_b = es.getBasePoint(to);
 
-                        }
+                    if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                        es.joinPoints(p_a, p_b);
                     }
                 }
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -289,7 +327,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -299,8 +337,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -309,32 +345,27 @@ namespace cv {
 
                 dst.create(img.rows, img.cols, CV_32SC1);
                 Mat output = dst.getMat();
-                output.setTo(0);
 
                 // Filter graph
                 Mat img_filtered;
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<Edge> edges;
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                buildGraph(edges, img_filtered);
 
                 // Segment graph
-                PointSet *es;
+                PointSet es(img_filtered.cols * img_filtered.rows);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(edges, img_filtered, es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, img_filtered, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -348,30 +379,28 @@ namespace cv {
                 return graphseg;
             }
 
-            PointSet::PointSet(int nb_elements_) {
+            PointSet::PointSet(int nb_elements_) : parents(nb_elements_), sizes(nb_elements_, 1) {
                 nb_elements = nb_elements_;
 
-                mapping = new PointSetElement[nb_elements];
-
                 for ( int i = 0; i < nb_elements; i++) {
-                    mapping[i] = PointSetElement(i);
+                    parents[i] = i;
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
-                 int base_p = p;
+                int base_p = p;
 
-                while (base_p != mapping[base_p].p) {
-                    base_p = mapping[base_p].p;
+                while (base_p != parents[base_p]) {
+                    base_p = parents[base_p];
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
+                // Save mapping for faster acces later, for the whole path
+                while (p != base_p) {
+                    int next = parents[p];
+                    parents[p] = base_p;
+                    p = next;
+                }
 
                 return base_p;
             }
@@ -379,11 +408,11 @@ namespace cv {
             void PointSet::joinPoints(int p_a, int p_b) {
 
                 // Always target smaller set, to avoid redirection in getBasePoint
-                if (mapping[p_a].size < mapping[p_b].size)
+                if (sizes[p_a] < sizes[p_b])
                     swap(p_a, p_b);
 
-                mapping[p_b].p = p_a;
-                mapping[p_a].size += mapping[p_b].size;
+                parents[p_b] = p_a;
+                sizes[p_a] += sizes[p_b];
 
                 nb_elements--;
             }
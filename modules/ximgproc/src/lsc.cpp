@@ -46,6 +46,7 @@
 #include <map>
 #include <queue>
 #include "precomp.hpp"
+#include "superpixel_frames.hpp"
 
 using namespace std;
 
@@ -64,6 +65,9 @@ public:
     // perform amount of iteration
     virtual void iterate( int num_iterations = 10 );
 
+    // continue segmentation on next frame
+    virtual void iterateNextFrame( InputArray image, int num_iterations = 3, float change_threshold = 2.0f );
+
     // get amount of superpixels
     virtual int getNumberOfSuperpixels() const;
 
@@ -140,11 +144,17 @@ private:
     // fetch seeds
     inline void GetChSeeds();
 
+    // max value over channels
+    inline void GetChMax();
+
+    // seeds from labels centroids
+    inline void GetLabelSeeds();
+
     // precompute vector space
     inline void GetFeatureSpace();
 
-    // LSC
-    inline void PerformLSC( const int& num_iterations );
+    // LSC (optionally restricted to mask)
+    inline void PerformLSC( const int& num_iterations, const Mat& mask = Mat() );
 
     // pre-enforce connectivity over labels
     inline void PreEnforceLabelConnectivity( int min_element_size );
@@ -242,13 +252,7 @@ void SuperpixelLSCImpl::initialize()
                 /  float(m_region_size * m_region_size));
 
     // max intensity
-    m_chvec_max = 0.0f;
-    for( int b = 0; b < m_nr_channels; b++ )
-    {
-      double chmin, chmax;
-      minMaxIdx( m_chvec[b], &chmin, &chmax );
-      if ( m_chvec_max < chmax ) m_chvec_max = (float) chmax;
-    }
+    GetChMax();
 
     // intitialize label storage
     m_klabels = Mat( m_height, m_width, CV_32S, Scalar::all(0) );
@@ -262,6 +266,48 @@ void SuperpixelLSCImpl::iterate( int num_iterations )
     PerformLSC( num_iterations );
 }
 
+void SuperpixelLSCImpl::iterateNextFrame( InputArray _image, int num_iterations, float change_threshold )
+{
+    vector<Mat> chvec;
+    if ( _image.isMat() )
+      split( _image.getMat(), chvec );
+    else if ( _image.isMatVector() )
+    {
+      _image.getMatVector( chvec );
+
+      // keep own copy to compare with next frame
+      for ( size_t c = 0; c < chvec.size(); c++ )
+        chvec[c] = chvec[c].clone();
+    }
+    else
+      CV_Error( Error::StsInternal, "Invalid InputArray." );
+
+    // frame should match the first one
+    CV_Assert( (int) chvec.size() == m_nr_channels );
+    CV_Assert( chvec[0].size() == Size( m_width, m_height ) );
+    CV_Assert( chvec[0].depth() == m_chvec[0].depth() );
+
+    // tiles that changed since previous frame
+    Mat diff, mask;
+    frameDifference( m_chvec, chvec, diff );
+    int nr_changed = markChangedTiles( diff, Size( m_region_size, m_region_size ),
+                                       change_threshold, mask );
+
+    m_chvec = chvec;
+
+    // warm start: seeds of current superpixels
+    GetLabelSeeds();
+
+    if ( nr_changed == 0 )
+      return;
+
+    // feature space of the new frame
+    GetChMax();
+    GetFeatureSpace();
+
+    PerformLSC( num_iterations, mask );
+}
+
 void SuperpixelLSCImpl::getLabels(OutputArray labels_out) const
 {
     labels_out.assign( m_klabels );
@@ -907,6 +953,46 @@ inline void SuperpixelLSCImpl::GetChSeeds()
     m_numlabels = count;
 }
 
+inline void SuperpixelLSCImpl::GetChMax()
+{
+    m_chvec_max = 0.0f;
+    for( int b = 0; b < m_nr_channels; b++ )
+    {
+      double chmin, chmax;
+      minMaxIdx( m_chvec[b], &chmin, &chmax );
+      if ( m_chvec_max < chmax ) m_chvec_max = (float) chmax;
+    }
+}
+
+inline void SuperpixelLSCImpl::GetLabelSeeds()
+{
+    vector<double> sumx( m_numlabels, 0 );
+    vector<double> sumy( m_numlabels, 0 );
+    vector<int> count( m_numlabels, 0 );
+
+    for( int y = 0; y < m_height; y++ )
+    {
+      const int* pLabels = m_klabels.ptr<int>(y);
+      for( int x = 0; x < m_width; x++ )
+      {
+        int idx = pLabels[x];
+        sumx[idx] += x; sumy[idx] += y;
+        count[idx]++;
+      }
+    }
+
+    // labels may be renumbered by enforceLabelConnectivity(),
+    // empty superpixels keep their previous seeds
+    m_kseedsx.resize( m_numlabels, 0.0f );
+    m_kseedsy.resize( m_numlabels, 0.0f );
+    for( int i = 0; i < m_numlabels; i++ )
+    {
+      if ( count[i] == 0 ) continue;
+      m_kseedsx[i] = float( sumx[i] / count[i] );
+      m_kseedsy[i] = float( sumy[i] / count[i] );
+    }
+}
+
 struct FeatureSpaceSigmas
 {
     FeatureSpaceSigmas( const vector< Mat >& _chvec, const int _nr_channels,
@@ -1339,9 +1425,10 @@ struct FeatureSpaceKmeans : ParallelLoopBody
                         vector< vector<float> >& _centerC1, vector< vector<float> >& _centerC2,
                         const int _nr_channels, const float _chvec_max,
                         const float _dist_coeff, const float _color_coeff,
-                        const int _stepx, const int _stepy )
+                        const int _stepx, const int _stepy, const Mat& _mask = Mat() )
     {
       W = _W;
+      mask = _mask;
       dist = _dist;
       chvec = _chvec;
       stepx = _stepx;
@@ -1374,6 +1461,10 @@ struct FeatureSpaceKmeans : ParallelLoopBody
         int maxX = (X+(stepx) >= width -1) ? width -1 : X+stepx;
         int maxY = (Y+(stepy) >= height-1) ? height-1 : Y+stepy;
 
+        // skip seeds without pixels to re-cluster
+        if ( !mask.empty() && countNonZero( mask( Range(minY, maxY+1), Range(minX, maxX+1) ) ) == 0 )
+          continue;
+
         for( int x = minX; x <= maxX; x++ )
         {
           float thetaX = ( (float) x / (float) stepx ) * PI2;
@@ -1383,6 +1474,9 @@ struct FeatureSpaceKmeans : ParallelLoopBody
 
           for( int y = minY; y <= maxY; y++ )
           {
+            // only pixels to re-cluster
+            if ( !mask.empty() && !mask.at<uchar>(y,x) ) continue;
+
             float thetaY = ( (float) y / (float) stepy ) * PI2;
 
             // we do not store pre-computed x1, x2
@@ -1463,6 +1557,7 @@ struct FeatureSpaceKmeans : ParallelLoopBody
 
     Mat* dist;
     Mat* klabels;
+    Mat mask;
     vector<Mat> chvec;
     vector<float> kseedsx, kseedsy;
     vector<float> centerX1, centerX2;
@@ -1734,7 +1829,7 @@ struct FeatureNormals : ParallelLoopBody
  *    in (4 + 2*m_nr_channels) dimensional space
  *
  */
-inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum )
+inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum, const Mat& mask )
 {
     // allocate initial workspaces
     cv::Mat dist( m_height, m_width, CV_32F );
@@ -1771,7 +1866,7 @@ inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum )
                      &m_klabels, &dist, m_chvec, m_W, m_kseedsx, m_kseedsy,
                      centerX1, centerX2, centerY1, centerY2, centerC1, centerC2,
                      m_nr_channels, m_chvec_max, m_dist_coeff, m_color_coeff,
-                     m_stepx, m_stepy ) );
+                     m_stepx, m_stepy, mask ) );
 
       // parallel reduce structure
       FeatureCenterDists fcd( m_chvec, m_W, m_klabels, m_nr_channels, m_chvec_max,
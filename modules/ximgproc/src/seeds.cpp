@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "superpixel_frames.hpp"
 
 /******************************************************************************\
 *                            SEEDS Superpixels                                *
@@ -69,8 +70,12 @@ typedef float HISTN;
 namespace cv {
 namespace ximgproc {
 
+class SeedsBlockUpdateInvoker;
+
 class SuperpixelSEEDSImpl : public SuperpixelSEEDS
 {
+    friend class SeedsBlockUpdateInvoker;
+
 public:
 
     SuperpixelSEEDSImpl(int image_width, int image_height, int image_channels,
@@ -83,6 +88,8 @@ public:
 
     virtual void iterate(InputArray img, int num_iterations = 4);
 
+    virtual void iterateNextFrame(InputArray img, int num_iterations = 2,
+                                  float change_threshold = 0.05f);
 
     virtual void getLabels(OutputArray labels_out);
     virtual void getLabelContourMask(OutputArray image, bool thick_line = false);
@@ -91,6 +98,8 @@ private:
     /* initialization */
     void initialize(int num_superpixels, int num_levels);
     void initImage(InputArray img);
+    Mat readImage(InputArray img);
+    void computeImageBins(const Mat& src);
     void assignLabels();
     void computeHistograms(int until_level = -1);
     template<typename _Tp>
@@ -107,8 +116,8 @@ private:
     inline int fourbythree(int x, int y, int label);
 
     inline void updateLabels();
-    // main loop for pixel updating
-    void updatePixels();
+    // main loop for pixel updating, optionally only where update_mask[y*width+x] != 0
+    void updatePixels(const uchar* update_mask = NULL);
 
 
     /* block operations */
@@ -122,6 +131,11 @@ private:
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    //block updates of rows [y_begin, y_end) / columns [x_begin, x_end) at level
+    void updateBlocksHorizontal(int level, float req_confidence, int y_begin, int y_end);
+    void updateBlocksVertical(int level, float req_confidence, int x_begin, int x_end);
+    //largest extent of a superpixel in blocks of level, across rows or columns
+    int maxLabelExtent(int level, bool across_rows) const;
 
     /* go to next block level */
     int goDownOneLevel();
@@ -153,6 +167,8 @@ private:
     int seeds_current_level; //start with level seeds_top_level-1, then go down
     bool seeds_double_step;
     int seeds_prior;
+    bool seeds_has_frame; // labels of a previous frame are available
+    int seeds_frame_depth; // depth of the segmented frames
 
     // keep one labeling for each level
     vector<int> nr_wh; // [2*level]/[2*level+1] number of labels in x-direction/y-direction
@@ -178,6 +194,7 @@ private:
     Mat labels_bottom_mat;
     Mat nr_partitions_mat;
     Mat image_bins_mat;
+    Mat prev_image_bins_mat;
     vector<Mat> histogram_mat;
     vector<Mat> T_mat;
     vector<Mat> parent_mat;
@@ -201,6 +218,7 @@ SuperpixelSEEDSImpl::SuperpixelSEEDSImpl(int image_width, int image_height, int
     nr_channels = image_channels;
     seeds_double_step = double_step;
     seeds_prior = std::min(prior, 5);
+    seeds_has_frame = false;
 
     histogram_size = nr_bins;
     for (int i = 1; i < nr_channels; ++i)
@@ -233,6 +251,44 @@ void SuperpixelSEEDSImpl::iterate(InputArray img, int num_iterations)
 
     for (int i = 0; i < num_iterations; ++i)
         updatePixels();
+
+    seeds_has_frame = true;
+}
+
+void SuperpixelSEEDSImpl::iterateNextFrame(InputArray img, int num_iterations, float change_threshold)
+{
+    if( !seeds_has_frame )
+    {
+        iterate(img, num_iterations);
+        return;
+    }
+
+    Mat src = readImage(img);
+    CV_Assert(src.depth() == seeds_frame_depth);
+
+    image_bins_mat.copyTo(prev_image_bins_mat);
+    computeImageBins(src);
+
+    // pixels that moved to another histogram bin
+    Mat changed;
+    compare(image_bins_mat, prev_image_bins_mat, changed, CMP_NE);
+    changed.convertTo(changed, CV_32F, 1.0 / 255);
+
+    // tiles of superpixel size with enough changed pixels
+    Mat update_mask;
+    Size tile(width / nr_wh[2 * seeds_top_level], height / nr_wh[2 * seeds_top_level + 1]);
+    if( markChangedTiles(changed, tile, change_threshold, update_mask) == 0 )
+        return;
+
+    // histograms of the current superpixels on the new frame
+    memset(histogram[seeds_top_level], 0,
+            sizeof(HISTN) * histogram_size_aligned * nrLabels(seeds_top_level));
+    memset(T[seeds_top_level], 0, sizeof(HISTN) * nrLabels(seeds_top_level));
+    for (int i = 0; i < width * height; ++i)
+        addPixel(seeds_top_level, labels[i], i);
+
+    for (int i = 0; i < num_iterations; ++i)
+        updatePixels(update_mask.ptr<uchar>());
 }
 void SuperpixelSEEDSImpl::getLabels(OutputArray labels_out)
 {
@@ -373,7 +429,7 @@ void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
     }
 }
 
-void SuperpixelSEEDSImpl::initImage(InputArray img)
+Mat SuperpixelSEEDSImpl::readImage(InputArray img)
 {
     Mat src;
 
@@ -401,17 +457,18 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
       CV_Error( Error::StsInternal, "Invalid InputArray." );
 
     int depth = src.depth();
-    seeds_current_level = seeds_nr_levels - 2;
-    forwardbackward = true;
-
-    assignLabels();
 
     CV_Assert(src.size().width == width && src.size().height == height);
     CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
     CV_Assert(src.channels() == nr_channels);
 
+    return src;
+}
+
+void SuperpixelSEEDSImpl::computeImageBins(const Mat& src)
+{
     // initialize the histogram bins from the image
-    switch (depth)
+    switch (src.depth())
     {
     case CV_8U:
         initImageBins<uchar>(src, 1 << 8);
@@ -423,7 +480,18 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
         initImageBins<float>(src, 1);
         break;
     }
+}
 
+void SuperpixelSEEDSImpl::initImage(InputArray img)
+{
+    Mat src = readImage(img);
+    seeds_frame_depth = src.depth();
+
+    seeds_current_level = seeds_nr_levels - 2;
+    forwardbackward = true;
+
+    assignLabels();
+    computeImageBins(src);
     computeHistograms();
 }
 
@@ -471,7 +539,82 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
     }
 }
 
+/* Block updates of a stripe of rows (columns) only touch superpixels present in
+ * these rows (columns), and read the neighbouring rows (columns). When stripes
+ * are at least as high as the largest superpixel, stripes two apart share no
+ * superpixel, so even and then odd stripes are updated in parallel. */
+class SeedsBlockUpdateInvoker : public ParallelLoopBody
+{
+public:
+    SeedsBlockUpdateInvoker(SuperpixelSEEDSImpl* _seeds, int _level, float _req_confidence,
+            bool _horizontal, int _begin, int _end, int _stripe, int _parity)
+        : seeds(_seeds), level(_level), req_confidence(_req_confidence), horizontal(_horizontal),
+          begin(_begin), end(_end), stripe(_stripe), parity(_parity) {}
+
+    virtual void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            int first = begin + (2 * i + parity) * stripe;
+            int last = std::min(first + stripe, end);
+            if( horizontal )
+                seeds->updateBlocksHorizontal(level, req_confidence, first, last);
+            else
+                seeds->updateBlocksVertical(level, req_confidence, first, last);
+        }
+    }
+
+private:
+    SuperpixelSEEDSImpl* seeds;
+    int level;
+    float req_confidence;
+    bool horizontal;
+    int begin, end, stripe, parity;
+};
+
+int SuperpixelSEEDSImpl::maxLabelExtent(int level, bool across_rows) const
+{
+    int nr_labels = nrLabels(seeds_top_level);
+    vector<int> first(nr_labels, INT_MAX), last(nr_labels, -1);
+
+    int step = nr_wh[2 * level];
+    for (int y = 0; y < nr_wh[2 * level + 1]; y++)
+    {
+        for (int x = 0; x < step; x++)
+        {
+            int label = parent[level][y * step + x];
+            int pos = across_rows ? y : x;
+            first[label] = std::min(first[label], pos);
+            last[label] = std::max(last[label], pos);
+        }
+    }
+
+    int extent = 1;
+    for (int label = 0; label < nr_labels; label++)
+        extent = std::max(extent, last[label] - first[label] + 1);
+    return extent;
+}
+
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // horizontal bidirectional block updating, then vertical bidirectional
+        bool horizontal = pass == 0;
+        int begin = 1;
+        int end = horizontal ? nr_wh[2 * level + 1] - 1 : nr_wh[2 * level] - 1;
+        int stripe = maxLabelExtent(level, horizontal);
+        int nr_stripes = std::max(end - begin + stripe - 1, 0) / stripe;
+
+        for (int parity = 0; parity < 2; parity++)
+            parallel_for_(Range(0, (nr_stripes + 1 - parity) / 2),
+                    SeedsBlockUpdateInvoker(this, level, req_confidence, horizontal,
+                            begin, end, stripe, parity));
+    }
+}
+
+void SuperpixelSEEDSImpl::updateBlocksHorizontal(int level, float req_confidence,
+        int y_begin, int y_end)
 {
     int labelA;
     int labelB;
@@ -480,7 +623,7 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     int step = nr_wh[2 * level];
 
     // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    for (int y = y_begin; y < y_end; y++)
     {
         for (int x = 1; x < nr_wh[2 * level] - 2; x++)
         {
@@ -541,9 +684,19 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             }
         }
     }
+}
+
+void SuperpixelSEEDSImpl::updateBlocksVertical(int level, float req_confidence,
+        int x_begin, int x_end)
+{
+    int labelA;
+    int labelB;
+    int sublabel;
+    bool done;
+    int step = nr_wh[2 * level];
 
     // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+    for (int x = x_begin; x < x_end; x++)
     {
         for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
         {
@@ -635,7 +788,7 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
     return new_level;
 }
 
-void SuperpixelSEEDSImpl::updatePixels()
+void SuperpixelSEEDSImpl::updatePixels(const uchar* update_mask)
 {
     int labelA;
     int labelB;
@@ -646,6 +799,12 @@ void SuperpixelSEEDSImpl::updatePixels()
     {
         for (int x = 1; x < width - 2; x++)
         {
+            // a pixel keeps its label outside the update mask, the pair is
+            // skipped only if neither pixel may change
+            bool updateA = !update_mask || update_mask[y * width + x];
+            bool updateB = !update_mask || update_mask[y * width + x + 1];
+            if( !updateA && !updateB )
+                continue;
 
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y) * width + (x + 1)];
@@ -670,7 +829,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = threebyfour(x, y, labelB);
                         }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                        if( updateA && probability(y * width + x, labelA, labelB, priorA, priorB) )
                         {
                             update(labelB, y * width + x, labelA);
                         }
@@ -683,7 +842,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a34 = labels[(y + 1) * width + (x + 2)];
                             if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
                             {
-                                if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                                if( updateB && probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
                                 {
                                     update(labelA, y * width + x + 1, labelB);
                                     x++;
@@ -708,7 +867,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = threebyfour(x, y, labelB);
                         }
 
-                        if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                        if( updateB && probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
                         {
                             update(labelA, y * width + x + 1, labelB);
                             x++;
@@ -722,7 +881,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a32 = labels[(y + 1) * width + (x)];
                             if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                if( updateA && probability(y * width + x, labelA, labelB, priorA, priorB) )
                                 {
                                     update(labelB, y * width + x, labelA);
                                 }
@@ -738,6 +897,10 @@ void SuperpixelSEEDSImpl::updatePixels()
     {
         for (int y = 1; y < height - 2; y++)
         {
+            bool updateA = !update_mask || update_mask[y * width + x];
+            bool updateB = !update_mask || update_mask[(y + 1) * width + x];
+            if( !updateA && !updateB )
+                continue;
 
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y + 1) * width + (x)];
@@ -762,7 +925,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = fourbythree(x, y, labelB);
                         }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                        if( updateA && probability(y * width + x, labelA, labelB, priorA, priorB) )
                         {
                             update(labelB, y * width + x, labelA);
                         }
@@ -775,7 +938,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a43 = labels[(y + 2) * width + (x + 1)];
                             if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
                             {
-                                if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                                if( updateB && probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
                                 {
                                     update(labelA, (y + 1) * width + x, labelB);
                                     y++;
@@ -800,7 +963,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = fourbythree(x, y, labelB);
                         }
 
-                        if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                        if( updateB && probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
                         {
                             update(labelA, (y + 1) * width + x, labelB);
                             y++;
@@ -814,7 +977,7 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a23 = labels[(y) * width + (x + 1)];
                             if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                if( updateA && probability(y * width + x, labelA, labelB, priorA, priorB) )
                                 {
                                     update(labelB, y * width + x, labelA);
                                 }
@@ -832,22 +995,22 @@ void SuperpixelSEEDSImpl::updatePixels()
     {
         labelA = labels[x];
         labelB = labels[width + x];
-        if( labelA != labelB )
+        if( labelA != labelB && (!update_mask || update_mask[x]) )
             update(labelB, x, labelA);
         labelA = labels[(height - 1) * width + x];
         labelB = labels[(height - 2) * width + x];
-        if( labelA != labelB )
+        if( labelA != labelB && (!update_mask || update_mask[(height - 1) * width + x]) )
             update(labelB, (height - 1) * width + x, labelA);
     }
     for (int y = 0; y < height; y++)
     {
         labelA = labels[y * width];
         labelB = labels[y * width + 1];
-        if( labelA != labelB )
+        if( labelA != labelB && (!update_mask || update_mask[y * width]) )
             update(labelB, y * width, labelA);
         labelA = labels[y * width + width - 1];
         labelB = labels[y * width + width - 2];
-        if( labelA != labelB )
+        if( labelA != labelB && (!update_mask || update_mask[y * width + width - 1]) )
             update(labelB, y * width + width - 1, labelA);
     }
 }
@@ -42,6 +42,8 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/ximgproc/segmentation.hpp"
 
 #include <iostream>
+#include <queue>
+#include <climits>
 
 namespace cv {
     namespace ximgproc {
@@ -109,6 +111,41 @@ namespace cv {
                     }
             };
 
+            // Bounding rects of the regions of a segmentation, from the extreme coordinates of their pixels
+            static void computeBoundingRects(const Mat& regions, int nb_segs, std::vector<Rect>& bounding_rects) {
+                std::vector<int> min_x(nb_segs, INT_MAX), min_y(nb_segs, INT_MAX), max_x(nb_segs, -1), max_y(nb_segs, -1);
+
+                for (int i = 0; i < (int)regions.rows; i++) {
+                    const int* p = regions.ptr<int>(i);
+
+                    for (int j = 0; j < (int)regions.cols; j++) {
+                        int seg = p[j];
+                        min_x[seg] = std::min(min_x[seg], j);
+                        max_x[seg] = std::max(max_x[seg], j);
+                        min_y[seg] = std::min(min_y[seg], i);
+                        max_y[seg] = std::max(max_y[seg], i);
+                    }
+                }
+
+                bounding_rects.resize(nb_segs);
+
+                for (int seg = 0; seg < nb_segs; seg++) {
+                    bounding_rects[seg] = max_x[seg] < 0 ? Rect() : Rect(min_x[seg], min_y[seg], max_x[seg] - min_x[seg] + 1, max_y[seg] - min_y[seg] + 1);
+                }
+            }
+
+            // Initial segmentation of an image, with the sizes, the bounding rects and the neighbours of the regions
+            struct InitialSegmentation {
+                Mat img_regions;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+
+                // Flat adjacency: the neighbours of the region i are neighbours[neighbours_start[i]] .. neighbours[neighbours_start[i + 1] - 1], in ascending order
+                std::vector<int> neighbours_start;
+                std::vector<int> neighbours;
+            };
+
             /****************************************
              * Stragegy / Color
              ***************************************/
@@ -144,61 +181,46 @@ namespace cv {
 
                 if (image_id != -1 && last_image_id != image_id) {
 
-                    std::vector<Mat> img_planes;
-                    split(img, img_planes);
+                    CV_Assert(img.depth() == CV_8U);
 
                     int histogram_bins_size = 25;
 
-                    float range[] = {0, 256};
-                    const float* histogram_ranges = {range};
-
                     double min, max;
                     minMaxLoc(regions, &min, &max);
                     int nb_segs = (int)max + 1;
 
-                    histogram_size = histogram_bins_size * img.channels();
+                    int channels = img.channels();
+                    histogram_size = histogram_bins_size * channels;
 
                     histograms = Mat_<float>(nb_segs, histogram_size);
 
-                    for (int r = 0; r < nb_segs; r++) {
-
-                        // Generate mask
-                        Mat mask = Mat(img.rows, img.cols, CV_8UC1);
-
-                        int* regions_data = (int*)regions.data;
-                        char* mask_data = (char*)mask.data;
-
-                        for (unsigned int x = 0; x < regions.total(); x++) {
-                            mask_data[x] = regions_data[x] == r ? 255 : 0;
-                        }
-
-                        // Compute histogram for each channels
-                        float tt = 0;
-
-                        Mat tmp_hists = Mat(histogram_size, 1, CV_32F);
-                        float *tmp_histogram = tmp_hists.ptr<float>(0);
-                        int h_pos = 0;
-                        Mat tmp_hist;
-
-                        for (int p = 0; p < img.channels(); p++) {
+                    // The bins of all the regions are filled in one pass over the image, the same bins as calcHist
+                    // with the [0, 256) range would give, instead of computing a masked histogram per region
+                    Mat_<int> tmp_histograms = Mat_<int>::zeros(nb_segs, histogram_size);
+                    std::vector<int> totals(nb_segs, 0);
 
-                            calcHist(&img_planes[p], 1, 0, mask, tmp_hist, 1, &histogram_bins_size, &histogram_ranges);
+                    for (int i = 0; i < img.rows; i++) {
+                        const uchar* img_data = img.ptr<uchar>(i);
+                        const int* regions_data = regions.ptr<int>(i);
 
-                            float *tmp_hist_ = tmp_hist.ptr<float>(0);
+                        for (int j = 0; j < img.cols; j++, img_data += channels) {
+                            int* histogram = tmp_histograms.ptr<int>(regions_data[j]);
 
-                            // Copy local histogram to global histogram
-                            for (int pos = 0; pos < histogram_bins_size; pos++) {
-                                tmp_histogram[pos + h_pos] = tmp_hist_[pos];
-                                tt += tmp_histogram[pos + h_pos];
+                            for (int p = 0; p < channels; p++) {
+                                histogram[p * histogram_bins_size + ((int)img_data[p] * histogram_bins_size >> 8)]++;
                             }
-                            h_pos += histogram_bins_size;
+                            totals[regions_data[j]] += channels;
                         }
+                    }
+
+                    // Normalize historgrams
+                    for (int r = 0; r < nb_segs; r++) {
 
-                        // Normalize historgrams
                         float* histogram = histograms.ptr<float>(r);
+                        const int* tmp_histogram = tmp_histograms.ptr<int>(r);
 
                         for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
-                            histogram[h_pos2] = tmp_histogram[h_pos2] / tt;
+                            histogram[h_pos2] = (float)tmp_histogram[h_pos2] / (float)totals[r];
                         }
                     }
 
@@ -432,25 +454,8 @@ namespace cv {
 
                 int nb_segs = (int)max + 1;
 
-                // Build a list of points for each regions
-                std::vector<std::vector<cv::Point> > points;
-
-                points.resize(nb_segs);
-
-                for (int i = 0; i < (int)regions.rows; i++) {
-                    const int* p = regions.ptr<int>(i);
-
-                    for (int j = 0; j < (int)regions.cols; j++) {
-                        points[p[j]].push_back(cv::Point(j, i));
-                    }
-                }
-
                 // Compute bounding rects for each regions
-                bounding_rects.resize(nb_segs);
-
-                for(int seg = 0; seg < nb_segs; seg++) {
-                    bounding_rects[seg] = cv::boundingRect(points[seg]);
-                }
+                computeBoundingRects(regions, nb_segs, bounding_rects);
             }
 
             float SelectiveSearchSegmentationStrategyFillImpl::get(int r1, int r2) {
@@ -728,7 +733,7 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const InitialSegmentation& segmentation, std::vector<Region>& regions, int image_id);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -884,77 +889,105 @@ namespace cv {
                 addStrategy(size3);
             }
 
-            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
+            static void computeInitialSegmentation(const Mat& image, const Ptr<GraphSegmentation>& gs, InitialSegmentation& seg) {
 
-                std::vector<Region> all_regions;
+                // Compute initial segmentation
+                gs->processImage(image, seg.img_regions);
 
-                int image_id = 0;
+                // Get number of regions
+                double min, max;
+                minMaxLoc(seg.img_regions, &min, &max);
+                int nb_segs = seg.nb_segs = (int)max + 1;
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+                // Compute sizes, bouding rects and neighbours
+                computeBoundingRects(seg.img_regions, nb_segs, seg.bounding_rects);
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                seg.sizes = Mat_<int>::zeros(nb_segs, 1);
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                // Pairs of different neighbouring regions, packed as from * nb_segs + to
+                std::vector<int64> pairs;
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                const int* previous_p = NULL;
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                for (int i = 0; i < (int)seg.img_regions.rows; i++) {
+                    const int* p = seg.img_regions.ptr<int>(i);
 
-                        std::vector<std::vector<cv::Point> > points;
+                    for (int j = 0; j < (int)seg.img_regions.cols; j++) {
 
-                        points.resize(nb_segs);
+                        seg.sizes(p[j], 0)++;
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                        if (i > 0 && j > 0) {
+                            const int others[] = { p[j - 1], previous_p[j], previous_p[j - 1] };
 
-                        const int* previous_p = NULL;
+                            for (int k = 0; k < 3; k++) {
+                                if (others[k] != p[j]) {
+                                    pairs.push_back((int64)p[j] * nb_segs + others[k]);
+                                    pairs.push_back((int64)others[k] * nb_segs + p[j]);
+                                }
+                            }
+                        }
+                    }
+                    previous_p = p;
+                }
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                std::sort(pairs.begin(), pairs.end());
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                seg.neighbours.resize(pairs.size());
+                seg.neighbours_start.assign(nb_segs + 1, 0);
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+                for (size_t k = 0; k < pairs.size(); k++) {
+                    seg.neighbours_start[(int)(pairs[k] / nb_segs) + 1]++;
+                    seg.neighbours[k] = (int)(pairs[k] % nb_segs);
+                }
 
-                                if (i > 0 && j > 0) {
+                for (int r = 0; r < nb_segs; r++) {
+                    seg.neighbours_start[r + 1] += seg.neighbours_start[r];
+                }
+            }
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+            // Computes the initial segmentations of all the (image, graph segmentation) pairs
+            class InitialSegmentationInvoker : public ParallelLoopBody {
+                public:
+                    InitialSegmentationInvoker(const std::vector<Mat>& images_, const std::vector<Ptr<GraphSegmentation> >& segmentations_, std::vector<InitialSegmentation>& results_) :
+                        images(images_), segmentations(segmentations_), results(results_) {
+                    }
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
+                    virtual void operator()(const Range& range) const {
+                        for (int idx = range.start; idx < range.end; idx++) {
+                            computeInitialSegmentation(images[idx / segmentations.size()], segmentations[idx % segmentations.size()], results[idx]);
                         }
+                    }
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                private:
+                    const std::vector<Mat>& images;
+                    const std::vector<Ptr<GraphSegmentation> >& segmentations;
+                    std::vector<InitialSegmentation>& results;
+            };
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
-                            }
-                        }
+                std::vector<Region> all_regions;
 
-                        image_id++;
+                // The segmentations are independent, so they are computed in parallel. The grouping stays sequential:
+                // the strategies keep per image state and the regions' ranks are drawn from rand() in a fixed order
+                int nb_pairs = (int)(images.size() * segmentations.size());
+                std::vector<InitialSegmentation> initial_segmentations(nb_pairs);
+
+                parallel_for_(Range(0, nb_pairs), InitialSegmentationInvoker(images, segmentations, initial_segmentations));
+
+                for (int image_id = 0; image_id < nb_pairs; image_id++) {
+                    const Mat& image = images[image_id / segmentations.size()];
+
+                    for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
+                        std::vector<Region> regions;
+                        hierarchicalGrouping(image, *strategy, initial_segmentations[image_id], regions, image_id);
+
+                        all_regions.insert(all_regions.end(), regions.begin(), regions.end());
                     }
+
+                    // Release the labels as soon as possible
+                    initial_segmentations[image_id] = InitialSegmentation();
                 }
 
                 std::sort(all_regions.begin(), all_regions.end());
@@ -973,16 +1006,27 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const InitialSegmentation& segmentation, std::vector<Region>& regions, int image_id) {
+
+                Mat sizes = segmentation.sizes.clone();
+                const int nb_segs = segmentation.nb_segs;
 
-                Mat sizes = sizes_.clone();
+                // Every merge adds one region, there are at most nb_segs - 1 merges
+                const int max_regions = std::max(2 * nb_segs - 1, 0);
+
+                // Best similarity on top. Pairs are not removed when one of their regions is merged, they are
+                // skipped when they reach the top instead
+                std::priority_queue<Neighbour> similarities;
+
+                // Neighbours of the not yet merged regions
+                std::vector<std::vector<int> > neighbours(max_regions);
 
-                std::vector<Neighbour> similarities;
                 regions.clear();
+                regions.reserve(max_regions);
 
                 /////////////////////////////////////////
 
-                s->setImage(img, img_regions, sizes, image_id);
+                s->setImage(img, segmentation.img_regions, sizes, image_id);
 
                 // Compute initial similarities
                 for (int i = 0; i < nb_segs; i++) {
@@ -991,32 +1035,38 @@ namespace cv {
                     r.id = i;
                     r.level = 1;
                     r.merged_to = -1;
-                    r.bounding_box = bounding_rects[i];
+                    r.bounding_box = segmentation.bounding_rects[i];
 
                     regions.push_back(r);
 
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
+                    neighbours[i].assign(segmentation.neighbours.begin() + segmentation.neighbours_start[i],
+                                         segmentation.neighbours.begin() + segmentation.neighbours_start[i + 1]);
+
+                    for (size_t k = 0; k < neighbours[i].size(); k++) {
+                        int j = neighbours[i][k];
+
+                        if (j > i) {
                             Neighbour n;
                             n.from = i;
                             n.to = j;
                             n.similarity = s->get(i, j);
 
-                            similarities.push_back(n);
+                            similarities.push(n);
                         }
                     }
                 }
 
-                while(similarities.size() > 0) {
+                // Last merge which visited the region, used to collect the neighbours of a merge only once
+                std::vector<int> visited(max_regions, -1);
 
-                    std::sort(similarities.begin(), similarities.end());
+                while(!similarities.empty()) {
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                    Neighbour p = similarities.top();
+                    similarities.pop();
 
-                    Neighbour p = similarities.back();
-                    similarities.pop_back();
+                    if (regions[p.from].merged_to != -1 || regions[p.to].merged_to != -1) {
+                        continue; // outdated pair
+                    }
 
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
@@ -1029,8 +1079,10 @@ namespace cv {
 
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    const int new_idx = (int)regions.size() - 1;
+
+                    regions[p.from].merged_to = new_idx;
+                    regions[p.to].merged_to = new_idx;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1039,44 +1091,44 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
-                    std::vector<int> local_neighbours;
-
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
-
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
-                            }
+                    // The neighbours of the new region are the neighbours of the merged ones
+                    std::vector<int>& local_neighbours = neighbours[new_idx];
+                    const int merged[] = { p.from, p.to };
 
-                            bool already_neighboor = false;
+                    for (int m = 0; m < 2; m++) {
+                        std::vector<int>& merged_neighbours = neighbours[merged[m]];
 
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
-                            }
+                        for (size_t k = 0; k < merged_neighbours.size(); k++) {
+                            int n = merged_neighbours[k];
 
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
+                            if (n != p.from && n != p.to && visited[n] != new_idx) {
+                                visited[n] = new_idx;
+                                local_neighbours.push_back(n);
                             }
-
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
                         }
+                        std::vector<int>().swap(merged_neighbours);
                     }
 
                     for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
 
+                        // Replace the merged regions by the new one
+                        std::vector<int>& other_neighbours = neighbours[*local_neighbour];
+                        size_t kept = 0;
+
+                        for (size_t k = 0; k < other_neighbours.size(); k++) {
+                            if (other_neighbours[k] != p.from && other_neighbours[k] != p.to) {
+                                other_neighbours[kept++] = other_neighbours[k];
+                            }
+                        }
+                        other_neighbours.resize(kept);
+                        other_neighbours.push_back(new_idx);
+
                         Neighbour n;
-                        n.from = (int)regions.size() - 1;
+                        n.from = new_idx;
                         n.to = *local_neighbour;
                         n.similarity = s->get(regions[n.from].id, regions[n.to].id);
 
-                        similarities.push_back(n);
+                        similarities.push(n);
                     }
                 }
 
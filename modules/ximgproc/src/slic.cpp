@@ -59,6 +59,7 @@
  */
 
 #include "precomp.hpp"
+#include "superpixel_frames.hpp"
 
 using namespace std;
 
@@ -77,6 +78,9 @@ public:
     // perform amount of iteration
     virtual void iterate( int num_iterations = 10 );
 
+    // continue segmentation on next frame
+    virtual void iterateNextFrame( InputArray image, int num_iterations = 3, float change_threshold = 2.0f );
+
     // get amount of superpixels
     virtual int getNumberOfSuperpixels() const;
 
@@ -165,11 +169,14 @@ private:
     // fetch seeds
     inline void GetChSeedsK();
 
-    // SLIC
-    inline void PerformSLIC( const int& num_iterations );
+    // recompute seeds from labels
+    inline void UpdateSeedsFromLabels();
+
+    // SLIC (optionally restricted to mask)
+    inline void PerformSLIC( const int& num_iterations, const Mat& mask = Mat() );
 
-    // SLICO
-    inline void PerformSLICO( const int& num_iterations );
+    // SLICO (optionally restricted to mask)
+    inline void PerformSLICO( const int& num_iterations, const Mat& mask = Mat() );
 
     // MSLIC
     inline void PerformMSLIC( const int& num_iterations );
@@ -991,8 +998,9 @@ struct SLICOGrowInvoker : ParallelLoopBody
     SLICOGrowInvoker( vector<Mat>* _chvec, Mat* _distchans, Mat* _distxy, Mat* _distvec,
                       Mat* _klabels, float _kseedsxn, float _kseedsyn, float _xywt,
                       float _maxchansn, vector< vector<float> > *_kseeds,
-                      int _x1, int _x2, int _nr_channels, int _n )
+                      int _x1, int _x2, int _nr_channels, int _n, const Mat* _mask = NULL )
     {
+      mask = _mask;
       chvec = _chvec;
       distchans = _distchans;
       distxy = _distxy;
@@ -1018,6 +1026,10 @@ struct SLICOGrowInvoker : ParallelLoopBody
         for( int x = x1; x < x2; x++ )
         {
           CV_Assert( y < rows && x < cols && y >= 0 && x >= 0 );
+
+          // only pixels to re-cluster
+          if( mask && !mask->at<uchar>(y,x) ) continue;
+
           distchans->at<float>(y,x) = 0;
 
             switch ( chvec->at(0).depth() )
@@ -1113,10 +1125,83 @@ struct SLICOGrowInvoker : ParallelLoopBody
     float maxchansn, xywt;
     vector<Mat>* chvec;
     Mat *distchans, *distxy, *distvec;
+    const Mat* mask;
     float kseedsxn, kseedsyn;
     int x1, x2, nr_channels, n;
 };
 
+void SuperpixelSLICImpl::iterateNextFrame( InputArray _image, int num_iterations, float change_threshold )
+{
+    vector<Mat> chvec;
+    if ( _image.isMat() )
+      split( _image.getMat(), chvec );
+    else if ( _image.isMatVector() )
+    {
+      _image.getMatVector( chvec );
+
+      // keep own copy to compare with next frame
+      for ( size_t c = 0; c < chvec.size(); c++ )
+        chvec[c] = chvec[c].clone();
+    }
+    else
+      CV_Error( Error::StsInternal, "Invalid InputArray." );
+
+    // frame should match the first one
+    CV_Assert( (int) chvec.size() == m_nr_channels );
+    CV_Assert( chvec[0].size() == Size( m_width, m_height ) );
+    CV_Assert( chvec[0].depth() == m_chvec[0].depth() );
+
+    // tiles that changed since previous frame
+    Mat diff, mask;
+    frameDifference( m_chvec, chvec, diff );
+    int nr_changed = markChangedTiles( diff, Size( m_region_size, m_region_size ),
+                                       change_threshold, mask );
+
+    m_chvec = chvec;
+
+    // warm start: current clusters
+    // measured on the new frame
+    UpdateSeedsFromLabels();
+
+    if ( nr_changed == 0 )
+      return;
+
+    m_iterations = num_iterations;
+
+    if( m_algorithm == SLICO )
+      PerformSLICO( num_iterations, mask );
+    else if( m_algorithm == SLIC )
+      PerformSLIC( num_iterations, mask );
+    else if( m_algorithm == MSLIC )
+      PerformMSLIC( num_iterations );
+    else
+      CV_Error( Error::StsInternal, "No such algorithm" );
+
+    // re-update amount of labels
+    m_numlabels = (int)m_kseeds[0].size();
+}
+
+inline void SuperpixelSLICImpl::UpdateSeedsFromLabels()
+{
+    // labels may be renumbered by enforceLabelConnectivity()
+    for ( int b = 0; b < m_nr_channels; b++ )
+      m_kseeds[b].resize( m_numlabels );
+    m_kseedsx.resize( m_numlabels );
+    m_kseedsy.resize( m_numlabels );
+    if( m_algorithm == MSLIC )
+      m_adaptk.resize( m_numlabels, 1.0f );
+
+    // parallel reduce structure
+    SeedsCenters sc( m_chvec, m_klabels, m_numlabels, m_nr_channels );
+
+    // accumulate center distances
+    parallel_reduce( BlockedRange(0, m_width), sc );
+
+    // normalize centers
+    parallel_for_( Range(0, m_numlabels), SeedNormInvoker( &m_kseeds, &sc.sigma,
+                   &sc.clustersize, &sc.sigmax, &sc.sigmay, &m_kseedsx, &m_kseedsy, m_nr_channels ) );
+}
+
 /*
  *
  *    Magic SLIC - no parameters
@@ -1135,8 +1220,10 @@ struct SLICOGrowInvoker : ParallelLoopBody
  * not the step size S.
  *
  */
-inline void SuperpixelSLICImpl::PerformSLICO( const int&  itrnum )
+inline void SuperpixelSLICImpl::PerformSLICO( const int&  itrnum, const Mat& mask )
 {
+    const Mat* pmask = mask.empty() ? NULL : &mask;
+
     Mat distxy( m_height, m_width, CV_32F, Scalar::all(FLT_MAX) );
     Mat distvec( m_height, m_width, CV_32F, Scalar::all(FLT_MAX) );
     Mat distchans( m_height, m_width, CV_32F, Scalar::all(FLT_MAX) );
@@ -1158,9 +1245,14 @@ inline void SuperpixelSLICImpl::PerformSLICO( const int&  itrnum )
             int x1 = max(0, (int) m_kseedsx[n] - m_region_size);
             int x2 = min((int) m_width,(int) m_kseedsx[n] + m_region_size);
 
+            // skip clusters without pixels to re-cluster
+            if( pmask && ( x1 >= x2 || y1 >= y2 ||
+                countNonZero( mask( Range(y1, y2), Range(x1, x2) ) ) == 0 ) )
+              continue;
+
             parallel_for_( Range(y1, y2), SLICOGrowInvoker( &m_chvec, &distchans, &distxy, &distvec,
                            &m_klabels, m_kseedsx[n], m_kseedsy[n], xywt, maxchans[n], &m_kseeds,
-                           x1, x2, m_nr_channels, n ) );
+                           x1, x2, m_nr_channels, n, pmask ) );
         }
         //-----------------------------------------------------------------
         // Assign the max color distance for a cluster
@@ -1175,6 +1267,9 @@ inline void SuperpixelSLICImpl::PerformSLICO( const int&  itrnum )
         {
           for( int y = 0; y < m_height; y++ )
           {
+              // distances exist only for re-clustered pixels
+              if( pmask && !mask.at<uchar>(y,x) ) continue;
+
               int idx = m_klabels.at<int>(y,x);
 
               if( maxchans[idx] < distchans.at<float>(y,x) )
@@ -1206,8 +1301,9 @@ struct SLICGrowInvoker : ParallelLoopBody
     SLICGrowInvoker( vector<Mat>* _chvec, Mat* _distvec, Mat* _klabels,
                      float _kseedsxn, float _kseedsyn, float _xywt,
                      vector< vector<float> > *_kseeds, int _x1, int _x2,
-                     int _nr_channels, int _n )
+                     int _nr_channels, int _n, const Mat* _mask = NULL )
     {
+      mask = _mask;
       chvec = _chvec;
       distvec = _distvec;
       kseedsxn = _kseedsxn;
@@ -1227,6 +1323,9 @@ struct SLICGrowInvoker : ParallelLoopBody
       {
         for( int x = x1; x < x2; x++ )
         {
+          // only pixels to re-cluster
+          if( mask && !mask->at<uchar>(y,x) ) continue;
+
           float dist = 0;
 
           switch ( chvec->at(0).depth() )
@@ -1315,6 +1414,7 @@ struct SLICGrowInvoker : ParallelLoopBody
     float xywt;
     vector<Mat>* chvec;
     Mat *distvec;
+    const Mat* mask;
     float kseedsxn, kseedsyn;
     int x1, x2, nr_channels, n;
 };
@@ -1326,9 +1426,10 @@ struct SLICGrowInvoker : ParallelLoopBody
  * over the entire image.
  *
  */
-inline void SuperpixelSLICImpl::PerformSLIC( const int&  itrnum )
+inline void SuperpixelSLICImpl::PerformSLIC( const int&  itrnum, const Mat& mask )
 {
     Mat distvec( m_height, m_width, CV_32F );
+    const Mat* pmask = mask.empty() ? NULL : &mask;
 
     const float xywt = (m_region_size/m_ruler)*(m_region_size/m_ruler);
 
@@ -1342,9 +1443,14 @@ inline void SuperpixelSLICImpl::PerformSLIC( const int&  itrnum )
             int x1 = max(0, (int) m_kseedsx[n] - m_region_size);
             int x2 = min((int) m_width,(int) m_kseedsx[n] + m_region_size);
 
+            // skip clusters without pixels to re-cluster
+            if( pmask && ( x1 >= x2 || y1 >= y2 ||
+                countNonZero( mask( Range(y1, y2), Range(x1, x2) ) ) == 0 ) )
+              continue;
+
             parallel_for_( Range(y1, y2), SLICGrowInvoker( &m_chvec, &distvec,
                            &m_klabels, m_kseedsx[n], m_kseedsy[n], xywt, &m_kseeds,
-                           x1, x2, m_nr_channels, n ) );
+                           x1, x2, m_nr_channels, n, pmask ) );
         }
 
         //-----------------------------------------------------------------
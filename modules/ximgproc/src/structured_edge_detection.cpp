@@ -42,11 +42,15 @@
 #include <iterator>
 #include <iostream>
 #include <cmath>
+#include <climits>
 
 #include "precomp.hpp"
 
 #include "advanced_types.hpp"
 
+#include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+
 /********************* Helper functions *********************/
 
 /*!
@@ -169,6 +173,127 @@ static cv::Mat rgb2luv(const cv::Mat &src)
     return dst;
 }
 
+/*!
+ * Computes gradient magnitude and orientation (in [0;1]) of the channel
+ * with the largest gradient for a range of rows
+ */
+class GradientMagnitudeInvoker : public cv::ParallelLoopBody
+{
+public:
+    GradientMagnitudeInvoker(const cv::Mat &_Dx, const cv::Mat &_Dy,
+                             cv::Mat &_magnitude, cv::Mat &_phase)
+        : Dx(_Dx), Dy(_Dy), magnitude(_magnitude), phase(_phase) {}
+
+    virtual void operator()(const cv::Range &range) const
+    {
+        const int nchannels = Dx.channels();
+        const int cols = Dx.cols;
+        const int len = cols*nchannels;
+
+        cv::AutoBuffer <float> buffer(len + 3*cols);
+        float *sqrMagn = buffer;
+        float *bestDx = sqrMagn + len;
+        float *bestDy = bestDx + cols;
+        float *angle = bestDy + cols;
+
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const float *pDx = Dx.ptr<float>(i);
+            const float *pDy = Dy.ptr<float>(i);
+
+            float *pMagnitude = magnitude.ptr<float>(i);
+            float *pPhase = phase.ptr<float>(i);
+
+            int j = 0;
+#if CV_SIMD128
+            for (; j <= len - 4; j += 4)
+            {
+                cv::v_float32x4 dx = cv::v_load(pDx + j);
+                cv::v_float32x4 dy = cv::v_load(pDy + j);
+                cv::v_store(sqrMagn + j, dx*dx + dy*dy);
+            }
+#endif
+            for (; j < len; ++j)
+                sqrMagn[j] = CV_SQR( pDx[j] ) + CV_SQR( pDy[j] );
+
+            for (j = 0; j < cols; ++j)
+            {
+                float fMagn = float(-1e-5), fdx = 0, fdy = 0;
+                for (int k = j*nchannels; k < (j + 1)*nchannels; ++k)
+                    if (sqrMagn[k] > fMagn)
+                    {
+                        fMagn = sqrMagn[k];
+                        fdx = pDx[k];
+                        fdy = pDy[k];
+                    }
+
+                pMagnitude[j] = fMagn;
+                bestDx[j] = fdx;
+                bestDy[j] = fdy;
+            }
+
+            j = 0;
+#if CV_SIMD128
+            for (; j <= cols - 4; j += 4)
+                cv::v_store(pMagnitude + j, cv::v_sqrt(cv::v_load(pMagnitude + j)));
+#endif
+            for (; j < cols; ++j)
+                pMagnitude[j] = sqrtf(pMagnitude[j]);
+
+            cv::hal::fastAtan2(bestDy, bestDx, angle, cols, true);
+
+            for (j = 0; j < cols; ++j)
+            {
+                float fdx = bestDx[j], fdy = bestDy[j];
+
+                pPhase[j] = std::fabs(fdx) + std::fabs(fdy) < 1e-5
+                    ? 0.5f : angle[j] / 180.0f - 1.0f * (fdy < 0);
+            }
+        }
+    }
+
+private:
+    const cv::Mat &Dx, &Dy;
+    cv::Mat &magnitude, &phase;
+};
+
+/*!
+ * Accumulates magnitude weighted orientations into a range of histogram rows
+ */
+class GradientHistogramInvoker : public cv::ParallelLoopBody
+{
+public:
+    GradientHistogramInvoker(const cv::Mat &_phase, const cv::Mat &_magnitude,
+                             cv::Mat &_histogram, int _nBins, int _pSize)
+        : phase(_phase), magnitude(_magnitude), histogram(_histogram),
+          nBins(_nBins), pSize(_pSize) {}
+
+    virtual void operator()(const cv::Range &range) const
+    {
+        int pHistSize = histogram.cols*histogram.channels() - 1;
+
+        for (int i = range.start*pSize; i < std::min(range.end*pSize, phase.rows); ++i)
+        {
+            const float *pPhase = phase.ptr<float>(i);
+            const float *pMagn  = magnitude.ptr<float>(i);
+
+            float *pHist = histogram.ptr<float>(i/pSize);
+
+            for (int j = 0; j < phase.cols; ++j)
+            {
+                int index  = cvRound((j/pSize + pPhase[j])*nBins);
+                index = std::max(0, std::min(index, pHistSize));
+                pHist[index] += pMagn[j] / CV_SQR(pSize);
+            }
+        }
+    }
+
+private:
+    const cv::Mat &phase, &magnitude;
+    cv::Mat &histogram;
+    int nBins, pSize;
+};
+
 /*!
  * The function computes gradient magnitude and weighted (with magnitude)
  * orientation histogram. Magnitude is additionally normalized
@@ -199,57 +324,15 @@ static void gradientHist(const cv::Mat &src, cv::Mat &magnitude, cv::Mat &histog
     cv::Sobel( src, Dy, cv::DataType<float>::type,
         0, 1, 1, 1.0, 0.0, cv::BORDER_REFLECT );
 
-    int nchannels = src.channels();
-
-    for (int i = 0; i < src.rows; ++i)
-    {
-        const float *pDx = Dx.ptr<float>(i);
-        const float *pDy = Dy.ptr<float>(i);
-
-        float *pMagnitude = magnitude.ptr<float>(i);
-        float *pPhase = phase.ptr<float>(i);
-
-        for (int j = 0; j < src.cols*nchannels; j += nchannels)
-        {
-            float fMagn = float(-1e-5), fdx = 0, fdy = 0;
-            for (int k = 0; k < nchannels; ++k)
-            {
-                float cMagn = CV_SQR( pDx[j + k] ) + CV_SQR( pDy[j + k] );
-                if (cMagn > fMagn)
-                {
-                    fMagn = cMagn;
-                    fdx = pDx[j + k];
-                    fdy = pDy[j + k];
-                }
-            }
-
-            pMagnitude[j/nchannels] = sqrtf(fMagn);
-
-            float angle = cv::fastAtan2(fdy, fdx) / 180.0f - 1.0f * (fdy < 0);
-            if (std::fabs(fdx) + std::fabs(fdy) < 1e-5)
-                angle = 0.5f;
-            pPhase[j/nchannels] = angle;
-        }
-    }
+    cv::parallel_for_( cv::Range(0, src.rows),
+        GradientMagnitudeInvoker(Dx, Dy, magnitude, phase) );
 
     magnitude /= imsmooth( magnitude, gnrmRad )
         + 0.01*cv::Mat::ones( magnitude.size(), magnitude.type() );
 
-    int pHistSize = histogram.cols*histogram.channels() - 1;
-    for (int i = 0; i < phase.rows; ++i)
-    {
-        const float *pPhase = phase.ptr<float>(i);
-        const float *pMagn  = magnitude.ptr<float>(i);
-
-        float *pHist = histogram.ptr<float>(i/pSize);
-
-        for (int j = 0; j < phase.cols; ++j)
-        {
-            int index  = cvRound((j/pSize + pPhase[j])*nBins);
-            index = std::max(0, std::min(index, pHistSize));
-            pHist[index] += pMagn[j] / CV_SQR(pSize);
-        }
-    }
+    // every histogram row gathers its own pSize source rows
+    cv::parallel_for_( cv::Range(0, histogram.rows),
+        GradientHistogramInvoker(phase, magnitude, histogram, nBins, pSize) );
 }
 
 /********************* RFFeatureGetter class *********************/
@@ -335,6 +418,133 @@ namespace cv
 namespace ximgproc
 {
 
+/*!
+ * Tree node with its split feature resolved to a patch row and
+ * an offset inside that row of the feature images, so that a node
+ * fits into 16 bytes, doesn't depend on the image size and the
+ * whole forest is one flat array built when the model is loaded
+ */
+struct RandomForestNode
+{
+    float threshold; /*!< threshold applied to the feature */
+    int child;       /*!< k --> child - 1, child (relative to the tree root), 0 for leaves */
+    short rowA;      /*!< patch row of the regular (or the first self-similarity) feature */
+    short colA;      /*!< its offset inside the row, column*channels + channel */
+    short rowB;      /*!< patch row of the second self-similarity feature, -1 for regular ones */
+    short colB;      /*!< its offset inside the row */
+};
+
+/*!
+ * Evaluates the trees for a range of patch rows and stores reached leaves
+ */
+class TreeTraversalInvoker : public ParallelLoopBody
+{
+public:
+    TreeTraversalInvoker(const NChannelsMat &_regFeatures, const NChannelsMat &_ssFeatures,
+                         const RandomForestNode *_forest, NChannelsMat &_indexes,
+                         int _nTrees, int _nTreesNodes, int _stride, int _shrink)
+        : regFeatures(_regFeatures), ssFeatures(_ssFeatures), forest(_forest), indexes(_indexes),
+          nTrees(_nTrees), nTreesNodes(_nTreesNodes), stride(_stride), shrink(_shrink) {}
+
+    virtual void operator()(const Range &range) const
+    {
+        const int nchannels = regFeatures.channels();
+        const int nTreesEval = indexes.channels();
+        const int width = indexes.cols;
+        const int rowStep = regFeatures.cols*nchannels;
+
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
+            const float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+
+            int *indexPtr = indexes.ptr<int>(i);
+
+            for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                // for j,k in [0;width)x[0;nTreesEval)
+            {
+                const RandomForestNode *root
+                    = forest + ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
+                const RandomForestNode *node = root;
+                // select root node of the tree to evaluate
+
+                int offset = (j*stride/shrink)*nchannels;
+                while (node->child != 0)
+                {
+                    int offsetA = offset + node->rowA*rowStep + node->colA;
+                    float currentFeature = node->rowB < 0
+                        ? regFeaturesPtr[offsetA]
+                        : ssFeaturesPtr[offsetA] - ssFeaturesPtr[offset + node->rowB*rowStep + node->colB];
+
+                    // compare feature to threshold and move left or right accordingly
+                    node = root + node->child - (currentFeature < node->threshold);
+                }
+
+                indexPtr[j*nTreesEval + k] = int(node - forest);
+            }
+        }
+    }
+
+private:
+    const NChannelsMat &regFeatures, &ssFeatures;
+    const RandomForestNode *forest;
+    NChannelsMat &indexes;
+    int nTrees, nTreesNodes, stride, shrink;
+};
+
+/*!
+ * Accumulates leaf edge maps of a range of row stripes. Stripes of the same
+ * parity never write to the same output rows, so each of them accumulates
+ * straight into its own part of dst.
+ */
+class EdgeAccumulationInvoker : public ParallelLoopBody
+{
+public:
+    EdgeAccumulationInvoker(const NChannelsMat &_indexes, const std::vector <int> &_edgeBoundaries,
+                            const std::vector <int> &_edgeBins, const std::vector <int> &_offsetE,
+                            Mat &_dst, int _stride, int _stripeHeight, int _parity, float _step)
+        : indexes(_indexes), edgeBoundaries(_edgeBoundaries), edgeBins(_edgeBins), offsetE(_offsetE),
+          dst(_dst), stride(_stride), stripeHeight(_stripeHeight), parity(_parity), step(_step) {}
+
+    virtual void operator()(const Range &range) const
+    {
+        const int nTreesEval = indexes.channels();
+        const int width = indexes.cols;
+
+        for (int s = range.start; s < range.end; ++s)
+        {
+            int iStart = (2*s + parity)*stripeHeight;
+            int iEnd = std::min(iStart + stripeHeight, indexes.rows);
+
+            for (int i = iStart; i < iEnd; ++i)
+            {
+                const int *pIndex = indexes.ptr<int>(i);
+                float *pDst = dst.ptr<float>(i*stride);
+
+                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                {// for j,k in [0;width)x[0;nTreesEval)
+
+                    int currentNode = pIndex[j*nTreesEval + k];
+
+                    int start  = edgeBoundaries[currentNode];
+                    int finish = edgeBoundaries[currentNode + 1];
+
+                    int offset = j*stride;
+                    for (int p = start; p < finish; ++p)
+                        pDst[offset + offsetE[edgeBins[p]]] += step;
+                }
+            }
+        }
+    }
+
+private:
+    const NChannelsMat &indexes;
+    const std::vector <int> &edgeBoundaries, &edgeBins, &offsetE;
+    Mat &dst;
+    int stride, stripeHeight, parity;
+    float step;
+};
+
 class StructuredEdgeDetectionImpl : public StructuredEdgeDetection
 {
 public:
@@ -437,6 +647,8 @@ public:
         }
 
         __rf.numberOfTreeNodes = int( __rf.childs.size() ) / __rf.options.numberOfTrees;
+
+        flattenForest();
     }
 
     /*!
@@ -471,73 +683,37 @@ public:
 
 protected:
     /*!
-     * Private method used by process method. The function
-     * predict edges in n-channel feature image and store them to dst.
-     *
-     * \param features : source image (n-channels, float) to detect edges
-     * \param dst : destination image (grayscale, float, in [0;1]) where edges are drawn
+     * Builds __rf.nodes, the flat forest with the split features
+     * resolved to positions inside the feature patches.
      */
-    void predictEdges(const NChannelsMat &features, cv::Mat &dst) const
+    void flattenForest()
     {
         int shrink = __rf.options.shrinkNumber;
-        int rfs = __rf.options.regFeatureSmoothingRadius;
-        int sfs = __rf.options.ssFeatureSmoothingRadius;
-
-        int nTreesEval = __rf.options.numberOfTreesToEvaluate;
-        int nTrees = __rf.options.numberOfTrees;
-        int nTreesNodes = __rf.numberOfTreeNodes;
-
-        const int nchannels = features.channels();
-        int pSize  = __rf.options.patchSize;
-
-        int nFeatures = CV_SQR(pSize/shrink)*nchannels;
-        int outNum = __rf.options.numberOfOutputChannels;
-
-        int stride = __rf.options.stride;
-        int ipSize = __rf.options.patchInnerSize;
+        int pSize = __rf.options.patchSize/shrink;
+        int nchannels = __rf.options.numberOfOutputChannels;
         int gridSize = __rf.options.selfsimilarityGridSize;
 
-        const int height = cvCeil( double(features.rows*shrink - pSize) / stride );
-        const int width  = cvCeil( double(features.cols*shrink - pSize) / stride );
-        // image size in patches with overlapping
-
-        //-------------------------------------------------------------------------
-
-        NChannelsMat regFeatures = imsmooth(features, cvRound(rfs / float(shrink)));
-        NChannelsMat  ssFeatures = imsmooth(features, cvRound(sfs / float(shrink)));
-
-        NChannelsMat indexes(height, width, CV_MAKETYPE(DataType<int>::type, nTreesEval));
-
-        std::vector <int> offsetI(/**/ CV_SQR(pSize/shrink)*nchannels, 0);
-        for (int i = 0; i < CV_SQR(pSize/shrink)*nchannels; ++i)
-        {
-            int z = i / CV_SQR(pSize/shrink);
-            int y = ( i % CV_SQR(pSize/shrink) )/(pSize/shrink);
-            int x = ( i % CV_SQR(pSize/shrink) )%(pSize/shrink);
+        int nFeatures = CV_SQR(pSize)*nchannels;
 
-            offsetI[i] = x*features.cols*nchannels + y*nchannels + z;
-        }
-        // lookup table for mapping linear index to offsets
-
-        std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
-        for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
+        std::vector <Point> positionsI(/**/ CV_SQR(pSize)*nchannels);
+        for (int i = 0; i < CV_SQR(pSize)*nchannels; ++i)
         {
-            int z = i / CV_SQR(ipSize);
-            int y = ( i % CV_SQR(ipSize) )/ipSize;
-            int x = ( i % CV_SQR(ipSize) )%ipSize;
+            int z = i / CV_SQR(pSize);
+            int y = ( i % CV_SQR(pSize) )/pSize;
+            int x = ( i % CV_SQR(pSize) )%pSize;
 
-            offsetE[i] = x*dst.cols*outNum + y*outNum + z;
+            positionsI[i] = Point(y*nchannels + z, x);
         }
-        // lookup table for mapping linear index to offsets
+        // lookup table for mapping linear index to (offset in the row, row)
 
-        std::vector <int> offsetX( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
-        std::vector <int> offsetY( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
+        std::vector <Point> positionsX( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels );
+        std::vector <Point> positionsY( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels );
 
-        int hc = cvRound( (pSize/shrink) / (2.0*gridSize) );
+        int hc = cvRound( pSize / (2.0*gridSize) );
         // half of cell
         std::vector <int> gridPositions;
         for(int i = 0; i < gridSize; i++)
-            gridPositions.push_back( int( (i+1)*(pSize/shrink + 2*hc - 1)/(gridSize + 1.0) - hc + 0.5f ) );
+            gridPositions.push_back( int( (i+1)*(pSize + 2*hc - 1)/(gridSize + 1.0) - hc + 0.5f ) );
 
         for (int i = 0, n = 0; i < CV_SQR(gridSize)*nchannels; ++i)
             for (int j = (i%CV_SQR(gridSize)) + 1; j < CV_SQR(gridSize); ++j, ++n)
@@ -550,89 +726,111 @@ protected:
                 int x2 = gridPositions[j%gridSize];
                 int y2 = gridPositions[j/gridSize];
 
-                offsetX[n] = x1*features.cols*nchannels + y1*nchannels + z;
-                offsetY[n] = x2*features.cols*nchannels + y2*nchannels + z;
+                positionsX[n] = Point(y1*nchannels + z, x1);
+                positionsY[n] = Point(y2*nchannels + z, x2);
             }
-            // lookup tables for mapping linear index to offset pairs
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
+            // lookup tables for mapping linear index to position pairs
+
+        CV_StaticAssert( sizeof(RandomForestNode) == 4*sizeof(int), "RandomForestNode must fit into CV_32SC4" );
+        CV_Assert( pSize*nchannels <= SHRT_MAX );
+
+        // Mat keeps the nodes in one aligned block
+        __rf.nodes.create( int(__rf.childs.size()), 1, CV_32SC4 );
+        RandomForestNode *nodes = __rf.nodes.ptr<RandomForestNode>();
+        for (size_t n = 0; n < __rf.childs.size(); ++n)
         {
-            float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
-            float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+            RandomForestNode &node = nodes[n];
 
-            int *indexPtr = indexes.ptr<int>(i);
+            node.threshold = __rf.thresholds[n];
+            node.child = __rf.childs[n];
+            node.rowA = node.colA = node.colB = 0;
+            node.rowB = -1;
 
-            for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                // for j,k in [0;width)x[0;nTreesEval)
+            if (node.child == 0)
+                continue;
+
+            int currentId = __rf.featureIds[n];
+            Point a, b(0, -1);
+            if (currentId >= nFeatures)
             {
-                int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
-                int currentNode = baseNode;
-                // select root node of the tree to evaluate
+                a = positionsX[currentId - nFeatures];
+                b = positionsY[currentId - nFeatures];
+            }
+            else
+                a = positionsI[currentId];
 
-                int offset = (j*stride/shrink)*nchannels;
-                while ( __rf.childs[currentNode] != 0 )
-                {
-                    int currentId = __rf.featureIds[currentNode];
-                    float currentFeature;
+            node.rowA = short(a.y);
+            node.colA = short(a.x);
+            node.rowB = short(b.y);
+            node.colB = short(b.x);
+        }
+    }
 
-                    if (currentId >= nFeatures)
-                    {
-                        int xIndex = offsetX[currentId - nFeatures];
-                        float A = ssFeaturesPtr[offset + xIndex];
+    /*!
+     * Private method used by process method. The function
+     * predict edges in n-channel feature image and store them to dst.
+     *
+     * \param features : source image (n-channels, float) to detect edges
+     * \param dst : destination image (grayscale, float, in [0;1]) where edges are drawn
+     */
+    void predictEdges(const NChannelsMat &features, cv::Mat &dst) const
+    {
+        int shrink = __rf.options.shrinkNumber;
+        int rfs = __rf.options.regFeatureSmoothingRadius;
+        int sfs = __rf.options.ssFeatureSmoothingRadius;
 
-                        int yIndex = offsetY[currentId - nFeatures];
-                        float B = ssFeaturesPtr[offset + yIndex];
+        int nTreesEval = __rf.options.numberOfTreesToEvaluate;
+        int nTrees = __rf.options.numberOfTrees;
+        int nTreesNodes = __rf.numberOfTreeNodes;
 
-                        currentFeature = A - B;
-                    }
-                    else
-                        currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
+        int pSize  = __rf.options.patchSize;
+        int outNum = __rf.options.numberOfOutputChannels;
 
-                    // compare feature to threshold and move left or right accordingly
-                    if (currentFeature < __rf.thresholds[currentNode])
-                        currentNode = baseNode + __rf.childs[currentNode] - 1;
-                    else
-                        currentNode = baseNode + __rf.childs[currentNode];
-                }
+        // the nodes of the forest are resolved for this number of channels
+        CV_Assert( features.channels() == outNum );
 
-                indexPtr[j*nTreesEval + k] = currentNode;
-            }
-        }
+        int stride = __rf.options.stride;
+        int ipSize = __rf.options.patchInnerSize;
+
+        const int height = cvCeil( double(features.rows*shrink - pSize) / stride );
+        const int width  = cvCeil( double(features.cols*shrink - pSize) / stride );
+        // image size in patches with overlapping
 
-        NChannelsMat dstM(dst.size(),
-            CV_MAKETYPE(DataType<float>::type, outNum));
-        dstM.setTo(0);
+        //-------------------------------------------------------------------------
 
-        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
+        NChannelsMat regFeatures = imsmooth(features, cvRound(rfs / float(shrink)));
+        NChannelsMat  ssFeatures = imsmooth(features, cvRound(sfs / float(shrink)));
+
+        NChannelsMat indexes(height, width, CV_MAKETYPE(DataType<int>::type, nTreesEval));
+
+        std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
+        for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
         {
-            int *pIndex = indexes.ptr<int>(i);
-            float *pDst = dstM.ptr<float>(i*stride);
+            int y = ( i % CV_SQR(ipSize) )/ipSize;
+            int x = ( i % CV_SQR(ipSize) )%ipSize;
 
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                {// for j,k in [0;width)x[0;nTreesEval)
+            offsetE[i] = x*dst.cols + y;
+        }
+        // lookup table for mapping linear index to offsets,
+        // output channels are summed up anyway, so they share one plane
 
-                    int currentNode = pIndex[j*nTreesEval + k];
+        parallel_for_( Range(0, height), TreeTraversalInvoker(regFeatures, ssFeatures,
+            __rf.nodes.ptr<RandomForestNode>(), indexes, nTrees, nTreesNodes, stride, shrink) );
 
-                    int start  = __rf.edgeBoundaries[currentNode];
-                    int finish = __rf.edgeBoundaries[currentNode + 1];
+        Mat dstM( dst.size(), DataType<float>::type, Scalar::all(0) );
 
-                    if (start == finish)
-                        continue;
+        // patch rows writing to the same output rows are at most
+        // ipSize/stride apart, so stripes of the same parity are independent
+        int stripeHeight = std::max( 8, cvCeil(double(ipSize) / stride) );
+        int nStripes = (height + stripeHeight - 1) / stripeHeight;
 
-                    int offset = j*stride*outNum;
-                    for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
-                }
-        }
+        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
+        for (int parity = 0; parity < 2; ++parity)
+            parallel_for_( Range(0, (nStripes + 1 - parity)/2),
+                EdgeAccumulationInvoker(indexes, __rf.edgeBoundaries, __rf.edgeBins,
+                    offsetE, dstM, stride, stripeHeight, parity, step) );
 
-        cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
-        imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
+        imsmooth( dstM, 1 ).copyTo(dst);
     }
 
 /********************* Members *********************/
@@ -690,6 +888,8 @@ protected:
 
         std::vector <int> edgeBoundaries; /*!< ... */
         std::vector <int> edgeBins;       /*!< ... */
+
+        Mat nodes;                        /*!< RandomForestNode array built by flattenForest() */
     } __rf;
 };
 
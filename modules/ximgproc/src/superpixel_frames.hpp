@@ -0,0 +1,117 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of Intel Corporation may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __SUPERPIXEL_FRAMES_HPP__
+#define __SUPERPIXEL_FRAMES_HPP__
+#ifdef __cplusplus
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/********************* Helpers for superpixels on video frames *********************/
+
+namespace cv
+{
+namespace ximgproc
+{
+
+/*!
+ * Per-pixel mean absolute difference of two frames over all channels
+ *
+ * \param prev : channels of the previous frame
+ * \param next : channels of the next frame, of the same size and depth
+ * \param diff : destination CV_32F difference image
+ */
+static inline void frameDifference(const std::vector<Mat> &prev, const std::vector<Mat> &next, Mat &diff)
+{
+    CV_Assert( !next.empty() && prev.size() == next.size() );
+
+    diff = Mat::zeros( next[0].size(), CV_32F );
+
+    Mat chdiff;
+    for (size_t c = 0; c < next.size(); ++c)
+    {
+        CV_Assert( prev[c].size() == next[c].size() && prev[c].type() == next[c].type() );
+
+        absdiff( prev[c], next[c], chdiff );
+        chdiff.convertTo( chdiff, CV_32F, 1.0 / next.size() );
+        diff += chdiff;
+    }
+}
+
+/*!
+ * Marks the tiles whose mean change exceeds a threshold
+ *
+ * \param change : per-pixel CV_32F change measure
+ * \param tile : tile size, the last row and column of tiles may be smaller
+ * \param threshold : tiles with mean change above threshold are marked
+ * \param mask : destination CV_8U mask, 255 inside marked tiles and 0 elsewhere
+ * \return number of marked tiles
+ */
+static inline int markChangedTiles(const Mat &change, Size tile, float threshold, Mat &mask)
+{
+    CV_Assert( change.type() == CV_32F && tile.width > 0 && tile.height > 0 );
+
+    Mat sum;
+    integral( change, sum, CV_64F );
+
+    mask.create( change.size(), CV_8U );
+
+    int nr_changed = 0;
+    for (int y = 0; y < change.rows; y += tile.height)
+        for (int x = 0; x < change.cols; x += tile.width)
+        {
+            Rect r( x, y, std::min(tile.width, change.cols - x), std::min(tile.height, change.rows - y) );
+
+            double mean = ( sum.at<double>(r.y, r.x) + sum.at<double>(r.y + r.height, r.x + r.width)
+                          - sum.at<double>(r.y, r.x + r.width) - sum.at<double>(r.y + r.height, r.x) ) / r.area();
+
+            bool changed = mean > threshold;
+            mask(r).setTo( Scalar::all(changed ? 255 : 0) );
+            nr_changed += changed;
+        }
+
+    return nr_changed;
+}
+
+}
+}
+
+#endif
+#endif
@@ -150,50 +150,23 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
 
 
 /***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
+ * Struct: WMFWorkspace
+ * Description: joint-histogram, BCB and their necklace tables used to filter a range of columns.
+ *                Allocated once per range and reused for every column and channel of it.
+ *                The joint-histogram is all zeros between the columns.
  ***************************************************************/
-float** float2D(int dim1, int dim2)
+struct WMFWorkspace
 {
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
+    WMFWorkspace(int nI, int nF)
+        : H(nI*nF, 0), Hf(nI*nF), Hb(nI*nF), BCB(nF), BCBf(nF), BCBb(nF) {}
 
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
+    vector<int> H;    // joint-histogram, nI x nF
+    vector<int> Hf;   // forward links of the joint-histogram rows
+    vector<int> Hb;   // backward links of the joint-histogram rows
+    vector<int> BCB;
+    vector<int> BCBf; // forward link
+    vector<int> BCBb; // backward link
+};
 
 /***************************************************************
  * Function: updateBCB
@@ -201,7 +174,7 @@ void int2D_release(int **p)
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -231,7 +204,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
+void featureIndexing(Mat &F, Mat &wMap, int &nF, float sigmaI, int weightType){
     // Configuration and Declaration
     Mat FNew;
     int cols = F.cols, rows = F.rows;
@@ -247,7 +220,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -269,7 +242,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -279,9 +252,8 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
-
-        memset(hash,0,sizeof(hash));
+        const int hashSize[] = {LOW_NUM, LOW_NUM, LOW_NUM};
+        Mat hash(3, hashSize, CV_32S, Scalar(0));
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
@@ -294,10 +266,10 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                 lowG = FPtr[i3+1]>>shift;
                 lowR = FPtr[i3+2]>>shift;
 
-                if(hash[lowB][lowG][lowR]==0)
+                if(hash.at<int>(lowB,lowG,lowR)==0)
                 {
                     candCnt++;
-                    hash[lowB][lowG][lowR]=1;
+                    hash.at<int>(lowB,lowG,lowR)=1;
                 }
             }
         }
@@ -308,7 +280,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         //prepare for K-means
         int top=0;
         for(int i=0;i<LOW_NUM;i++)for(int j=0;j<LOW_NUM;j++)for(int k=0;k<LOW_NUM;k++){
-            if(hash[i][j][k]){
+            if(hash.at<int>(i,j,k)){
                 samples.ptr<float>(top)[0] = (float)i;
                 samples.ptr<float>(top)[1] = (float)j;
                 samples.ptr<float>(top)[2] = (float)k;
@@ -325,9 +297,9 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         top = 0;
         for(int i=0;i<LOW_NUM;i++)for(int j=0;j<LOW_NUM;j++)for(int k=0;k<LOW_NUM;k++)
         {
-            if(hash[i][j][k])
+            if(hash.at<int>(i,j,k))
             {
-                hash[i][j][k] = labels.ptr<int>(top)[0];
+                hash.at<int>(i,j,k) = labels.ptr<int>(top)[0];
                 top++;
             }
         }
@@ -343,15 +315,15 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
             lowG = FPtr[i3+1]>>shift;
             lowR = FPtr[i3+2]>>shift;
 
-            FNew.ptr<int>()[i] = hash[lowB][lowG][lowR];
+            FNew.ptr<int>()[i] = hash.at<int>(lowB,lowG,lowR);
         }
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
-        float *length = new float[nF];
+        vector<float> length(nF);
         for(int i=0;i<nF;i++)
         {
             float a0 = centers.ptr<float>(i)[0];
@@ -384,50 +356,45 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
-
-        delete []length;
     }
     //end of the function
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Function: filterCore
+ * Description: filters columns "colRange" of "I" into "outImg" with the joint-histogram framework.
+ *                Every column is scanned independently, so disjoint column ranges can be
+ *                filtered concurrently; the window only reads the neighbouring columns of "I".
+ ***************************************************************/
+void filterCore(const Mat &I, const Mat &F, const Mat &wMap, const Mat &mask, Mat &outImg,
+                const Range &colRange, int r, int nF, int nI, WMFWorkspace &ws)
 {
     // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
+    CV_DbgAssert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
+    CV_DbgAssert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
 
     // Configuration and declaration
     int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
 
-    // Handle Mask
-    if(mask.empty())
-    {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
-    }
-
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+    int *H = &ws.H[0];
+    int *BCB = &ws.BCB[0];
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+    // Links for necklace table
+    int *Hf = &ws.Hf[0];//forward link
+    int *Hb = &ws.Hb[0];//backward link
+    int *BCBf = &ws.BCBf[0];//forward link
+    int *BCBb = &ws.BCBb[0];//backward link
 
     // Column Scanning
-    for(int x=0;x<cols;x++)
+    for(int x=colRange.start;x<colRange.end;x++)
     {
-        // Reset histogram and BCB for each column
+        // Reset BCB for each column, the joint-histogram is left empty by the previous column
         memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
+        for(int i=0;i<nI;i++)Hf[i*nF]=Hb[i*nF]=0;
         BCBf[0]=BCBb[0]=0;
 
         // Reset cut-point
@@ -441,23 +408,23 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         int upY = min(rows-1,r);
         for(int i=0;i<=upY;i++)
         {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            const uchar *maskPtr = mask.ptr<uchar>(i);
 
             for(int j=downX;j<=upX;j++)
             {
                 if(!maskPtr[j])continue;
 
                 int fval = IPtr[j];
-                int *curHist = H[fval];
+                int *curHist = H + fval*nF;
                 int gval = FPtr[j];
 
                 // Maintain necklace table of joint-histogram
                 if(!curHist[gval] && gval)
                 {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
+                    int *curHf = Hf + fval*nF;
+                    int *curHb = Hb + fval*nF;
 
                     int p1=0,p2=curHf[0];
                     curHf[p1]=gval;
@@ -477,7 +444,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             // Find weighted median with help of BCB and joint-histogram
             float balanceWeight = 0;
             int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
+            const float *fPtr = wMap.ptr<float>(curIndex);
             int &curMedianVal = medianVal;
 
             // Compute current balance
@@ -496,8 +463,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                    int *nextHist = H + curMedianVal*nF;
+                    int *nextHf = Hf + curMedianVal*nF;
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -520,8 +487,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
+                    int *nextHist = H + (curMedianVal+1)*nF;
+                    int *nextHf = Hf + (curMedianVal+1)*nF;
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -554,23 +521,23 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             int rownum = y + r + 1;
             if(rownum < rows)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = H + fval*nF;
                         gval = guideImgPtr[j];
 
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = Hf + fval*nF;
+                            int *curHb = Hb + fval*nF;
 
                             int p1=0,p2=curHf[0];
                             curHf[gval]=p2;
@@ -590,16 +557,16 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 rownum = y - r;
                 if(rownum >= 0)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = H + fval*nF;
                         gval = guideImgPtr[j];
 
                         curHist[gval]--;
@@ -607,8 +574,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = Hf + fval*nF;
+                            int *curHb = Hb + fval*nF;
 
                             int p1=curHb[gval],p2=curHf[gval];
                             curHf[p1]=p2;
@@ -620,21 +587,49 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                     }
                 }
         }
+
+        // Empty the joint-histogram for the next column: only the pixels
+        // of the last window are left in it, which is much cheaper than
+        // clearing all nI x nF bins
+        for(int i=max(0,rows-r);i<rows;i++)
+        {
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+
+            for(int j=downX;j<=upX;j++)
+                H[IPtr[j]*nF + FPtr[j]] = 0;
+        }
     }
+}
+
+/***************************************************************
+ * Class: WMFInvoker
+ * Description: filters all channels of a range of column stripes.
+ *                Each stripe owns one workspace and writes its own columns of the output.
+ ***************************************************************/
+class WMFInvoker : public ParallelLoopBody
+{
+public:
+    WMFInvoker(const vector<Mat> &_Is, vector<Mat> &_outs, const Mat &_F, const Mat &_wMap,
+               const Mat &_mask, int _r, int _nF, int _nI, int _stripeWidth)
+        : Is(_Is), outs(_outs), F(_F), wMap(_wMap), mask(_mask),
+          r(_r), nF(_nF), nI(_nI), stripeWidth(_stripeWidth) {}
 
-    // Deallocate the memory
+    virtual void operator()(const Range &range) const
     {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        WMFWorkspace ws(nI, nF);
+
+        Range colRange(range.start*stripeWidth, min(range.end*stripeWidth, F.cols));
+        for(size_t i = 0; i < Is.size(); i++)
+            filterCore(Is[i], F, wMap, mask, outs[i], colRange, r, nF, nI, ws);
     }
 
-    // end of the function
-    return outImg;
-}
+private:
+    const vector<Mat> &Is;
+    vector<Mat> &outs;
+    const Mat &F, &wMap, &mask;
+    int r, nF, nI, stripeWidth;
+};
 }
 
 namespace cv
@@ -657,7 +652,7 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
         return;
     }
 
-    CV_Assert(I.depth() == CV_32F || I.depth() == CV_8U);
+    CV_Assert(I.depth() == CV_32F || I.depth() == CV_8U || I.depth() == CV_16U || I.depth() == CV_16S);
     CV_Assert(F.depth() == CV_8U && (F.channels() == 1 || F.channels() == 3));
 
     dst.create(src.size(), src.type());
@@ -670,20 +665,23 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
 
     //Preprocess I
     //OUTPUT OF THIS STEP: Is, iMap
-    //If I is floating point image, "adaptive quantization" is done in from32FTo32S.
+    //If I is a floating point or 16-bit image, "adaptive quantization" is done in from32FTo32S.
     //The mapping of floating value to integer value is stored in iMap (for each channel).
     //"Is" stores each channel of "I". The channels are converted to CV_32S type after this step.
-    vector<float *> iMap(I.channels());
+    bool quantized = I.depth() != CV_8U;
+    vector<vector<float> > iMap(I.channels());
     vector<Mat> Is;
     split(I,Is);
     for(int i=0;i<(int)Is.size();i++)
     {
-        if(I.depth() == CV_32F)
+        if(quantized)
         {
-            iMap[i] = new float[nI];
-            from32FTo32S(Is[i],Is[i],nI,iMap[i]);
+            iMap[i].resize(nI);
+            if(I.depth() != CV_32F)
+                Is[i].convertTo(Is[i],CV_32F);
+            from32FTo32S(Is[i],Is[i],nI,&iMap[i][0]);
         }
-        else if(I.depth() == CV_8U)
+        else
         {
             Is[i].convertTo(Is[i],CV_32S);
         }
@@ -694,28 +692,40 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //If "F" is 3-channel image, "clustering feature image" is done in featureIndexing.
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
     //The output "F" is CV_32S type, containing indexes of feature values.
-    //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
+    //"wMap" is a nF x nF matrix that defines the distance between each pair of feature indexes.
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    Mat wMap;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
+    //Handle mask
+    Mat M = mask.getMat();
+    if(M.empty())
+        M = Mat(I.size(), CV_8U, Scalar(1));
+    CV_Assert(M.size() == I.size() && M.type() == CV_8UC1);
+
     //Filtering - Joint-Histogram Framework
+    //Columns are filtered independently, so stripes of columns are processed in parallel.
+    //Pixels without a weighted median (e.g. masked out neighbourhood) keep their input values.
+    vector<Mat> outs(Is.size());
     for(int i=0; i<(int)Is.size(); i++)
-    {
-        Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
-    }
-    float2D_release(wMap);
+        outs[i] = Is[i].clone();
+
+    const int stripeWidth = 32;
+    parallel_for_(Range(0, (I.cols + stripeWidth - 1)/stripeWidth),
+                  WMFInvoker(Is, outs, F, wMap, M, r, nF, nI, stripeWidth));
+    Is.swap(outs);
 
     //Postprocess F
     //Convert input image back to the original type.
     for(int i = 0; i < (int)Is.size(); i++)
     {
-        if(I.depth()==CV_32F)
+        if(quantized)
         {
-            from32STo32F(Is[i],Is[i],iMap[i]);
-            delete []iMap[i];
+            from32STo32F(Is[i],Is[i],&iMap[i][0]);
+            if(I.depth() != CV_32F)
+                Is[i].convertTo(Is[i],I.depth());
         }
-        else if(I.depth()==CV_8U)
+        else
         {
             Is[i].convertTo(Is[i],CV_8U);
         }
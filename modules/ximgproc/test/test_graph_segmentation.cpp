@@ -0,0 +1,171 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+namespace {
+
+struct RefEdge
+{
+    int from, to;
+    float weight;
+};
+
+static bool weightLess(const RefEdge& a, const RefEdge& b)
+{
+    return a.weight < b.weight;
+}
+
+static int findRoot(std::vector<int>& parents, int p)
+{
+    int root = p;
+    while (parents[root] != root)
+        root = parents[root];
+    parents[p] = root;
+    return root;
+}
+
+static void joinRoots(std::vector<int>& parents, std::vector<int>& sizes, int a, int b)
+{
+    if (sizes[a] < sizes[b])
+        std::swap(a, b);
+    parents[b] = a;
+    sizes[a] += sizes[b];
+}
+
+// Straightforward Felzenszwalb-Huttenlocher segmentation with one Edge object per pixel pair. The edges are
+// created row by row, the right ones and then the bottom ones, and sorted stably: this is the order equal
+// weights are processed in
+static void referenceSegmentation(const Mat& img, double sigma, float k, int min_size, Mat& labels)
+{
+    Mat img_float, filtered;
+    img.convertTo(img_float, CV_32F);
+    GaussianBlur(img_float, filtered, Size(0, 0), sigma, sigma);
+
+    const int rows = filtered.rows, cols = filtered.cols, cn = filtered.channels();
+    std::vector<RefEdge> edges;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int direction = 0; direction < 2; direction++)
+        {
+            int i2 = i + direction;
+            if (i2 >= rows)
+                continue;
+            for (int j = 0; j < cols; j++)
+            {
+                int j2 = j + 1 - direction;
+                if (j2 >= cols)
+                    continue;
+                const float* a = filtered.ptr<float>(i) + j * cn;
+                const float* b = filtered.ptr<float>(i2) + j2 * cn;
+                float total = 0;
+                for (int c = 0; c < cn; c++)
+                {
+                    float diff = a[c] - b[c];
+                    total += diff * diff;
+                }
+                RefEdge e = { i * cols + j, i2 * cols + j2, std::sqrt(total) };
+                edges.push_back(e);
+            }
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end(), weightLess);
+
+    std::vector<int> parents(rows * cols), sizes(rows * cols, 1);
+    std::vector<float> thresholds(rows * cols, k);
+    for (int p = 0; p < rows * cols; p++)
+        parents[p] = p;
+
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        int a = findRoot(parents, edges[e].from), b = findRoot(parents, edges[e].to);
+        if (a != b && edges[e].weight <= thresholds[a] && edges[e].weight <= thresholds[b])
+        {
+            joinRoots(parents, sizes, a, b);
+            a = findRoot(parents, a);
+            thresholds[a] = edges[e].weight + k / sizes[a];
+        }
+    }
+
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        int a = findRoot(parents, edges[e].from), b = findRoot(parents, edges[e].to);
+        if (a != b && (sizes[a] < min_size || sizes[b] < min_size))
+            joinRoots(parents, sizes, a, b);
+    }
+
+    // the regions are numbered in the order of their first pixel
+    labels.create(rows, cols, CV_32SC1);
+    std::vector<int> ids(rows * cols, -1);
+    int last_id = 0;
+    for (int p = 0; p < rows * cols; p++)
+    {
+        int root = findRoot(parents, p);
+        if (ids[root] < 0)
+            ids[root] = last_id++;
+        labels.at<int>(p / cols, p % cols) = ids[root];
+    }
+}
+
+static void checkSegmentation(const Mat& img, double sigma, float k, int min_size)
+{
+    Mat labels, ref;
+    createGraphSegmentation(sigma, k, min_size)->processImage(img, labels);
+    referenceSegmentation(img, sigma, k, min_size, ref);
+
+    ASSERT_EQ(CV_32SC1, labels.type());
+    ASSERT_EQ(ref.size(), labels.size());
+    EXPECT_EQ(0, countNonZero(ref != labels));
+}
+
+TEST(ximgproc_GraphSegmentation, same_as_reference)
+{
+    RNG rng(0);
+    Mat img(60, 83, CV_8UC3, Scalar(40, 160, 90));
+    for (int i = 0; i < 12; i++)
+    {
+        Point center(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        circle(img, center, rng.uniform(4, 20), Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)), -1);
+    }
+    Mat noise(img.size(), CV_16SC3);
+    rng.fill(noise, RNG::NORMAL, 0, 8);
+    add(img, noise, img, noArray(), CV_8U);
+
+    checkSegmentation(img, 0.5, 300, 50);
+    checkSegmentation(img, 0.8, 100, 20);
+
+    Mat gray;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+    checkSegmentation(gray, 0.5, 200, 30);
+}
+
+TEST(ximgproc_GraphSegmentation, ties)
+{
+    // blocks of a three colors palette without smoothing, most edge weights are equal
+    RNG rng(1);
+    const Vec3b palette[] = { Vec3b(0, 0, 0), Vec3b(64, 64, 64), Vec3b(0, 128, 0) };
+    Mat img(48, 67, CV_8UC3);
+    for (int i = 0; i < img.rows; i++)
+        for (int j = 0; j < img.cols; j++)
+            img.at<Vec3b>(i, j) = palette[((i / 3) * 7 + (j / 4) * 3 + rng.uniform(0, 2) * ((i + j) % 5 == 0)) % 3];
+
+    checkSegmentation(img, 0.001, 100, 1);
+    checkSegmentation(img, 0.001, 100, 10);
+    checkSegmentation(img, 0.001, 5000, 40);
+
+    // the ties don't depend on how the rows of the graph are split between the threads
+    Mat labels, labels_single;
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.001, 100, 10);
+    gs->processImage(img, labels);
+    int threads = getNumThreads();
+    setNumThreads(1);
+    gs->processImage(img, labels_single);
+    setNumThreads(threads);
+    EXPECT_EQ(0, countNonZero(labels != labels_single));
+}
+
+}
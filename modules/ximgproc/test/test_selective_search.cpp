@@ -0,0 +1,230 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+namespace {
+
+// Overlapping blocks of different colors with noise, so that equal similarities are unlikely
+static Mat createTestImage()
+{
+    RNG rng(0);
+    Mat img(96, 128, CV_8UC3, Scalar(90, 120, 150));
+    for (int i = 0; i < 16; i++)
+    {
+        Point p1(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Point p2(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            rectangle(img, p1, p2, color, -1);
+        else
+            circle(img, p1, rng.uniform(5, 30), color, -1);
+    }
+
+    Mat noise(img.size(), CV_16SC3);
+    rng.fill(noise, RNG::NORMAL, 0, 6);
+    add(img, noise, img, noArray(), CV_8U);
+    return img;
+}
+
+static Ptr<SelectiveSearchSegmentationStrategy> createAllStrategies()
+{
+    return createSelectiveSearchSegmentationStrategyMultiple(
+        createSelectiveSearchSegmentationStrategyColor(), createSelectiveSearchSegmentationStrategyFill(),
+        createSelectiveSearchSegmentationStrategyTexture(), createSelectiveSearchSegmentationStrategySize());
+}
+
+struct Pair
+{
+    int from, to;
+    float similarity;
+
+    bool operator<(const Pair& p) const { return similarity < p.similarity; }
+};
+
+// Hierarchical grouping as it was done before the priority queue: dense neighbour matrix, the similarities
+// sorted after every merge and the pairs of the merged regions erased from them
+static void referenceGrouping(const Mat& img, const Mat& img_regions, Ptr<SelectiveSearchSegmentationStrategy> s, std::vector<Rect>& rects)
+{
+    double min, max;
+    minMaxLoc(img_regions, &min, &max);
+    int nb_segs = (int)max + 1;
+
+    Mat_<char> is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
+    Mat sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+    std::vector<std::vector<Point> > points(nb_segs);
+
+    for (int i = 0; i < img_regions.rows; i++)
+    {
+        const int* p = img_regions.ptr<int>(i);
+        for (int j = 0; j < img_regions.cols; j++)
+        {
+            points[p[j]].push_back(Point(j, i));
+            sizes.at<int>(p[j]) += 1;
+
+            if (i > 0 && j > 0)
+            {
+                const int* previous_p = img_regions.ptr<int>(i - 1);
+                const int others[] = { p[j - 1], previous_p[j], previous_p[j - 1] };
+                for (int k = 0; k < 3; k++)
+                    is_neighbour(p[j], others[k]) = is_neighbour(others[k], p[j]) = 1;
+            }
+        }
+    }
+
+    // the sizes are shared with the strategy, which sees the merged ones
+    s->setImage(img, img_regions, sizes);
+
+    std::vector<int> ids;
+    std::vector<Pair> similarities;
+    rects.clear();
+
+    for (int i = 0; i < nb_segs; i++)
+    {
+        ids.push_back(i);
+        rects.push_back(boundingRect(points[i]));
+
+        for (int j = i + 1; j < nb_segs; j++)
+        {
+            if (is_neighbour(i, j))
+            {
+                Pair n = { i, j, s->get(i, j) };
+                similarities.push_back(n);
+            }
+        }
+    }
+
+    while (!similarities.empty())
+    {
+        std::sort(similarities.begin(), similarities.end());
+        Pair p = similarities.back();
+        similarities.pop_back();
+
+        int id_from = ids[p.from], id_to = ids[p.to];
+        ids.push_back(std::min(id_from, id_to));
+        rects.push_back(rects[p.from] | rects[p.to]);
+
+        s->merge(id_from, id_to);
+        sizes.at<int>(id_from) += sizes.at<int>(id_to);
+        sizes.at<int>(id_to) = sizes.at<int>(id_from);
+
+        std::vector<int> local_neighbours;
+        for (std::vector<Pair>::iterator n = similarities.begin(); n != similarities.end();)
+        {
+            if (n->from == p.from || n->to == p.from || n->from == p.to || n->to == p.to)
+            {
+                int other = (n->from == p.from || n->from == p.to) ? n->to : n->from;
+                if (std::find(local_neighbours.begin(), local_neighbours.end(), other) == local_neighbours.end())
+                    local_neighbours.push_back(other);
+                n = similarities.erase(n);
+            }
+            else
+                ++n;
+        }
+
+        int new_region = (int)ids.size() - 1;
+        for (size_t k = 0; k < local_neighbours.size(); k++)
+        {
+            Pair n = { new_region, local_neighbours[k], s->get(ids[new_region], ids[local_neighbours[k]]) };
+            similarities.push_back(n);
+        }
+    }
+}
+
+static bool rectLess(const Rect& a, const Rect& b)
+{
+    if (a.x != b.x) return a.x < b.x;
+    if (a.y != b.y) return a.y < b.y;
+    if (a.width != b.width) return a.width < b.width;
+    return a.height < b.height;
+}
+
+static void sortUnique(std::vector<Rect>& rects)
+{
+    std::sort(rects.begin(), rects.end(), rectLess);
+    rects.erase(std::unique(rects.begin(), rects.end()), rects.end());
+}
+
+TEST(ximgproc_SelectiveSearch, same_proposals_as_sorted_grouping)
+{
+    Mat img = createTestImage();
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.8, 100, 20);
+
+    Mat img_regions;
+    gs->processImage(img, img_regions);
+    double min, max;
+    minMaxLoc(img_regions, &min, &max);
+    ASSERT_GT(max, 10);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->addImage(img);
+    ss->addGraphSegmentation(gs);
+    ss->addStrategy(createAllStrategies());
+
+    std::vector<Rect> rects, ref;
+    ss->process(rects);
+    referenceGrouping(img, img_regions, createAllStrategies(), ref);
+
+    // the proposals are ordered by random ranks, so compare them as sets
+    sortUnique(rects);
+    sortUnique(ref);
+    ASSERT_EQ(ref.size(), rects.size());
+    for (size_t i = 0; i < ref.size(); i++)
+        EXPECT_EQ(ref[i], rects[i]);
+}
+
+TEST(ximgproc_SelectiveSearch, color_histograms_as_calcHist)
+{
+    Mat img = createTestImage();
+    Mat img_regions;
+    createGraphSegmentation(0.8, 100, 20)->processImage(img, img_regions);
+
+    double min, max;
+    minMaxLoc(img_regions, &min, &max);
+    int nb_segs = (int)max + 1;
+
+    Mat sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+    for (int i = 0; i < img_regions.rows; i++)
+        for (int j = 0; j < img_regions.cols; j++)
+            sizes.at<int>(img_regions.at<int>(i, j)) += 1;
+
+    Ptr<SelectiveSearchSegmentationStrategy> color = createSelectiveSearchSegmentationStrategyColor();
+    color->setImage(img, img_regions, sizes);
+
+    // normalized masked histograms of 25 bins per channel
+    std::vector<Mat> planes;
+    split(img, planes);
+    int bins = 25;
+    float range[] = { 0, 256 };
+    const float* ranges = range;
+
+    Mat histograms(nb_segs, bins * img.channels(), CV_32F);
+    for (int r = 0; r < nb_segs; r++)
+    {
+        Mat mask = img_regions == r;
+        for (int c = 0; c < img.channels(); c++)
+        {
+            Mat hist;
+            calcHist(&planes[c], 1, 0, mask, hist, 1, &bins, &ranges);
+            hist.reshape(1, 1).copyTo(histograms.row(r).colRange(c * bins, (c + 1) * bins));
+        }
+        Mat histogram = histograms.row(r);
+        histogram /= sum(histogram)[0];
+    }
+
+    for (int r1 = 0; r1 < nb_segs; r1++)
+    {
+        for (int r2 = r1 + 1; r2 < nb_segs; r2++)
+        {
+            Mat intersection;
+            cv::min(histograms.row(r1), histograms.row(r2), intersection);
+            EXPECT_NEAR(sum(intersection)[0], color->get(r1, r2), 1e-5) << r1 << " " << r2;
+        }
+    }
+}
+
+}
@@ -0,0 +1,188 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+namespace {
+
+// Colored blocks with noise, 120x96 so that the tiles of the tests below fit exactly
+static Mat createFrame()
+{
+    RNG rng(0);
+    Mat img(96, 120, CV_8UC3, Scalar(70, 110, 150));
+    for (int i = 0; i < 10; i++)
+    {
+        Point p1(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Point p2(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        rectangle(img, p1, p2, Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)), -1);
+    }
+
+    Mat noise(img.size(), CV_16SC3);
+    rng.fill(noise, RNG::NORMAL, 0, 4);
+    add(img, noise, img, noArray(), CV_8U);
+    return img;
+}
+
+// The next frame, where only the pixels of tile differ
+static Mat changeTile(const Mat& img, Rect tile)
+{
+    Mat next = img.clone();
+    Mat roi = next(tile);
+    bitwise_not(roi, roi);
+    return next;
+}
+
+static void expectChangedOnlyInside(const Mat& before, const Mat& after, Rect tile)
+{
+    ASSERT_EQ(before.size(), after.size());
+    Mat changed = before != after;
+    changed(tile).setTo(0);
+    EXPECT_EQ(0, countNonZero(changed));
+}
+
+TEST(ximgproc_SuperpixelSLIC, iterateNextFrame)
+{
+    Mat img = createFrame();
+    const int algorithms[] = { SLIC, SLICO };
+    for (int a = 0; a < 2; a++)
+    {
+        Ptr<SuperpixelSLIC> slic = createSuperpixelSLIC(img, algorithms[a], 12);
+        slic->iterate(5);
+
+        Mat labels, next_labels;
+        slic->getLabels(labels);
+        labels = labels.clone();
+
+        slic->iterateNextFrame(img);
+        slic->getLabels(next_labels);
+        EXPECT_EQ(0, countNonZero(labels != next_labels)) << "algorithm " << algorithms[a];
+
+        Rect tile(36, 24, 12, 12);
+        slic->iterateNextFrame(changeTile(img, tile));
+        slic->getLabels(next_labels);
+        expectChangedOnlyInside(labels, next_labels, tile);
+
+        Mat gray, img16;
+        cvtColor(img, gray, COLOR_BGR2GRAY);
+        img.convertTo(img16, CV_16U);
+        EXPECT_ANY_THROW(slic->iterateNextFrame(img(Rect(0, 0, 60, 48)).clone()));
+        EXPECT_ANY_THROW(slic->iterateNextFrame(gray));
+        EXPECT_ANY_THROW(slic->iterateNextFrame(img16));
+    }
+}
+
+TEST(ximgproc_SuperpixelLSC, iterateNextFrame)
+{
+    Mat img = createFrame();
+    Ptr<SuperpixelLSC> lsc = createSuperpixelLSC(img, 12);
+    lsc->iterate(5);
+
+    Mat labels, next_labels;
+    lsc->getLabels(labels);
+    labels = labels.clone();
+
+    lsc->iterateNextFrame(img);
+    lsc->getLabels(next_labels);
+    EXPECT_EQ(0, countNonZero(labels != next_labels));
+
+    Rect tile(60, 48, 12, 12);
+    lsc->iterateNextFrame(changeTile(img, tile));
+    lsc->getLabels(next_labels);
+    expectChangedOnlyInside(labels, next_labels, tile);
+
+    Mat gray, img16;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+    img.convertTo(img16, CV_16U);
+    EXPECT_ANY_THROW(lsc->iterateNextFrame(img(Rect(0, 0, 60, 48)).clone()));
+    EXPECT_ANY_THROW(lsc->iterateNextFrame(gray));
+    EXPECT_ANY_THROW(lsc->iterateNextFrame(img16));
+}
+
+TEST(ximgproc_SuperpixelSEEDS, iterateNextFrame)
+{
+    // 20 superpixels in a 5x4 grid of 24x24 tiles
+    Mat img = createFrame();
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 20, 4);
+    seeds->iterate(img);
+
+    Mat labels, next_labels;
+    seeds->getLabels(labels);
+    labels = labels.clone();
+
+    seeds->iterateNextFrame(img);
+    seeds->getLabels(next_labels);
+    EXPECT_EQ(0, countNonZero(labels != next_labels));
+
+    Rect tile(24, 24, 24, 24);
+    seeds->iterateNextFrame(changeTile(img, tile));
+    seeds->getLabels(next_labels);
+    expectChangedOnlyInside(labels, next_labels, tile);
+
+    Mat gray, img16;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+    img.convertTo(img16, CV_16U, 256);
+    EXPECT_ANY_THROW(seeds->iterateNextFrame(img(Rect(0, 0, 60, 48)).clone()));
+    EXPECT_ANY_THROW(seeds->iterateNextFrame(gray));
+    EXPECT_ANY_THROW(seeds->iterateNextFrame(img16));
+}
+
+TEST(ximgproc_SuperpixelSEEDS, iterateNextFrame_boundary_on_tile_edge)
+{
+    // the quadrants meet at the bottom right corner of the tile, so superpixel boundaries
+    // follow its right and bottom edges
+    Rect tile(24, 24, 24, 24);
+    Mat img(96, 120, CV_8UC3);
+    img(Rect(0, 0, 48, 48)).setTo(Scalar(40, 40, 40));
+    img(Rect(48, 0, 72, 48)).setTo(Scalar(200, 60, 60));
+    img(Rect(0, 48, 48, 48)).setTo(Scalar(60, 200, 60));
+    img(Rect(48, 48, 72, 48)).setTo(Scalar(60, 60, 200));
+    RNG rng(0);
+    Mat noise(img.size(), CV_16SC3);
+    rng.fill(noise, RNG::NORMAL, 0, 4);
+    add(img, noise, img, noArray(), CV_8U);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 20, 4);
+    seeds->iterate(img);
+
+    Mat labels, next_labels;
+    seeds->getLabels(labels);
+    labels = labels.clone();
+    ASSERT_GT(countNonZero(labels(Rect(47, 24, 1, 24)) != labels(Rect(48, 24, 1, 24))), 0);
+    ASSERT_GT(countNonZero(labels(Rect(24, 47, 24, 1)) != labels(Rect(24, 48, 24, 1))), 0);
+
+    // the tile takes the colors on the other side of its edges, the pixels there
+    // would join the superpixel of the tile if they weren't masked out
+    Mat next = img.clone();
+    img(Rect(48, 48, 24, 24)).copyTo(next(tile));
+    seeds->iterateNextFrame(next, 4);
+    seeds->getLabels(next_labels);
+    expectChangedOnlyInside(labels, next_labels, tile);
+}
+
+TEST(ximgproc_SuperpixelSEEDS, parallel_block_updates)
+{
+    Mat img = createFrame();
+    for (int double_step = 0; double_step < 2; double_step++)
+    {
+        Mat labels, labels_single;
+        Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 20, 4, 2, 5, double_step != 0);
+        seeds->iterate(img);
+        seeds->getLabels(labels);
+        labels = labels.clone();
+
+        int threads = getNumThreads();
+        setNumThreads(1);
+        seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 20, 4, 2, 5, double_step != 0);
+        seeds->iterate(img);
+        seeds->getLabels(labels_single);
+        setNumThreads(threads);
+
+        EXPECT_EQ(0, countNonZero(labels != labels_single)) << "double_step " << double_step;
+    }
+}
+
+}
@@ -112,6 +112,40 @@ TEST(WeightedMedianFilterTest, mask_zeros_no_crash)
     EXPECT_EQ(cv::norm(img, filtered, NORM_INF), 0.0);
 }
 
+TEST(WeightedMedianFilterTest, SplatSurfaceAccuracy16U)
+{
+    RNG rnd(0);
+
+    Mat guide(szODD, CV_8UC3);
+    randu(guide, 0, 255);
+
+    Mat src(szODD, CV_16UC1, Scalar(rnd.uniform(0, 65536)));
+
+    Mat res;
+    weightedMedianFilter(guide, src, res, 15, 25.5, WMF_EXP);
+
+    ASSERT_EQ(res.type(), src.type());
+    EXPECT_EQ(cvtest::norm(src, res, NORM_INF), 0.0);
+}
+
+TEST(WeightedMedianFilterTest, ResultDoesNotDependOnThreads)
+{
+    Mat guide(szQVGA, CV_8UC1), src(szQVGA, CV_32FC1);
+    randu(guide, 0, 255);
+    randu(src, 0.0f, 1.0f);
+
+    int numThreads = cv::getNumThreads();
+
+    Mat resSingle, resMulti;
+    cv::setNumThreads(1);
+    weightedMedianFilter(guide, src, resSingle, 9);
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    weightedMedianFilter(guide, src, resMulti, 9);
+    cv::setNumThreads(numThreads);
+
+    EXPECT_EQ(cvtest::norm(resSingle, resMulti, NORM_INF), 0.0);
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSET, WeightedMedianFilterTest, Combine(Values(szODD, szQVGA),  Values(WMF_EXP, WMF_IV2, WMF_OFF)));
 
 }